@@ -37,7 +37,8 @@ struct InterpretedBenchmarkState : public BenchmarkState {
 	Connection con;
 	unique_ptr<MaterializedQueryResult> result;
 
-	InterpretedBenchmarkState() : db(nullptr), con(db) {
+	// an in-memory database with a temporary directory, so benchmarks with a memory limit can spill to disk
+	InterpretedBenchmarkState() : db(":memory:"), con(db) {
 		con.EnableProfiling();
 	}
 };
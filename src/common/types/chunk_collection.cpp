@@ -5,10 +5,10 @@
 #include "duckdb/common/value_operations/value_operations.hpp"
 #include "duckdb/common/operator/comparison_operators.hpp"
 #include "duckdb/common/assert.hpp"
+#include "duckdb/common/types/sort_key.hpp"
 
 #include <algorithm>
 #include <cstring>
-#include <queue>
 
 namespace duckdb {
 
@@ -216,115 +216,36 @@ static int compare_tuple(ChunkCollection *sort_by, vector<OrderType> &desc, vect
 	return 0;
 }
 
-static int64_t _quicksort_initial(ChunkCollection *sort_by, vector<OrderType> &desc,
-                                  vector<OrderByNullType> &null_order, idx_t *result) {
-	// select pivot
-	int64_t pivot = 0;
-	int64_t low = 0, high = sort_by->Count() - 1;
-	// now insert elements
-	for (idx_t i = 1; i < sort_by->Count(); i++) {
-		if (compare_tuple(sort_by, desc, null_order, i, pivot) <= 0) {
-			result[low++] = i;
-		} else {
-			result[high--] = i;
-		}
-	}
-	D_ASSERT(low == high);
-	result[low] = pivot;
-	return low;
-}
-
-struct QuicksortInfo {
-	QuicksortInfo(int64_t left_, int64_t right_) : left(left_), right(right_) {
-	}
-
-	int64_t left;
-	int64_t right;
-};
-
-struct QuicksortStack {
-	std::queue<QuicksortInfo> info_queue;
-
-	QuicksortInfo Pop() {
-		auto element = info_queue.front();
-		info_queue.pop();
-		return element;
-	}
-
-	bool IsEmpty() {
-		return info_queue.empty();
-	}
-
-	void Enqueue(int64_t left, int64_t right) {
-		if (left >= right) {
-			return;
-		}
-		info_queue.emplace(left, right);
-	}
-};
-
-static void _quicksort_inplace(ChunkCollection *sort_by, vector<OrderType> &desc, vector<OrderByNullType> &null_order,
-                               idx_t *result, QuicksortInfo info, QuicksortStack &stack) {
-	auto left = info.left;
-	auto right = info.right;
-
-	D_ASSERT(left < right);
-
-	int64_t middle = left + (right - left) / 2;
-	int64_t pivot = result[middle];
-	// move the mid point value to the front.
-	int64_t i = left + 1;
-	int64_t j = right;
-
-	std::swap(result[middle], result[left]);
-	bool all_equal = true;
-	while (i <= j) {
-		if (result)
-			while (i <= j) {
-				int cmp = compare_tuple(sort_by, desc, null_order, result[i], pivot);
-				if (cmp < 0) {
-					all_equal = false;
-				} else if (cmp > 0) {
-					all_equal = false;
-					break;
-				}
-				i++;
-			}
-
-		while (i <= j && compare_tuple(sort_by, desc, null_order, result[j], pivot) > 0) {
-			j--;
-		}
-
-		if (i < j) {
-			std::swap(result[i], result[j]);
-		}
-	}
-	std::swap(result[i - 1], result[left]);
-	int64_t part = i - 1;
-
-	if (all_equal) {
-		return;
-	}
-
-	stack.Enqueue(left, part - 1);
-	stack.Enqueue(part + 1, right);
-}
-
 void ChunkCollection::Sort(vector<OrderType> &desc, vector<OrderByNullType> &null_order, idx_t result[]) {
 	D_ASSERT(result);
 	if (count == 0) {
 		return;
 	}
-	// start off with an initial quicksort
-	int64_t part = _quicksort_initial(this, desc, null_order, result);
-
-	// now continuously perform
-	QuicksortStack stack;
-	stack.Enqueue(0, part);
-	stack.Enqueue(part + 1, count - 1);
-	while (!stack.IsEmpty()) {
-		auto element = stack.Pop();
-		_quicksort_inplace(this, desc, null_order, result, element, stack);
+	// encode the sort columns into memcmp-comparable keys
+	vector<LogicalType> key_types(types.begin(), types.begin() + desc.size());
+	SortKeyEncoder encoder(move(key_types), desc, null_order);
+	auto key_width = encoder.key_width;
+	auto keys = unique_ptr<data_t[]>(new data_t[count * key_width]);
+	for (idx_t chunk_idx = 0; chunk_idx < chunks.size(); chunk_idx++) {
+		encoder.Encode(*chunks[chunk_idx], keys.get() + chunk_idx * STANDARD_VECTOR_SIZE * key_width, key_width);
+	}
+	for (idx_t i = 0; i < count; i++) {
+		result[i] = i;
+	}
+	// now sort the row indices by their keys
+	auto key_data = keys.get();
+	if (!encoder.HasTieBreaker()) {
+		encoder.SortKeys(key_data, result, count);
+	} else {
+		vector<vector<VectorData>> chunk_data(chunks.size());
+		for (idx_t chunk_idx = 0; chunk_idx < chunks.size(); chunk_idx++) {
+			encoder.OrrifyTieColumns(*chunks[chunk_idx], chunk_data[chunk_idx]);
+		}
+		std::sort(result, result + count, [&](const idx_t &left, const idx_t &right) {
+			return encoder.Compare(key_data + left * key_width, key_data + right * key_width,
+			                       chunk_data[left / STANDARD_VECTOR_SIZE], left % STANDARD_VECTOR_SIZE,
+			                       chunk_data[right / STANDARD_VECTOR_SIZE], right % STANDARD_VECTOR_SIZE) < 0;
+		});
 	}
 }
 
@@ -0,0 +1,159 @@
+#include "duckdb/common/types/hyperloglog.hpp"
+#include "duckdb/common/algorithm.hpp"
+#include "duckdb/common/serializer.hpp"
+
+#include <cmath>
+
+namespace duckdb {
+
+HyperLogLog::HyperLogLog() {
+}
+
+//! Mix the bits of the hash, so that both the register and its value depend on all the bits of the hash
+static inline uint64_t MixHash(uint64_t hash) {
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xff51afd7ed558ccd);
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+	hash ^= hash >> 33;
+	return hash;
+}
+
+//! Returns the amount of leading zero bits of a non-zero value
+static inline uint8_t CountLeadingZeros(uint64_t value) {
+	D_ASSERT(value != 0);
+#if defined(__GNUC__) || defined(__clang__)
+	return uint8_t(__builtin_clzll(value));
+#else
+	uint8_t count = 0;
+	while (!(value & (uint64_t(1) << 63))) {
+		value <<= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+void HyperLogLog::Add(hash_t hash) {
+	hash = MixHash(hash);
+	// the first PRECISION bits select the register
+	auto index = uint32_t(hash >> (64 - PRECISION));
+	// the value is the position of the first set bit in the remaining bits, the sentinel bit bounds it
+	uint64_t remaining = (hash << PRECISION) | (uint64_t(1) << (PRECISION - 1));
+	AddToRegister(index, CountLeadingZeros(remaining) + 1);
+}
+
+void HyperLogLog::AddToRegister(uint32_t index, uint8_t value) {
+	if (!IsSparse()) {
+		registers[index] = MaxValue(registers[index], value);
+		return;
+	}
+	sparse_entries.push_back(index << 8 | value);
+	if (sparse_entries.size() >= 2 * MAX_SPARSE_ENTRIES) {
+		CompactSparse();
+	}
+}
+
+static void CompactEntries(vector<uint32_t> &entries) {
+	// sorting places the entries of a register next to each other ordered by their value: keep the last one
+	sort(entries.begin(), entries.end());
+	idx_t count = 0;
+	for (idx_t i = 0; i < entries.size(); i++) {
+		if (count > 0 && (entries[count - 1] >> 8) == (entries[i] >> 8)) {
+			entries[count - 1] = entries[i];
+		} else {
+			entries[count++] = entries[i];
+		}
+	}
+	entries.resize(count);
+}
+
+void HyperLogLog::CompactSparse() {
+	CompactEntries(sparse_entries);
+	if (sparse_entries.size() > MAX_SPARSE_ENTRIES) {
+		ToDense();
+	}
+}
+
+void HyperLogLog::ToDense() {
+	D_ASSERT(IsSparse());
+	registers.resize(REGISTER_COUNT, 0);
+	for (auto &entry : sparse_entries) {
+		auto index = entry >> 8;
+		registers[index] = MaxValue(registers[index], uint8_t(entry & 0xFF));
+	}
+	vector<uint32_t>().swap(sparse_entries);
+}
+
+void HyperLogLog::Merge(const HyperLogLog &other) {
+	if (other.IsSparse()) {
+		for (auto &entry : other.sparse_entries) {
+			AddToRegister(entry >> 8, uint8_t(entry & 0xFF));
+		}
+		return;
+	}
+	if (IsSparse()) {
+		ToDense();
+	}
+	for (idx_t i = 0; i < REGISTER_COUNT; i++) {
+		registers[i] = MaxValue(registers[i], other.registers[i]);
+	}
+}
+
+idx_t HyperLogLog::Count() const {
+	// compute the harmonic mean of 2^value over all registers, the registers that were never set have value 0
+	double sum = 0;
+	idx_t zero_registers = 0;
+	if (IsSparse()) {
+		auto entries = sparse_entries;
+		CompactEntries(entries);
+		for (auto &entry : entries) {
+			sum += std::ldexp(1.0, -int(entry & 0xFF));
+		}
+		zero_registers = REGISTER_COUNT - entries.size();
+		sum += zero_registers;
+	} else {
+		for (auto &value : registers) {
+			sum += std::ldexp(1.0, -int(value));
+			if (value == 0) {
+				zero_registers++;
+			}
+		}
+	}
+	const double m = REGISTER_COUNT;
+	const double alpha = 0.7213 / (1.0 + 1.079 / m);
+	double estimate = alpha * m * m / sum;
+	if (estimate <= 2.5 * m && zero_registers > 0) {
+		// small cardinalities: use linear counting on the registers that were never set
+		estimate = m * std::log(m / double(zero_registers));
+	}
+	return idx_t(std::llround(estimate));
+}
+
+void HyperLogLog::Serialize(Serializer &serializer) const {
+	serializer.Write<bool>(IsSparse());
+	if (!IsSparse()) {
+		serializer.WriteData(registers.data(), REGISTER_COUNT);
+		return;
+	}
+	auto entries = sparse_entries;
+	CompactEntries(entries);
+	serializer.Write<uint32_t>(entries.size());
+	serializer.WriteData((const_data_ptr_t)entries.data(), entries.size() * sizeof(uint32_t));
+}
+
+unique_ptr<HyperLogLog> HyperLogLog::Deserialize(Deserializer &source) {
+	auto result = make_unique<HyperLogLog>();
+	auto sparse = source.Read<bool>();
+	if (!sparse) {
+		result->registers.resize(REGISTER_COUNT);
+		source.ReadData(result->registers.data(), REGISTER_COUNT);
+		return result;
+	}
+	auto entry_count = source.Read<uint32_t>();
+	result->sparse_entries.resize(entry_count);
+	source.ReadData((data_ptr_t)result->sparse_entries.data(), entry_count * sizeof(uint32_t));
+	return result;
+}
+
+} // namespace duckdb
@@ -0,0 +1,304 @@
+#include "duckdb/common/types/sort_key.hpp"
+
+#include "duckdb/common/exception.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace duckdb {
+
+static idx_t GetEncodedWidth(PhysicalType type) {
+	switch (type) {
+	case PhysicalType::BOOL:
+	case PhysicalType::INT8:
+	case PhysicalType::INT16:
+	case PhysicalType::INT32:
+	case PhysicalType::INT64:
+	case PhysicalType::INT128:
+	case PhysicalType::FLOAT:
+	case PhysicalType::DOUBLE:
+		return GetTypeIdSize(type);
+	case PhysicalType::VARCHAR:
+		return SortKeyEncoder::STRING_PREFIX_LENGTH;
+	case PhysicalType::INTERVAL:
+		// intervals are compared on their normalized value: only the NULL byte is encoded
+		return 0;
+	default:
+		throw NotImplementedException("Unimplemented type for sort key");
+	}
+}
+
+SortKeyEncoder::SortKeyEncoder(vector<LogicalType> types_p, vector<OrderType> order_types_p,
+                               vector<OrderByNullType> null_orders_p)
+    : types(move(types_p)), order_types(move(order_types_p)), null_orders(move(null_orders_p)), key_width(0) {
+	D_ASSERT(types.size() == order_types.size() && types.size() == null_orders.size());
+	for (idx_t col_idx = 0; col_idx < types.size(); col_idx++) {
+		auto internal_type = types[col_idx].InternalType();
+		offsets.push_back(key_width);
+		key_width += 1 + GetEncodedWidth(internal_type);
+		if (internal_type == PhysicalType::VARCHAR || internal_type == PhysicalType::INTERVAL) {
+			tie_columns.push_back(col_idx);
+		}
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// Encode
+//===--------------------------------------------------------------------===//
+template <class T> static inline void EncodeUnsigned(T value, data_ptr_t target) {
+	// store big-endian so that memcmp orders the keys
+	for (idx_t i = 0; i < sizeof(T); i++) {
+		target[i] = (value >> ((sizeof(T) - 1 - i) * 8)) & 0xFF;
+	}
+}
+
+template <class T> struct SortKeyOperation {
+	static inline void Operation(T value, data_ptr_t target);
+};
+
+template <> inline void SortKeyOperation<bool>::Operation(bool value, data_ptr_t target) {
+	target[0] = value ? 1 : 0;
+}
+
+template <> inline void SortKeyOperation<int8_t>::Operation(int8_t value, data_ptr_t target) {
+	EncodeUnsigned<uint8_t>((uint8_t)value ^ 0x80, target);
+}
+
+template <> inline void SortKeyOperation<int16_t>::Operation(int16_t value, data_ptr_t target) {
+	EncodeUnsigned<uint16_t>((uint16_t)value ^ 0x8000, target);
+}
+
+template <> inline void SortKeyOperation<int32_t>::Operation(int32_t value, data_ptr_t target) {
+	EncodeUnsigned<uint32_t>((uint32_t)value ^ 0x80000000, target);
+}
+
+template <> inline void SortKeyOperation<int64_t>::Operation(int64_t value, data_ptr_t target) {
+	EncodeUnsigned<uint64_t>((uint64_t)value ^ 0x8000000000000000, target);
+}
+
+template <> inline void SortKeyOperation<hugeint_t>::Operation(hugeint_t value, data_ptr_t target) {
+	SortKeyOperation<int64_t>::Operation(value.upper, target);
+	EncodeUnsigned<uint64_t>(value.lower, target + sizeof(int64_t));
+}
+
+template <> inline void SortKeyOperation<float>::Operation(float value, data_ptr_t target) {
+	uint32_t bits;
+	// -0.0 and 0.0 compare equal: give them the same encoding
+	value = value == 0 ? 0 : value;
+	memcpy(&bits, &value, sizeof(bits));
+	// negative numbers are inverted entirely, positive numbers only get their sign bit flipped
+	bits = (bits & 0x80000000) ? ~bits : bits ^ 0x80000000;
+	EncodeUnsigned<uint32_t>(bits, target);
+}
+
+template <> inline void SortKeyOperation<double>::Operation(double value, data_ptr_t target) {
+	uint64_t bits;
+	value = value == 0 ? 0 : value;
+	memcpy(&bits, &value, sizeof(bits));
+	bits = (bits & 0x8000000000000000) ? ~bits : bits ^ 0x8000000000000000;
+	EncodeUnsigned<uint64_t>(bits, target);
+}
+
+template <> inline void SortKeyOperation<string_t>::Operation(string_t value, data_ptr_t target) {
+	// store the (zero-padded) prefix of the string
+	auto length = MinValue<idx_t>(value.GetSize(), SortKeyEncoder::STRING_PREFIX_LENGTH);
+	memcpy(target, value.GetDataUnsafe(), length);
+	memset(target + length, 0, SortKeyEncoder::STRING_PREFIX_LENGTH - length);
+}
+
+template <> inline void SortKeyOperation<interval_t>::Operation(interval_t value, data_ptr_t target) {
+	// intervals are only encoded as a NULL byte, their values are compared in the tie-breaker
+}
+
+template <class T>
+static void TemplatedEncode(VectorData &vdata, idx_t count, data_ptr_t target, idx_t stride, idx_t width,
+                            uint8_t valid_byte) {
+	auto data = (T *)vdata.data;
+	for (idx_t i = 0; i < count; i++) {
+		auto idx = vdata.sel->get_index(i);
+		auto key = target + i * stride;
+		if ((*vdata.nullmask)[idx]) {
+			key[0] = !valid_byte;
+			memset(key + 1, 0, width);
+		} else {
+			key[0] = valid_byte;
+			SortKeyOperation<T>::Operation(data[idx], key + 1);
+		}
+	}
+}
+
+void SortKeyEncoder::EncodeColumn(Vector &vector, idx_t count, idx_t col_idx, data_ptr_t target, idx_t stride) {
+	VectorData vdata;
+	vector.Orrify(count, vdata);
+
+	target += offsets[col_idx];
+	auto internal_type = types[col_idx].InternalType();
+	auto width = GetEncodedWidth(internal_type);
+	// NULLS FIRST: NULL values get a 0 byte, NULLS LAST: NULL values get a 1 byte
+	uint8_t valid_byte = null_orders[col_idx] == OrderByNullType::NULLS_FIRST ? 1 : 0;
+	switch (internal_type) {
+	case PhysicalType::BOOL:
+		TemplatedEncode<bool>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::INT8:
+		TemplatedEncode<int8_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::INT16:
+		TemplatedEncode<int16_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::INT32:
+		TemplatedEncode<int32_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::INT64:
+		TemplatedEncode<int64_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::INT128:
+		TemplatedEncode<hugeint_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::FLOAT:
+		TemplatedEncode<float>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::DOUBLE:
+		TemplatedEncode<double>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::VARCHAR:
+		TemplatedEncode<string_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	case PhysicalType::INTERVAL:
+		TemplatedEncode<interval_t>(vdata, count, target, stride, width, valid_byte);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented type for sort key");
+	}
+	if (order_types[col_idx] == OrderType::DESCENDING) {
+		// descending order: invert the bytes of the column, this also inverts the position of NULL values (matching
+		// the comparison of the ChunkCollection)
+		for (idx_t i = 0; i < count; i++) {
+			auto key = target + i * stride;
+			for (idx_t byte_idx = 0; byte_idx < 1 + width; byte_idx++) {
+				key[byte_idx] = ~key[byte_idx];
+			}
+		}
+	}
+}
+
+void SortKeyEncoder::Encode(DataChunk &chunk, data_ptr_t target, idx_t stride) {
+	D_ASSERT(chunk.ColumnCount() >= types.size());
+	for (idx_t col_idx = 0; col_idx < types.size(); col_idx++) {
+		EncodeColumn(chunk.data[col_idx], chunk.size(), col_idx, target, stride);
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// Sort
+//===--------------------------------------------------------------------===//
+//! Least significant digit radix sort of records that start with a key of key_width bytes. Performs a stable counting
+//! sort pass per key byte, starting from the last byte. Returns the buffer (records or temp) that holds the result.
+static data_ptr_t RadixSortRecords(data_ptr_t records, data_ptr_t temp, idx_t count, idx_t key_width,
+                                   idx_t record_width) {
+	idx_t counts[256];
+	for (idx_t byte_idx = key_width; byte_idx > 0; byte_idx--) {
+		auto offset = byte_idx - 1;
+		memset(counts, 0, sizeof(counts));
+		for (idx_t i = 0; i < count; i++) {
+			counts[records[i * record_width + offset]]++;
+		}
+		if (counts[records[offset]] == count) {
+			// all keys have the same byte at this position (e.g. the NULL byte): skip the pass
+			continue;
+		}
+		// compute the start position of every bucket
+		idx_t total = 0;
+		for (idx_t bucket = 0; bucket < 256; bucket++) {
+			auto bucket_count = counts[bucket];
+			counts[bucket] = total;
+			total += bucket_count;
+		}
+		// scatter the records to their bucket
+		for (idx_t i = 0; i < count; i++) {
+			auto record = records + i * record_width;
+			memcpy(temp + counts[record[offset]]++ * record_width, record, record_width);
+		}
+		std::swap(records, temp);
+	}
+	return records;
+}
+
+void SortKeyEncoder::SortKeys(const_data_ptr_t keys, idx_t result[], idx_t count) {
+	D_ASSERT(!HasTieBreaker());
+	if (key_width > RADIX_SORT_MAX_KEY_WIDTH || count < RADIX_SORT_THRESHOLD) {
+		std::sort(result, result + count, [&](const idx_t &left, const idx_t &right) {
+			return memcmp(keys + left * key_width, keys + right * key_width, key_width) < 0;
+		});
+		return;
+	}
+	// copy the keys together with their row index into contiguous records
+	auto record_width = key_width + sizeof(idx_t);
+	auto buffer = unique_ptr<data_t[]>(new data_t[2 * count * record_width]);
+	auto records = buffer.get();
+	for (idx_t i = 0; i < count; i++) {
+		auto record = records + i * record_width;
+		memcpy(record, keys + result[i] * key_width, key_width);
+		Store<idx_t>(result[i], record + key_width);
+	}
+	auto sorted = RadixSortRecords(records, records + count * record_width, count, key_width, record_width);
+	for (idx_t i = 0; i < count; i++) {
+		result[i] = Load<idx_t>(sorted + i * record_width + key_width);
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// Compare
+//===--------------------------------------------------------------------===//
+void SortKeyEncoder::OrrifyTieColumns(DataChunk &chunk, vector<VectorData> &result) {
+	result.resize(types.size());
+	for (auto &col_idx : tie_columns) {
+		chunk.data[col_idx].Orrify(chunk.size(), result[col_idx]);
+	}
+}
+
+template <class T>
+static int TemplatedCompareValues(VectorData &left_data, idx_t left_idx, VectorData &right_data, idx_t right_idx) {
+	auto lidx = left_data.sel->get_index(left_idx);
+	auto ridx = right_data.sel->get_index(right_idx);
+	if ((*left_data.nullmask)[lidx] || (*right_data.nullmask)[ridx]) {
+		// NULL values are decided by the NULL byte: if we get here both are NULL
+		return 0;
+	}
+	auto lval = ((T *)left_data.data)[lidx];
+	auto rval = ((T *)right_data.data)[ridx];
+	if (Equals::Operation<T>(lval, rval)) {
+		return 0;
+	}
+	return LessThan::Operation<T>(lval, rval) ? -1 : 1;
+}
+
+int SortKeyEncoder::CompareWithTieBreaker(const_data_ptr_t left, const_data_ptr_t right, vector<VectorData> &left_data,
+                                          idx_t left_idx, vector<VectorData> &right_data, idx_t right_idx) {
+	D_ASSERT(left_data.size() == types.size() && right_data.size() == types.size());
+	idx_t offset = 0;
+	for (auto &col_idx : tie_columns) {
+		// compare the key up to and including the encoded part of this column
+		idx_t end = col_idx + 1 < offsets.size() ? offsets[col_idx + 1] : key_width;
+		auto cmp = memcmp(left + offset, right + offset, end - offset);
+		if (cmp != 0) {
+			return cmp;
+		}
+		offset = end;
+		// the encoded part is equal: compare the full values
+		auto &left_vdata = left_data[col_idx];
+		auto &right_vdata = right_data[col_idx];
+		if (types[col_idx].InternalType() == PhysicalType::VARCHAR) {
+			cmp = TemplatedCompareValues<string_t>(left_vdata, left_idx, right_vdata, right_idx);
+		} else {
+			cmp = TemplatedCompareValues<interval_t>(left_vdata, left_idx, right_vdata, right_idx);
+		}
+		if (cmp != 0) {
+			return order_types[col_idx] == OrderType::DESCENDING ? -cmp : cmp;
+		}
+	}
+	return memcmp(left + offset, right + offset, key_width - offset);
+}
+
+} // namespace duckdb
@@ -11,7 +11,7 @@ namespace duckdb {
 
 #define MINIMUM_HEAP_SIZE 4096
 
-StringHeap::StringHeap() : tail(nullptr) {
+StringHeap::StringHeap() : tail(nullptr), allocated_size(0) {
 }
 
 string_t StringHeap::AddString(const char *data, idx_t len) {
@@ -44,6 +44,7 @@ string_t StringHeap::EmptyString(idx_t len) {
 	if (!chunk || chunk->current_position + len >= chunk->maximum_size) {
 		// have to make a new entry
 		auto new_chunk = make_unique<StringChunk>(MaxValue<idx_t>(len, MINIMUM_HEAP_SIZE));
+		allocated_size += new_chunk->maximum_size;
 		new_chunk->prev = move(chunk);
 		chunk = move(new_chunk);
 		if (!tail) {
@@ -62,9 +63,12 @@ void StringHeap::MergeHeap(StringHeap &other) {
 	other.tail->prev = move(chunk);
 	this->chunk = move(other.chunk);
 	if (!tail) {
-		tail = this->chunk.get();
+		// the oldest chunk of the other heap is now the oldest chunk of this heap
+		tail = other.tail;
 	}
 	other.tail = nullptr;
+	allocated_size += other.allocated_size;
+	other.allocated_size = 0;
 }
 
 } // namespace duckdb
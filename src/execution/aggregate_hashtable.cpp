@@ -33,6 +33,7 @@ GroupedAggregateHashTable::GroupedAggregateHashTable(BufferManager &buffer_manag
                                                      HtEntryType entry_type)
     : BaseAggregateHashTable(buffer_manager, move(group_types_p), move(payload_types_p), move(aggregate_objects_p)),
       entry_type(entry_type), capacity(0), entries(0), payload_page_offset(0), is_finalized(false),
+      has_duplicate_groups(false),
       ht_offsets(LogicalTypeId::BIGINT), hash_salts(LogicalTypeId::SMALLINT),
       group_compare_vector(STANDARD_VECTOR_SIZE), no_match_vector(STANDARD_VECTOR_SIZE),
       empty_vector(STANDARD_VECTOR_SIZE) {
@@ -94,6 +95,7 @@ template <class FUNC> void GroupedAggregateHashTable::PayloadApply(FUNC fun) {
 	idx_t page_nr = 0;
 	idx_t page_offset = 0;
 
+	D_ASSERT(payload_hds_ptrs.size() == payload_blocks.size());
 	for (auto &payload_chunk_ptr : payload_hds_ptrs) {
 		auto this_entries = MinValue(tuples_per_block, apply_entries);
 		page_offset = 0;
@@ -108,12 +110,55 @@ template <class FUNC> void GroupedAggregateHashTable::PayloadApply(FUNC fun) {
 }
 
 void GroupedAggregateHashTable::NewBlock() {
-	auto pin = buffer_manager.Allocate(Storage::BLOCK_ALLOC_SIZE);
-	payload_hds.push_back(move(pin));
+	// the payload is not destroyable so it can be spilled to disk once the HT is unpinned
+	auto block = buffer_manager.RegisterMemory(Storage::BLOCK_ALLOC_SIZE, false);
+	payload_hds.push_back(buffer_manager.Pin(block));
 	payload_hds_ptrs.push_back(payload_hds.back()->Ptr());
+	payload_blocks.push_back(move(block));
 	payload_page_offset = 0;
 }
 
+void GroupedAggregateHashTable::Unpin() {
+	D_ASSERT(is_finalized);
+	payload_hds.clear();
+	payload_hds_ptrs.clear();
+	for (auto &distinct_ht : distinct_hashes) {
+		if (distinct_ht) {
+			distinct_ht->Unpin();
+		}
+	}
+}
+
+void GroupedAggregateHashTable::Pin() {
+	for (auto &distinct_ht : distinct_hashes) {
+		if (distinct_ht) {
+			distinct_ht->Pin();
+		}
+	}
+	if (payload_hds.size() == payload_blocks.size()) {
+		// already pinned
+		return;
+	}
+	D_ASSERT(payload_hds.empty());
+	for (auto &block : payload_blocks) {
+		payload_hds.push_back(buffer_manager.Pin(block));
+		payload_hds_ptrs.push_back(payload_hds.back()->Ptr());
+	}
+}
+
+idx_t GroupedAggregateHashTable::SizeInBytes() {
+	idx_t size = payload_hds.size() * Storage::BLOCK_ALLOC_SIZE + string_heap.SizeInBytes();
+	if (hashes_hdl) {
+		size += MaxValue<idx_t>(hashes_end_ptr - hashes_hdl_ptr, Storage::BLOCK_ALLOC_SIZE);
+	}
+	for (auto &distinct_ht : distinct_hashes) {
+		if (distinct_ht) {
+			size += distinct_ht->SizeInBytes();
+		}
+	}
+	return size;
+}
+
 void GroupedAggregateHashTable::Destroy() {
 	// check if there is a destructor
 	bool has_destructor = false;
@@ -122,7 +167,7 @@ void GroupedAggregateHashTable::Destroy() {
 			has_destructor = true;
 		}
 	}
-	if (!has_destructor) {
+	if (!has_destructor || entries == 0) {
 		return;
 	}
 	// there are aggregates with destructors: loop over the hash table
@@ -131,14 +176,31 @@ void GroupedAggregateHashTable::Destroy() {
 	Vector state_vector(LogicalType::POINTER, (data_ptr_t)data_pointers);
 	idx_t count = 0;
 
-	PayloadApply([&](idx_t page_nr, idx_t page_offset, data_ptr_t ptr) {
-		data_pointers[count++] = ptr + HASH_WIDTH + group_width;
-		if (count == STANDARD_VECTOR_SIZE) {
-			CallDestructors(state_vector, count);
-			count = 0;
+	idx_t remaining = entries;
+	for (idx_t block_idx = 0; block_idx < payload_blocks.size(); block_idx++) {
+		// if the HT is unpinned, we pin its blocks one at a time
+		unique_ptr<BufferHandle> pin;
+		data_ptr_t block_ptr;
+		if (block_idx < payload_hds_ptrs.size()) {
+			block_ptr = payload_hds_ptrs[block_idx];
+		} else {
+			pin = buffer_manager.Pin(payload_blocks[block_idx]);
+			block_ptr = pin->Ptr();
 		}
-	});
-	CallDestructors(state_vector, count);
+		auto block_entries = MinValue(tuples_per_block, remaining);
+		for (idx_t i = 0; i < block_entries; i++) {
+			data_pointers[count++] = block_ptr + i * tuple_size + HASH_WIDTH + group_width;
+			if (count == STANDARD_VECTOR_SIZE) {
+				CallDestructors(state_vector, count);
+				count = 0;
+			}
+		}
+		// the states have to be destroyed before the block is unpinned
+		CallDestructors(state_vector, count);
+		count = 0;
+		remaining -= block_entries;
+	}
+	D_ASSERT(remaining == 0);
 }
 
 template <class T> void GroupedAggregateHashTable::VerifyInternal() {
@@ -180,6 +242,10 @@ idx_t GroupedAggregateHashTable::MaxCapacity() {
 
 void GroupedAggregateHashTable::Verify() {
 #ifdef DEBUG
+	if (has_duplicate_groups) {
+		// the appended rows are not in the hash table
+		return;
+	}
 	switch (entry_type) {
 	case HtEntryType::HT_WIDTH_32:
 		VerifyInternal<aggr_ht_entry_32>();
@@ -326,6 +392,56 @@ idx_t GroupedAggregateHashTable::AddChunk(DataChunk &groups, Vector &group_hashe
 	return new_group_count;
 }
 
+idx_t GroupedAggregateHashTable::AppendRows(DataChunk &groups, Vector &group_hashes, DataChunk &payload) {
+	D_ASSERT(!is_finalized);
+	D_ASSERT(groups.ColumnCount() == group_types.size());
+	if (groups.size() == 0) {
+		return 0;
+	}
+	if (entries + groups.size() > MaxCapacity()) {
+		throw InternalException("Hash table capacity reached");
+	}
+	// the groups are never looked up in this HT again: they are only aggregated when it is combined into another HT
+	has_duplicate_groups = true;
+
+	group_hashes.Normalify(groups.size());
+	auto group_hashes_ptr = FlatVector::GetData<hash_t>(group_hashes);
+
+	// every row gets a new entry, with the group hash in front of it so it can be combined or partitioned later
+	Vector addresses(LogicalType::POINTER);
+	auto addresses_ptr = FlatVector::GetData<data_ptr_t>(addresses);
+	for (idx_t i = 0; i < groups.size(); i++) {
+		if (payload_page_offset == tuples_per_block || payload_hds.empty()) {
+			NewBlock();
+		}
+		auto entry_payload_ptr = payload_hds_ptrs.back() + (payload_page_offset++ * tuple_size);
+		memcpy(entry_payload_ptr, &group_hashes_ptr[i], HASH_WIDTH);
+		memcpy(entry_payload_ptr + HASH_WIDTH + group_width, empty_payload_data.get(), payload_width);
+		addresses_ptr[i] = entry_payload_ptr + HASH_WIDTH;
+	}
+	entries += groups.size();
+
+	auto group_data = unique_ptr<VectorData[]>(new VectorData[groups.ColumnCount()]);
+	for (idx_t grp_idx = 0; grp_idx < groups.ColumnCount(); grp_idx++) {
+		groups.data[grp_idx].Orrify(groups.size(), group_data[grp_idx]);
+	}
+	ScatterGroups(groups, group_data, addresses, FlatVector::IncrementalSelectionVector, groups.size());
+	// the addresses now point behind the groups: skip the padding to point at the payload
+	VectorOperations::AddInPlace(addresses, group_padding, groups.size());
+
+	// update the aggregates of every entry with its own row
+	idx_t payload_idx = 0;
+	for (auto &aggr : aggregates) {
+		D_ASSERT(!aggr.distinct);
+		auto input_count = (idx_t)aggr.child_count;
+		aggr.function.update(input_count == 0 ? nullptr : &payload.data[payload_idx], input_count, addresses,
+		                     payload.size());
+		payload_idx += input_count;
+		VectorOperations::AddInPlace(addresses, aggr.payload_size, payload.size());
+	}
+	return groups.size();
+}
+
 void GroupedAggregateHashTable::FetchAggregates(DataChunk &groups, DataChunk &result) {
 	groups.Verify();
 	D_ASSERT(groups.ColumnCount() == group_types.size());
@@ -532,6 +648,7 @@ idx_t GroupedAggregateHashTable::FindOrCreateGroupsInternal(DataChunk &groups, V
                                                             SelectionVector &new_groups_out) {
 
 	D_ASSERT(!is_finalized);
+	D_ASSERT(!has_duplicate_groups);
 
 	if (entries + groups.size() > MaxCapacity()) {
 		throw InternalException("Hash table capacity reached");
@@ -699,7 +816,8 @@ idx_t GroupedAggregateHashTable::FindOrCreateGroups(DataChunk &groups, Vector &a
 	return FindOrCreateGroups(groups, hashes, addresses_out, new_groups_out);
 }
 
-void GroupedAggregateHashTable::FlushMove(Vector &source_addresses, Vector &source_hashes, idx_t count) {
+void GroupedAggregateHashTable::FlushMove(Vector &source_addresses, Vector &source_hashes, idx_t count,
+                                          bool skip_distinct) {
 	D_ASSERT(source_addresses.type == LogicalType::POINTER);
 	D_ASSERT(source_hashes.type == LogicalType::HASH);
 
@@ -721,8 +839,10 @@ void GroupedAggregateHashTable::FlushMove(Vector &source_addresses, Vector &sour
 
 	for (auto &aggr : aggregates) {
 		// for any entries for which a group was found, update the aggregate
-		D_ASSERT(aggr.function.combine);
-		aggr.function.combine(source_addresses, group_addresses, count);
+		if (!skip_distinct || !aggr.distinct) {
+			D_ASSERT(aggr.function.combine);
+			aggr.function.combine(source_addresses, group_addresses, count);
+		}
 		VectorOperations::AddInPlace(source_addresses, aggr.payload_size, count);
 		VectorOperations::AddInPlace(group_addresses, aggr.payload_size, count);
 	}
@@ -756,15 +876,85 @@ void GroupedAggregateHashTable::Combine(GroupedAggregateHashTable &other) {
 		addresses_ptr[group_idx] = ptr + HASH_WIDTH;
 		group_idx++;
 		if (group_idx == STANDARD_VECTOR_SIZE) {
-			FlushMove(addresses, hashes, group_idx);
+			FlushMove(addresses, hashes, group_idx, true);
 			group_idx = 0;
 		}
 	});
-	FlushMove(addresses, hashes, group_idx);
+	FlushMove(addresses, hashes, group_idx, true);
 	string_heap.MergeHeap(other.string_heap);
+
+	// the states of distinct aggregates cannot be combined, as both HTs might have seen the same values: instead the
+	// distinct values of the other HT are deduplicated against ours, and only the unseen ones update the aggregate
+	idx_t payload_idx = 0;
+	idx_t state_offset = 0;
+	for (idx_t aggr_idx = 0; aggr_idx < aggregates.size(); aggr_idx++) {
+		auto &aggr = aggregates[aggr_idx];
+		if (aggr.distinct) {
+			CombineDistinct(other, aggr_idx, payload_idx, state_offset);
+		}
+		payload_idx += aggr.child_count;
+		state_offset += aggr.payload_size;
+	}
 	Verify();
 }
 
+void GroupedAggregateHashTable::CombineStates(DataChunk &groups, Vector &source_addresses) {
+	D_ASSERT(!is_finalized);
+	D_ASSERT(source_addresses.type == LogicalType::POINTER);
+	if (groups.size() == 0) {
+		return;
+	}
+	Vector group_addresses(LogicalType::POINTER);
+	FindOrCreateGroups(groups, group_addresses);
+
+	for (auto &aggr : aggregates) {
+		D_ASSERT(!aggr.distinct);
+		D_ASSERT(aggr.function.combine);
+		aggr.function.combine(source_addresses, group_addresses, groups.size());
+		VectorOperations::AddInPlace(source_addresses, aggr.payload_size, groups.size());
+		VectorOperations::AddInPlace(group_addresses, aggr.payload_size, groups.size());
+	}
+}
+
+void GroupedAggregateHashTable::CombineDistinct(GroupedAggregateHashTable &other, idx_t aggr_idx, idx_t payload_idx,
+                                                idx_t state_offset) {
+	auto &aggr = aggregates[aggr_idx];
+	auto &other_distinct = *other.distinct_hashes[aggr_idx];
+	if (other_distinct.Size() == 0) {
+		return;
+	}
+	// the distinct HTs are grouped by the groups followed by the aggregate input
+	DataChunk distinct_chunk;
+	distinct_chunk.Initialize(other_distinct.group_types);
+	DataChunk group_chunk;
+	group_chunk.InitializeEmpty(group_types);
+
+	SelectionVector new_values(STANDARD_VECTOR_SIZE);
+	Vector dummy_addresses(LogicalType::POINTER);
+	Vector state_addresses(LogicalType::POINTER);
+	idx_t scan_position = 0;
+	while (true) {
+		distinct_chunk.Reset();
+		other_distinct.Scan(scan_position, distinct_chunk);
+		if (distinct_chunk.size() == 0) {
+			break;
+		}
+		auto new_count = distinct_hashes[aggr_idx]->FindOrCreateGroups(distinct_chunk, dummy_addresses, new_values);
+		if (new_count == 0) {
+			continue;
+		}
+		distinct_chunk.Slice(new_values, new_count);
+		for (idx_t group_idx = 0; group_idx < group_types.size(); group_idx++) {
+			group_chunk.data[group_idx].Reference(distinct_chunk.data[group_idx]);
+		}
+		group_chunk.SetCardinality(distinct_chunk);
+		FindOrCreateGroups(group_chunk, state_addresses);
+		VectorOperations::AddInPlace(state_addresses, state_offset, new_count);
+		aggr.function.update(aggr.child_count == 0 ? nullptr : &distinct_chunk.data[group_types.size()],
+		                     aggr.child_count, state_addresses, new_count);
+	}
+}
+
 struct PartitionInfo {
 	PartitionInfo() : addresses(LogicalType::POINTER), hashes(LogicalType::HASH), group_count(0) {
 		addresses_ptr = FlatVector::GetData<data_ptr_t>(addresses);
@@ -800,6 +990,13 @@ void GroupedAggregateHashTable::Partition(vector<GroupedAggregateHashTable *> &p
 		}
 	});
 
+	// the distinct values are partitioned on the hash of their groups, so they end up with their group
+	for (idx_t aggr_idx = 0; aggr_idx < aggregates.size(); aggr_idx++) {
+		if (aggregates[aggr_idx].distinct) {
+			PartitionDistinct(partition_hts, aggr_idx, mask, shift);
+		}
+	}
+
 	idx_t info_idx = 0;
 	idx_t total_count = 0;
 	for (auto &partition_entry : partition_hts) {
@@ -815,6 +1012,54 @@ void GroupedAggregateHashTable::Partition(vector<GroupedAggregateHashTable *> &p
 	entries = 0;
 }
 
+void GroupedAggregateHashTable::PartitionDistinct(vector<GroupedAggregateHashTable *> &partition_hts, idx_t aggr_idx,
+                                                  hash_t mask, idx_t shift) {
+	auto &distinct_ht = *distinct_hashes[aggr_idx];
+	DataChunk distinct_chunk;
+	distinct_chunk.Initialize(distinct_ht.group_types);
+	DataChunk group_chunk;
+	group_chunk.InitializeEmpty(group_types);
+	DataChunk partition_chunk;
+	partition_chunk.InitializeEmpty(distinct_ht.group_types);
+
+	Vector hashes(LogicalType::HASH);
+	Vector dummy_addresses(LogicalType::POINTER);
+	vector<SelectionVector> partition_sel(partition_hts.size());
+	for (auto &sel : partition_sel) {
+		sel.Initialize();
+	}
+	vector<idx_t> partition_count(partition_hts.size());
+	idx_t scan_position = 0;
+	while (true) {
+		distinct_chunk.Reset();
+		distinct_ht.Scan(scan_position, distinct_chunk);
+		if (distinct_chunk.size() == 0) {
+			break;
+		}
+		for (idx_t group_idx = 0; group_idx < group_types.size(); group_idx++) {
+			group_chunk.data[group_idx].Reference(distinct_chunk.data[group_idx]);
+		}
+		group_chunk.SetCardinality(distinct_chunk);
+		group_chunk.Hash(hashes);
+		D_ASSERT(hashes.vector_type == VectorType::FLAT_VECTOR);
+		auto hashes_ptr = FlatVector::GetData<hash_t>(hashes);
+
+		std::fill(partition_count.begin(), partition_count.end(), 0);
+		for (idx_t i = 0; i < distinct_chunk.size(); i++) {
+			idx_t partition = (hashes_ptr[i] & mask) >> shift;
+			D_ASSERT(partition < partition_hts.size());
+			partition_sel[partition].set_index(partition_count[partition]++, i);
+		}
+		for (idx_t partition = 0; partition < partition_hts.size(); partition++) {
+			if (partition_count[partition] == 0) {
+				continue;
+			}
+			partition_chunk.Slice(distinct_chunk, partition_sel[partition], partition_count[partition]);
+			partition_hts[partition]->distinct_hashes[aggr_idx]->FindOrCreateGroups(partition_chunk, dummy_addresses);
+		}
+	}
+}
+
 idx_t GroupedAggregateHashTable::Scan(idx_t &scan_position, DataChunk &result) {
 	auto data_pointers = FlatVector::GetData<data_ptr_t>(addresses);
 
@@ -839,29 +1084,69 @@ idx_t GroupedAggregateHashTable::Scan(idx_t &scan_position, DataChunk &result) {
 	}
 
 	result.SetCardinality(this_n);
+	FetchScanResult(addresses, result);
+	scan_position += this_n;
+	return this_n;
+}
+
+unique_ptr<BufferHandle> GroupedAggregateHashTable::PinBlock(idx_t scan_position) {
+	D_ASSERT(scan_position < entries);
+	return buffer_manager.Pin(payload_blocks[scan_position / tuples_per_block]);
+}
+
+idx_t GroupedAggregateHashTable::ScanBlock(BufferHandle &block, idx_t &scan_position, idx_t scan_end,
+                                           DataChunk &result) {
+	D_ASSERT(scan_end <= entries);
+	D_ASSERT(scan_end == scan_position || (scan_end - 1) / tuples_per_block == scan_position / tuples_per_block);
+	if (scan_position >= scan_end) {
+		return 0;
+	}
+	auto this_n = MinValue((idx_t)STANDARD_VECTOR_SIZE, scan_end - scan_position);
+
+	// the addresses are not kept in the HT, so that multiple threads can scan different blocks at the same time
+	Vector block_addresses(LogicalType::POINTER);
+	auto data_pointers = FlatVector::GetData<data_ptr_t>(block_addresses);
+	auto read_ptr = block.Ptr() + (scan_position % tuples_per_block) * tuple_size + HASH_WIDTH;
+	for (idx_t i = 0; i < this_n; i++) {
+		data_pointers[i] = read_ptr;
+		read_ptr += tuple_size;
+	}
+
+	result.SetCardinality(this_n);
+	FetchScanResult(block_addresses, result);
+	scan_position += this_n;
+	return this_n;
+}
+
+void GroupedAggregateHashTable::FetchScanResult(Vector &group_addresses, DataChunk &result) {
 	// fetch the group columns
 	for (idx_t i = 0; i < group_types.size(); i++) {
 		auto &column = result.data[i];
-		VectorOperations::Gather::Set(addresses, column, result.size());
+		VectorOperations::Gather::Set(group_addresses, column, result.size());
 	}
 
-	VectorOperations::AddInPlace(addresses, group_padding, result.size());
+	VectorOperations::AddInPlace(group_addresses, group_padding, result.size());
 
 	for (idx_t i = 0; i < aggregates.size(); i++) {
 		auto &target = result.data[group_types.size() + i];
 		auto &aggr = aggregates[i];
-		aggr.function.finalize(addresses, aggr.bind_data, target, result.size());
-		VectorOperations::AddInPlace(addresses, aggr.payload_size, result.size());
+		aggr.function.finalize(group_addresses, aggr.bind_data, target, result.size());
+		VectorOperations::AddInPlace(group_addresses, aggr.payload_size, result.size());
 	}
-	scan_position += this_n;
-	return this_n;
 }
 
 void GroupedAggregateHashTable::Finalize() {
-	D_ASSERT(!is_finalized);
+	if (is_finalized) {
+		return;
+	}
 
 	// early release hashes, not needed for partition/scan
 	hashes_hdl.reset();
+	for (auto &distinct_ht : distinct_hashes) {
+		if (distinct_ht) {
+			distinct_ht->Finalize();
+		}
+	}
 	is_finalized = true;
 }
 
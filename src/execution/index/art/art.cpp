@@ -438,14 +438,77 @@ bool ART::SearchEqual(ARTIndexScanState *state, idx_t max_count, vector<row_t> &
 	return true;
 }
 
-void ART::SearchEqualJoinNoFetch(Value &equal_value, idx_t &result_size) {
-	//! We need to look for a leaf
-	auto key = CreateKey(*this, types[0], equal_value);
-	auto leaf = static_cast<Leaf *>(Lookup(tree, *key, 0));
-	if (!leaf) {
-		return;
+void ART::SearchEqualJoin(DataChunk &input, Leaf *result[]) {
+	vector<unique_ptr<Key>> keys;
+	GenerateKeys(input, keys);
+
+	// sort the non-NULL keys
+	vector<idx_t> sorted_keys;
+	for (idx_t i = 0; i < input.size(); i++) {
+		result[i] = nullptr;
+		if (keys[i]) {
+			sorted_keys.push_back(i);
+		}
+	}
+	std::sort(sorted_keys.begin(), sorted_keys.end(), [&](idx_t a, idx_t b) { return *keys[a] < *keys[b]; });
+
+	// the path of the previous lookup: the node visited at every depth
+	vector<IteratorEntry> path;
+	path.emplace_back(tree.get(), 0);
+	Key *previous_key = nullptr;
+	idx_t previous_idx = 0;
+	for (auto key_idx : sorted_keys) {
+		auto &key = *keys[key_idx];
+		if (previous_key) {
+			// determine the length of the prefix shared with the previous key
+			idx_t shared = 0;
+			idx_t max_shared = MinValue<idx_t>(key.len, previous_key->len);
+			while (shared < max_shared && key[shared] == (*previous_key)[shared]) {
+				shared++;
+			}
+			if (shared == key.len && shared == previous_key->len) {
+				// same key as the previous one
+				result[key_idx] = result[previous_idx];
+				continue;
+			}
+			// the node reached at a depth only depends on the bytes before that depth
+			while (path.size() > 1 && path.back().pos > shared) {
+				path.pop_back();
+			}
+		}
+		previous_key = &key;
+		previous_idx = key_idx;
+
+		// descend from the deepest shared node
+		auto node = path.back().node;
+		idx_t depth = path.back().pos;
+		while (node) {
+			if (node->type == NodeType::NLeaf) {
+				if (LeafMatches(node, key, depth)) {
+					result[key_idx] = static_cast<Leaf *>(node);
+				}
+				break;
+			}
+			if (node->prefix_length) {
+				idx_t pos = 0;
+				while (pos < node->prefix_length && key[depth + pos] == node->prefix[pos]) {
+					pos++;
+				}
+				if (pos < node->prefix_length) {
+					break;
+				}
+				depth += node->prefix_length;
+			}
+			idx_t pos = node->GetChildPos(key[depth]);
+			if (pos == INVALID_INDEX) {
+				break;
+			}
+			node = node->GetChild(pos)->get();
+			D_ASSERT(node);
+			depth++;
+			path.emplace_back(node, depth);
+		}
 	}
-	result_size = leaf->num_elements;
 }
 
 Node *ART::Lookup(unique_ptr<Node> &node, Key &key, unsigned depth) {
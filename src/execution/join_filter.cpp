@@ -0,0 +1,110 @@
+#include "duckdb/execution/join_filter.hpp"
+
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/common/types/vector.hpp"
+#include "duckdb/planner/table_filter.hpp"
+
+namespace duckdb {
+
+JoinFilter::JoinFilter(idx_t key_index, idx_t column_index, LogicalType type_p)
+    : key_index(key_index), column_index(column_index), type(move(type_p)), published(false), bloom_mask(0) {
+}
+
+bool JoinFilter::SupportsType(const LogicalType &type) {
+	switch (type.id()) {
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+	case LogicalTypeId::DATE:
+	case LogicalTypeId::TIME:
+	case LogicalTypeId::TIMESTAMP:
+		return true;
+	case LogicalTypeId::DECIMAL:
+		return type.InternalType() != PhysicalType::INT128;
+	default:
+		// the range of floating point keys is not well-defined in the presence of NaN values
+		return false;
+	}
+}
+
+void JoinFilter::Reset() {
+	published = false;
+	bloom_blocks.clear();
+	bloom_mask = 0;
+}
+
+void JoinFilter::InitializeBloomFilter(idx_t count) {
+	idx_t block_count = NextPowerOfTwo(MaxValue<idx_t>(count * BLOOM_BITS_PER_KEY / 64, 1));
+	bloom_blocks.assign(block_count, 0);
+	bloom_mask = block_count - 1;
+}
+
+void JoinFilter::InsertHashes(hash_t hashes[], idx_t count) {
+	D_ASSERT(!bloom_blocks.empty());
+	auto blocks = bloom_blocks.data();
+	for (idx_t i = 0; i < count; i++) {
+		auto hash = BloomHash(hashes[i]);
+		blocks[hash & bloom_mask] |= BloomBits(hash);
+	}
+}
+
+void JoinFilter::Publish(Value min_p, Value max_p) {
+	min = move(min_p);
+	max = move(max_p);
+	published = true;
+}
+
+void JoinFilter::Apply(TableFilterSet &table_filters) {
+	if (!published) {
+		return;
+	}
+	if (table_filters.filters.find(column_index) == table_filters.filters.end()) {
+		// a column scan evaluates either a single comparison or a single range: only push the range of the build keys
+		// if there are no other filters on the column
+		vector<TableFilter> range;
+		range.push_back(TableFilter(min, ExpressionType::COMPARE_GREATERTHANOREQUALTO, column_index));
+		range.push_back(TableFilter(max, ExpressionType::COMPARE_LESSTHANOREQUALTO, column_index));
+		table_filters.filters.insert(make_pair(column_index, move(range)));
+	}
+	if (!bloom_blocks.empty()) {
+		table_filters.join_filters.push_back(this);
+	}
+}
+
+template <class T> idx_t JoinFilter::TemplatedSelect(Vector &input, SelectionVector &sel, idx_t count) {
+	auto data = FlatVector::GetData<T>(input);
+	auto blocks = bloom_blocks.data();
+	SelectionVector new_sel(count);
+	idx_t result_count = 0;
+	for (idx_t i = 0; i < count; i++) {
+		auto idx = sel.get_index(i);
+		auto hash = BloomHash(duckdb::Hash<T>(data[idx]));
+		auto bits = BloomBits(hash);
+		new_sel.set_index(result_count, idx);
+		result_count += (blocks[hash & bloom_mask] & bits) == bits;
+	}
+	sel.Initialize(new_sel);
+	return result_count;
+}
+
+idx_t JoinFilter::Select(Vector &input, SelectionVector &sel, idx_t count) {
+	if (bloom_blocks.empty() || count == 0) {
+		return count;
+	}
+	D_ASSERT(input.vector_type == VectorType::FLAT_VECTOR);
+	switch (input.type.InternalType()) {
+	case PhysicalType::INT8:
+		return TemplatedSelect<int8_t>(input, sel, count);
+	case PhysicalType::INT16:
+		return TemplatedSelect<int16_t>(input, sel, count);
+	case PhysicalType::INT32:
+		return TemplatedSelect<int32_t>(input, sel, count);
+	case PhysicalType::INT64:
+		return TemplatedSelect<int64_t>(input, sel, count);
+	default:
+		throw InvalidTypeException(input.type, "Invalid type for join filter");
+	}
+}
+
+} // namespace duckdb
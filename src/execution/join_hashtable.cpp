@@ -3,10 +3,14 @@
 #include "duckdb/storage/buffer_manager.hpp"
 
 #include "duckdb/common/exception.hpp"
+#include "duckdb/common/limits.hpp"
 #include "duckdb/common/types/null_value.hpp"
 #include "duckdb/common/vector_operations/vector_operations.hpp"
 #include "duckdb/common/vector_operations/unary_executor.hpp"
 #include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/execution/join_filter.hpp"
+
+#include <atomic>
 
 namespace duckdb {
 
@@ -15,7 +19,9 @@ using ScanStructure = JoinHashTable::ScanStructure;
 JoinHashTable::JoinHashTable(BufferManager &buffer_manager, vector<JoinCondition> &conditions,
                              vector<LogicalType> btypes, JoinType type)
     : buffer_manager(buffer_manager), build_types(move(btypes)), equality_size(0), condition_size(0), build_size(0),
-      entry_size(0), tuple_size(0), join_type(type), finalized(false), has_null(false), count(0) {
+      entry_size(0), tuple_size(0), join_type(type), finalized(false), has_null(false), external(false),
+      prefetch(false), tag_pointers(false), perfect(false), perfect_min(0), perfect_range(0), current_group(0), count(0),
+      pinned_block_begin(0), radix_bits(0) {
 	for (auto &condition : conditions) {
 		D_ASSERT(condition.left->return_type == condition.right->return_type);
 		auto type = condition.left->return_type;
@@ -59,21 +65,8 @@ JoinHashTable::JoinHashTable(BufferManager &buffer_manager, vector<JoinCondition
 JoinHashTable::~JoinHashTable() {
 }
 
-void JoinHashTable::ApplyBitmask(Vector &hashes, idx_t count) {
-	if (hashes.vector_type == VectorType::CONSTANT_VECTOR) {
-		D_ASSERT(!ConstantVector::IsNull(hashes));
-		auto indices = ConstantVector::GetData<hash_t>(hashes);
-		*indices = *indices & bitmask;
-	} else {
-		hashes.Normalify(count);
-		auto indices = FlatVector::GetData<hash_t>(hashes);
-		for (idx_t i = 0; i < count; i++) {
-			indices[i] &= bitmask;
-		}
-	}
-}
-
-void JoinHashTable::ApplyBitmask(Vector &hashes, const SelectionVector &sel, idx_t count, Vector &pointers) {
+void JoinHashTable::ApplyBitmask(Vector &hashes, const SelectionVector &sel, idx_t count, Vector &pointers,
+                                 uintptr_t tags[]) {
 	VectorData hdata;
 	hashes.Orrify(count, hdata);
 
@@ -85,6 +78,9 @@ void JoinHashTable::ApplyBitmask(Vector &hashes, const SelectionVector &sel, idx
 		auto hindex = hdata.sel->get_index(rindex);
 		auto hash = hash_data[hindex];
 		result_data[rindex] = main_ht + (hash & bitmask);
+		if (tags) {
+			tags[rindex] = HashTag(hash);
+		}
 	}
 }
 
@@ -352,51 +348,102 @@ void JoinHashTable::Build(DataChunk &keys, DataChunk &payload) {
 	SerializeVector(hash_values, payload.size(), *current_sel, added_count, key_locations);
 }
 
-void JoinHashTable::InsertHashes(Vector &hashes, idx_t count, data_ptr_t key_locations[]) {
-	D_ASSERT(hashes.type.id() == LogicalTypeId::HASH);
+void JoinHashTable::Merge(JoinHashTable &other) {
+	D_ASSERT(!finalized && !other.finalized);
+	lock_guard<mutex> append_lock(ht_lock);
+	count += other.count;
+	has_null = has_null || other.has_null;
+	for (auto &block : other.blocks) {
+		blocks.push_back(move(block));
+	}
+	string_heap.MergeHeap(other.string_heap);
 
-	// use bitmask to get position in array
-	ApplyBitmask(hashes, count);
+	other.blocks.clear();
+	other.count = 0;
+}
 
+void JoinHashTable::InsertHashes(Vector &hashes, idx_t count, data_ptr_t key_locations[], bool parallel) {
+	D_ASSERT(hashes.type.id() == LogicalTypeId::HASH);
 	hashes.Normalify(count);
 
 	D_ASSERT(hashes.vector_type == VectorType::FLAT_VECTOR);
-	auto pointers = (data_ptr_t *)hash_map->node->buffer;
-	auto indices = FlatVector::GetData<hash_t>(hashes);
+	auto pointers = (uintptr_t *)hash_map->node->buffer;
+	auto hash_data = FlatVector::GetData<hash_t>(hashes);
+	if (parallel) {
+		// other threads insert into the same hash map: swap in the pointer to the current tuple with a CAS
+		static_assert(sizeof(std::atomic<uintptr_t>) == sizeof(uintptr_t), "atomic pointer has a different size");
+		auto atomic_pointers = (std::atomic<uintptr_t> *)pointers;
+		for (idx_t i = 0; i < count; i++) {
+			auto &head = atomic_pointers[hash_data[i] & bitmask];
+			auto prev_pointer = head.load(std::memory_order_relaxed);
+			do {
+				Store<uintptr_t>(prev_pointer, key_locations[i] + pointer_offset);
+			} while (!head.compare_exchange_weak(prev_pointer, TagPointer(key_locations[i], prev_pointer, hash_data[i]),
+			                                     std::memory_order_release, std::memory_order_relaxed));
+		}
+		return;
+	}
 	for (idx_t i = 0; i < count; i++) {
-		auto index = indices[i];
+		auto index = hash_data[i] & bitmask;
 		// set prev in current key to the value (NOTE: this will be nullptr if
 		// there is none)
-		auto prev_pointer = (data_ptr_t *)(key_locations[i] + pointer_offset);
-		Store<data_ptr_t>(pointers[index], (data_ptr_t)prev_pointer);
+		Store<uintptr_t>(pointers[index], key_locations[i] + pointer_offset);
 
 		// set pointer to current tuple
-		pointers[index] = key_locations[i];
+		pointers[index] = TagPointer(key_locations[i], pointers[index], hash_data[i]);
 	}
 }
 
-void JoinHashTable::Finalize() {
-	// the build has finished, now iterate over all the nodes and construct the final hash table
+idx_t JoinHashTable::HashMapCapacity(idx_t count) {
 	// select a HT that has at least 50% empty space
-	idx_t capacity = NextPowerOfTwo(MaxValue<idx_t>(count * 2, (Storage::BLOCK_ALLOC_SIZE / sizeof(data_ptr_t)) + 1));
 	// size needs to be a power of 2
-	D_ASSERT((capacity & (capacity - 1)) == 0);
-	bitmask = capacity - 1;
+	return NextPowerOfTwo(MaxValue<idx_t>(count * 2, (Storage::BLOCK_ALLOC_SIZE / sizeof(data_ptr_t)) + 1));
+}
+
+idx_t JoinHashTable::MemoryBudget() {
+	// the strings of the build side are not stored in the blocks but in the string heap, which is never spilled: it
+	// stays in memory next to the pinned blocks, even if the entries of the HT are partitioned
+	idx_t memory_budget = buffer_manager.GetMaxMemory() / 2;
+	idx_t heap_size = string_heap.SizeInBytes();
+	return heap_size < memory_budget ? memory_budget - heap_size : 1;
+}
+
+void JoinHashTable::InitializeHashMap(idx_t block_begin, idx_t block_end, idx_t capacity) {
+	// release the current hash map and the blocks it points into
+	hash_map.reset();
+	pinned_handles.clear();
+
+	idx_t hash_map_size = capacity * sizeof(data_ptr_t);
+	prefetch = hash_map_size + (block_end - block_begin) * block_capacity * entry_size > PREFETCH_THRESHOLD;
 
 	// allocate the HT and initialize it with all-zero entries
-	hash_map = buffer_manager.Allocate(capacity * sizeof(data_ptr_t));
-	memset(hash_map->node->buffer, 0, capacity * sizeof(data_ptr_t));
+	hash_map = buffer_manager.Allocate(hash_map_size);
+	memset(hash_map->node->buffer, 0, hash_map_size);
 
+	// we pin the blocks and keep them pinned until the hash map is released
+	// this is so that we can keep pointers around to the blocks
+	pinned_block_begin = block_begin;
+	tag_pointers = POINTER_TAGGING;
+	for (idx_t block_idx = block_begin; block_idx < block_end; block_idx++) {
+		pinned_handles.push_back(buffer_manager.Pin(blocks[block_idx].block));
+		// the tags are stored in the upper bits of the pointers: these have to be unused by the addresses of the
+		// entries, which is not the case on e.g. platforms with 57-bit addresses or pointer tagging of their own
+		auto &node = *pinned_handles.back()->node;
+		if (((uintptr_t)(node.buffer + node.size - 1) & ~POINTER_MASK) != 0) {
+			tag_pointers = POINTER_TAGGING;
+		}
+	}
+}
+
+void JoinHashTable::InsertPinnedBlocks(idx_t begin, idx_t end, bool parallel) {
+	D_ASSERT(begin <= end && end <= pinned_handles.size());
 	Vector hashes(LogicalType::HASH);
 	auto hash_data = FlatVector::GetData<hash_t>(hashes);
 	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
 	// now construct the actual hash table; scan the nodes
-	// as we can the nodes we pin all the blocks of the HT and keep them pinned until the HT is destroyed
-	// this is so that we can keep pointers around to the blocks
-	// FIXME: if we cannot keep everything pinned in memory, we could switch to an out-of-memory merge join or so
-	for (auto &block : blocks) {
-		auto handle = buffer_manager.Pin(block.block);
-		data_ptr_t dataptr = handle->node->buffer;
+	for (idx_t pinned_idx = begin; pinned_idx < end; pinned_idx++) {
+		auto &block = blocks[pinned_block_begin + pinned_idx];
+		data_ptr_t dataptr = pinned_handles[pinned_idx]->node->buffer;
 		idx_t entry = 0;
 		while (entry < block.count) {
 			// fetch the next vector of entries from the blocks
@@ -407,13 +454,259 @@ void JoinHashTable::Finalize() {
 				dataptr += entry_size;
 			}
 			// now insert into the hash table
-			InsertHashes(hashes, next, key_locations);
+			InsertHashes(hashes, next, key_locations, parallel);
 
 			entry += next;
 		}
-		pinned_handles.push_back(move(handle));
 	}
+}
+
+void JoinHashTable::AppendEntries(vector<HTDataBlock> &partition, data_ptr_t entries[], idx_t count) {
+	idx_t appended = 0;
+	while (appended < count) {
+		if (partition.empty() || partition.back().count == partition.back().capacity) {
+			// the last block of the partition is full: allocate a new one
+			HTDataBlock new_block;
+			new_block.count = 0;
+			new_block.capacity = block_capacity;
+			new_block.block = buffer_manager.RegisterMemory(block_capacity * entry_size, false);
+			partition.push_back(move(new_block));
+		}
+		// the block is only pinned while appending, so that it can be offloaded afterwards
+		auto &block = partition.back();
+		auto handle = buffer_manager.Pin(block.block);
+		idx_t append_count = MinValue<idx_t>(count - appended, block.capacity - block.count);
+		auto dataptr = handle->node->buffer + block.count * entry_size;
+		for (idx_t i = 0; i < append_count; i++) {
+			memcpy(dataptr, entries[appended + i], entry_size);
+			dataptr += entry_size;
+		}
+		block.count += append_count;
+		appended += append_count;
+	}
+}
+
+void JoinHashTable::PartitionBlocks() {
+	idx_t partition_count = idx_t(1) << radix_bits;
+	vector<vector<HTDataBlock>> partitions(partition_count);
+	partition_counts.assign(partition_count, 0);
+
+	vector<idx_t> offsets(partition_count + 1);
+	idx_t entry_partitions[STANDARD_VECTOR_SIZE];
+	data_ptr_t entries[STANDARD_VECTOR_SIZE];
+	data_ptr_t partitioned_entries[STANDARD_VECTOR_SIZE];
+	for (auto &block : blocks) {
+		auto handle = buffer_manager.Pin(block.block);
+		data_ptr_t dataptr = handle->node->buffer;
+		idx_t entry = 0;
+		while (entry < block.count) {
+			idx_t next = MinValue<idx_t>(STANDARD_VECTOR_SIZE, block.count - entry);
+			// count the amount of entries of every partition in this vector
+			std::fill(offsets.begin(), offsets.end(), 0);
+			for (idx_t i = 0; i < next; i++) {
+				entry_partitions[i] = GetPartition(Load<hash_t>(dataptr + pointer_offset));
+				entries[i] = dataptr;
+				offsets[entry_partitions[i] + 1]++;
+				dataptr += entry_size;
+			}
+			// order the entries by partition
+			for (idx_t p = 0; p < partition_count; p++) {
+				offsets[p + 1] += offsets[p];
+			}
+			for (idx_t i = 0; i < next; i++) {
+				partitioned_entries[offsets[entry_partitions[i]]++] = entries[i];
+			}
+			// offsets[p] now points to the end of partition p: copy the entries to their partitions
+			idx_t partition_begin = 0;
+			for (idx_t p = 0; p < partition_count; p++) {
+				idx_t partition_end = offsets[p];
+				if (partition_end > partition_begin) {
+					AppendEntries(partitions[p], partitioned_entries + partition_begin, partition_end - partition_begin);
+					partition_counts[p] += partition_end - partition_begin;
+				}
+				partition_begin = partition_end;
+			}
+			entry += next;
+		}
+		// all entries of the block have been copied: destroy it
+		handle.reset();
+		block.block.reset();
+	}
+	// place the blocks of the partitions after each other
+	blocks.clear();
+	partition_blocks.push_back(0);
+	for (auto &partition : partitions) {
+		for (auto &block : partition) {
+			blocks.push_back(move(block));
+		}
+		partition_blocks.push_back(blocks.size());
+	}
+}
+
+void JoinHashTable::LoadGroup(idx_t group) {
+	D_ASSERT(external && group < GroupCount());
+	current_group = group;
+	idx_t partition_begin = group_partitions[group];
+	idx_t partition_end = group_partitions[group + 1];
+	idx_t entry_count = 0;
+	for (idx_t p = partition_begin; p < partition_end; p++) {
+		entry_count += partition_counts[p];
+	}
+	idx_t capacity = HashMapCapacity(entry_count);
+	InitializeHashMap(partition_blocks[partition_begin], partition_blocks[partition_end], capacity);
+	bitmask = capacity - 1;
+}
+
+bool JoinHashTable::LoadNextGroup() {
+	D_ASSERT(external);
+	if (current_group + 1 >= GroupCount()) {
+		return false;
+	}
+	LoadGroup(current_group + 1);
+	InsertPinnedBlocks(0, PinnedBlockCount(), false);
+	return true;
+}
+
+void JoinHashTable::ComputeGroups(DataChunk &keys, idx_t groups[]) {
+	D_ASSERT(external);
+	Vector hashes(LogicalType::HASH);
+	Hash(keys, FlatVector::IncrementalSelectionVector, keys.size(), hashes);
+
+	VectorData hdata;
+	hashes.Orrify(keys.size(), hdata);
+	auto hash_data = (hash_t *)hdata.data;
+	for (idx_t i = 0; i < keys.size(); i++) {
+		groups[i] = partition_groups[GetPartition(hash_data[hdata.sel->get_index(i)])];
+	}
+}
+
+void JoinHashTable::Finalize() {
+	PrepareFinalize();
+	InsertPinnedBlocks(0, PinnedBlockCount(), false);
+}
+
+template <class T> bool JoinHashTable::TemplatedInsertPerfect() {
+	auto pointers = (data_ptr_t *)hash_map->node->buffer;
+	for (idx_t pinned_idx = 0; pinned_idx < pinned_handles.size(); pinned_idx++) {
+		auto &block = blocks[pinned_idx];
+		data_ptr_t dataptr = pinned_handles[pinned_idx]->node->buffer;
+		for (idx_t i = 0; i < block.count; i++) {
+			// the key is the first value of the entry, and it is never NULL
+			int64_t key = Load<T>(dataptr);
+			if (key < perfect_min) {
+				return false;
+			}
+			idx_t position = idx_t(key) - idx_t(perfect_min);
+			if (position >= perfect_range || pointers[position]) {
+				// the key is out of range, or it is a duplicate
+				return false;
+			}
+			pointers[position] = dataptr;
+			dataptr += entry_size;
+		}
+	}
+	return true;
+}
+
+bool JoinHashTable::TryFinalizePerfect(int64_t min, idx_t range) {
+	D_ASSERT(!finalized);
+	D_ASSERT(condition_types.size() == 1 && predicates[0] == ExpressionType::COMPARE_EQUAL);
+	D_ASSERT(!null_values_are_equal[0] && !IsRightOuterJoin(join_type));
+	if (count > range) {
+		// the keys cannot be unique
+		return false;
+	}
+	// the hash map is indexed by the key: it should not be much larger than a regular hash map of the entries, and it
+	// should fit in memory together with the blocks
+	idx_t memory_budget = MemoryBudget();
+	idx_t data_size = blocks.size() * block_capacity * entry_size;
+	if (range > HashMapCapacity(count) * 4 || data_size + range * sizeof(data_ptr_t) > memory_budget) {
+		return false;
+	}
+	InitializeHashMap(0, blocks.size(), range);
+	perfect_min = min;
+	perfect_range = range;
+	bool success;
+	switch (condition_types[0].InternalType()) {
+	case PhysicalType::INT8:
+		success = TemplatedInsertPerfect<int8_t>();
+		break;
+	case PhysicalType::INT16:
+		success = TemplatedInsertPerfect<int16_t>();
+		break;
+	case PhysicalType::INT32:
+		success = TemplatedInsertPerfect<int32_t>();
+		break;
+	case PhysicalType::INT64:
+		success = TemplatedInsertPerfect<int64_t>();
+		break;
+	default:
+		throw InternalException("Unsupported type for perfect hash join");
+	}
+	if (!success) {
+		// release the hash map: the HT is finalized as a regular HT instead
+		hash_map.reset();
+		pinned_handles.clear();
+		return false;
+	}
+	// every key is unique: clear the hashes that are stored in the place of the next pointers, so that the chain of
+	// every entry ends after the entry itself
+	auto pointers = (data_ptr_t *)hash_map->node->buffer;
+	for (idx_t position = 0; position < range; position++) {
+		if (pointers[position]) {
+			Store<data_ptr_t>(nullptr, pointers[position] + pointer_offset);
+		}
+	}
+	perfect = true;
+	finalized = true;
+	return true;
+}
+
+void JoinHashTable::PrepareFinalize() {
+	// the build has finished, now check if we can keep all the blocks of the HT pinned in memory
+	idx_t memory_budget = MemoryBudget();
+	idx_t block_size = block_capacity * entry_size;
+	idx_t data_size = blocks.size() * block_size;
+	if (data_size + HashMapCapacity(count) * sizeof(data_ptr_t) <= memory_budget) {
+		// we can: construct the hash table over all the blocks
+		// the blocks are kept pinned until the HT is destroyed
+		idx_t capacity = HashMapCapacity(count);
+		InitializeHashMap(0, blocks.size(), capacity);
+		bitmask = capacity - 1;
+		finalized = true;
+		return;
+	}
+	// we cannot: radix partition the entries, so that every partition is a fraction of the memory budget
+	external = true;
+	radix_bits = 1;
+	while (radix_bits < MAX_RADIX_BITS && (idx_t(1) << radix_bits) * memory_budget < data_size * 4) {
+		radix_bits++;
+	}
+	PartitionBlocks();
+
+	// now greedily divide the partitions into groups that fit in the memory budget
+	idx_t partition_count = idx_t(1) << radix_bits;
+	idx_t group_blocks = 0;
+	idx_t group_count = 0;
+	group_partitions.push_back(0);
+	for (idx_t p = 0; p < partition_count; p++) {
+		idx_t block_count = partition_blocks[p + 1] - partition_blocks[p];
+		idx_t group_size = (group_blocks + block_count) * block_size +
+		                   HashMapCapacity(group_count + partition_counts[p]) * sizeof(data_ptr_t);
+		if (p > group_partitions.back() && group_size > memory_budget) {
+			// the partition does not fit in the current group anymore: start a new group
+			group_partitions.push_back(p);
+			group_blocks = 0;
+			group_count = 0;
+		}
+		group_blocks += block_count;
+		group_count += partition_counts[p];
+		partition_groups.push_back(group_partitions.size() - 1);
+	}
+	group_partitions.push_back(partition_count);
 
+	// pin the first group, the other groups are pinned once the first group has been probed
+	LoadGroup(0);
 	finalized = true;
 }
 
@@ -436,28 +729,93 @@ unique_ptr<ScanStructure> JoinHashTable::Probe(DataChunk &keys) {
 		return ss;
 	}
 
+	if (perfect) {
+		// look up the entries by their key directly
+		auto pointers = FlatVector::GetData<data_ptr_t>(ss->pointers);
+		switch (condition_types[0].InternalType()) {
+		case PhysicalType::INT8:
+			ss->count = TemplatedProbePerfect<int8_t>(ss->key_data[0], *current_sel, ss->count, pointers, ss->sel_vector);
+			break;
+		case PhysicalType::INT16:
+			ss->count =
+			    TemplatedProbePerfect<int16_t>(ss->key_data[0], *current_sel, ss->count, pointers, ss->sel_vector);
+			break;
+		case PhysicalType::INT32:
+			ss->count =
+			    TemplatedProbePerfect<int32_t>(ss->key_data[0], *current_sel, ss->count, pointers, ss->sel_vector);
+			break;
+		case PhysicalType::INT64:
+			ss->count =
+			    TemplatedProbePerfect<int64_t>(ss->key_data[0], *current_sel, ss->count, pointers, ss->sel_vector);
+			break;
+		default:
+			throw InternalException("Unsupported type for perfect hash join");
+		}
+		ss->PrefetchEntries();
+		return ss;
+	}
+
 	// hash all the keys
 	Vector hashes(LogicalType::HASH);
 	Hash(keys, *current_sel, ss->count, hashes);
 
 	// now initialize the pointers of the scan structure based on the hashes
-	ApplyBitmask(hashes, *current_sel, ss->count, ss->pointers);
+	if (tag_pointers) {
+		ss->tags = unique_ptr<uintptr_t[]>(new uintptr_t[STANDARD_VECTOR_SIZE]);
+	}
+	ApplyBitmask(hashes, *current_sel, ss->count, ss->pointers, ss->tags.get());
 
-	// create the selection vector linking to only non-empty entries
-	idx_t count = 0;
+	// the probe is done one stage at a time for the entire vector, and for a large HT every stage first prefetches the
+	// memory that the next stage accesses: the cache misses of all the rows then overlap, instead of being incurred one
+	// after another. first prefetch the buckets of all rows
 	auto pointers = FlatVector::GetData<data_ptr_t>(ss->pointers);
+	if (prefetch) {
+		for (idx_t i = 0; i < ss->count; i++) {
+			Prefetch(pointers[current_sel->get_index(i)]);
+		}
+	}
+
+	// create the selection vector linking to only the chains that can contain the hash
+	idx_t count = 0;
 	for (idx_t i = 0; i < ss->count; i++) {
 		auto idx = current_sel->get_index(i);
-		auto chain_pointer = (data_ptr_t *)(pointers[idx]);
-		pointers[idx] = *chain_pointer;
+		auto chain_pointer = (uintptr_t *)(pointers[idx]);
+		if (ss->tags) {
+			pointers[idx] = FollowPointer(*chain_pointer, ss->tags[idx]);
+		} else {
+			pointers[idx] = (data_ptr_t)*chain_pointer;
+		}
 		if (pointers[idx]) {
 			ss->sel_vector.set_index(count++, idx);
 		}
 	}
 	ss->count = count;
+	// then prefetch the entries at the start of the chains, before their keys are compared
+	ss->PrefetchEntries();
 	return ss;
 }
 
+template <class T>
+idx_t JoinHashTable::TemplatedProbePerfect(VectorData &key_data, const SelectionVector &sel, idx_t count,
+                                           data_ptr_t pointers[], SelectionVector &result_sel) {
+	auto keys = (T *)key_data.data;
+	auto hash_map_pointers = (data_ptr_t *)hash_map->node->buffer;
+	idx_t result_count = 0;
+	for (idx_t i = 0; i < count; i++) {
+		auto idx = sel.get_index(i);
+		int64_t key = keys[key_data.sel->get_index(idx)];
+		if (key < perfect_min) {
+			continue;
+		}
+		idx_t position = idx_t(key) - idx_t(perfect_min);
+		if (position < perfect_range && hash_map_pointers[position]) {
+			pointers[idx] = hash_map_pointers[position];
+			result_sel.set_index(result_count++, idx);
+		}
+	}
+	return result_count;
+}
+
 ScanStructure::ScanStructure(JoinHashTable &ht) : sel_vector(STANDARD_VECTOR_SIZE), ht(ht), finished(false) {
 	pointers.Initialize(LogicalType::POINTER);
 }
@@ -566,6 +924,13 @@ static idx_t GatherSwitch(VectorData &data, PhysicalType type, Vector &pointers,
 
 template <bool NO_MATCH_SEL>
 idx_t ScanStructure::ResolvePredicates(DataChunk &keys, SelectionVector *match_sel, SelectionVector *no_match_sel) {
+	if (ht.perfect) {
+		// the entries of a perfect HT are looked up by their key: every entry matches
+		for (idx_t i = 0; i < this->count; i++) {
+			match_sel->set_index(i, sel_vector.get_index(i));
+		}
+		return this->count;
+	}
 	SelectionVector *current_sel = &this->sel_vector;
 	idx_t remaining_count = this->count;
 	idx_t offset = 0;
@@ -646,19 +1011,38 @@ idx_t ScanStructure::ScanInnerJoin(DataChunk &keys, SelectionVector &result_vect
 	}
 }
 
+void ScanStructure::PrefetchEntries() {
+	if (!ht.prefetch) {
+		return;
+	}
+	auto ptrs = FlatVector::GetData<data_ptr_t>(this->pointers);
+	for (idx_t i = 0; i < this->count; i++) {
+		auto idx = sel_vector.get_index(i);
+		// the keys are at the start of the entry, the next pointer is at the end
+		Prefetch(ptrs[idx]);
+		Prefetch(ptrs[idx] + ht.pointer_offset);
+	}
+}
+
 void ScanStructure::AdvancePointers(const SelectionVector &sel, idx_t sel_count) {
 	// now for all the pointers, we move on to the next set of pointers
 	idx_t new_count = 0;
 	auto ptrs = FlatVector::GetData<data_ptr_t>(this->pointers);
 	for (idx_t i = 0; i < sel_count; i++) {
 		auto idx = sel.get_index(i);
-		auto chain_pointer = (data_ptr_t *)(ptrs[idx] + ht.pointer_offset);
-		ptrs[idx] = Load<data_ptr_t>((data_ptr_t)chain_pointer);
+		auto chain_pointer = ptrs[idx] + ht.pointer_offset;
+		if (tags) {
+			ptrs[idx] = JoinHashTable::FollowPointer(Load<uintptr_t>(chain_pointer), tags[idx]);
+		} else {
+			// the pointers are not tagged, or this is the entry of a perfect HT that has no next entry
+			ptrs[idx] = Load<data_ptr_t>(chain_pointer);
+		}
 		if (ptrs[idx]) {
 			this->sel_vector.set_index(new_count++, idx);
 		}
 	}
 	this->count = new_count;
+	PrefetchEntries();
 }
 
 void ScanStructure::AdvancePointers() {
@@ -1024,10 +1408,14 @@ void JoinHashTable::ScanFullOuter(DataChunk &result, JoinHTScanState &state) {
 	// scan the HT starting from the current position and check which rows from the build side did not find a match
 	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
 	idx_t found_entries = 0;
-	for (; state.block_position < blocks.size(); state.block_position++, state.position = 0) {
+	// the blocks are not necessarily pinned if the HT is external: pin them until the result has been gathered
+	vector<unique_ptr<BufferHandle>> handles;
+	idx_t block_end = MinValue<idx_t>(state.block_end, blocks.size());
+	for (; state.block_position < block_end; state.block_position++, state.position = 0) {
 		auto &block = blocks[state.block_position];
-		auto &handle = pinned_handles[state.block_position];
+		auto handle = buffer_manager.Pin(block.block);
 		auto baseptr = handle->node->buffer;
+		idx_t block_entries = found_entries;
 		for (; state.position < block.count; state.position++) {
 			auto tuple_base = baseptr + state.position * entry_size;
 			auto found_match = (bool *)(tuple_base + tuple_size);
@@ -1039,6 +1427,9 @@ void JoinHashTable::ScanFullOuter(DataChunk &result, JoinHTScanState &state) {
 				}
 			}
 		}
+		if (found_entries > block_entries) {
+			handles.push_back(move(handle));
+		}
 		if (found_entries == STANDARD_VECTOR_SIZE) {
 			break;
 		}
@@ -1062,4 +1453,105 @@ void JoinHashTable::ScanFullOuter(DataChunk &result, JoinHTScanState &state) {
 	}
 }
 
+void JoinHashTable::ScanEntries(JoinHTScanState &state, DataChunk &keys, DataChunk &payload) {
+	D_ASSERT(keys.ColumnCount() == condition_types.size() && payload.ColumnCount() == build_types.size());
+	keys.Reset();
+	payload.Reset();
+	data_ptr_t key_locations[STANDARD_VECTOR_SIZE];
+	idx_t found_entries = 0;
+	// pin the blocks until the entries have been gathered
+	vector<unique_ptr<BufferHandle>> handles;
+	for (; state.block_position < blocks.size(); state.block_position++, state.position = 0) {
+		auto &block = blocks[state.block_position];
+		if (state.position >= block.count) {
+			continue;
+		}
+		auto handle = buffer_manager.Pin(block.block);
+		auto baseptr = handle->node->buffer;
+		idx_t next = MinValue<idx_t>(STANDARD_VECTOR_SIZE - found_entries, block.count - state.position);
+		for (idx_t i = 0; i < next; i++) {
+			key_locations[found_entries++] = baseptr + (state.position + i) * entry_size;
+		}
+		state.position += next;
+		handles.push_back(move(handle));
+		if (found_entries == STANDARD_VECTOR_SIZE) {
+			break;
+		}
+	}
+	keys.SetCardinality(found_entries);
+	payload.SetCardinality(found_entries);
+	if (found_entries == 0) {
+		return;
+	}
+	idx_t offset = 0;
+	for (idx_t i = 0; i < condition_types.size(); i++) {
+		GatherResultVector(keys.data[i], FlatVector::IncrementalSelectionVector, (uintptr_t *)key_locations,
+		                   FlatVector::IncrementalSelectionVector, found_entries, offset);
+	}
+	for (idx_t i = 0; i < build_types.size(); i++) {
+		GatherResultVector(payload.data[i], FlatVector::IncrementalSelectionVector, (uintptr_t *)key_locations,
+		                   FlatVector::IncrementalSelectionVector, found_entries, offset);
+	}
+}
+
+template <class T> void JoinHashTable::TemplatedBuildJoinFilter(JoinFilter &filter, idx_t key_offset) {
+	T min = NumericLimits<T>::Maximum();
+	T max = NumericLimits<T>::Minimum();
+	hash_t hashes[STANDARD_VECTOR_SIZE];
+	for (auto &block : blocks) {
+		// the blocks of an external HT are not all pinned: pin every block while reading its keys
+		auto handle = buffer_manager.Pin(block.block);
+		data_ptr_t dataptr = handle->node->buffer + key_offset;
+		idx_t entry = 0;
+		while (entry < block.count) {
+			idx_t next = MinValue<idx_t>(STANDARD_VECTOR_SIZE, block.count - entry);
+			for (idx_t i = 0; i < next; i++) {
+				// join filters are only built for joins that do not store keys with NULL values: all keys are valid
+				auto key = Load<T>(dataptr);
+				min = LessThan::Operation(key, min) ? key : min;
+				max = GreaterThan::Operation(key, max) ? key : max;
+				hashes[i] = duckdb::Hash<T>(key);
+				dataptr += entry_size;
+			}
+			filter.InsertHashes(hashes, next);
+			entry += next;
+		}
+	}
+	auto min_value = Value::MinimumValue(filter.type);
+	min_value.GetValueUnsafe<T>() = min;
+	auto max_value = Value::MaximumValue(filter.type);
+	max_value.GetValueUnsafe<T>() = max;
+	filter.Publish(move(min_value), move(max_value));
+}
+
+void JoinHashTable::BuildJoinFilter(JoinFilter &filter) {
+	D_ASSERT(filter.key_index < condition_types.size() && !null_values_are_equal[filter.key_index]);
+	D_ASSERT(filter.type == condition_types[filter.key_index]);
+	if (count == 0) {
+		return;
+	}
+	filter.InitializeBloomFilter(count);
+	// the keys are serialized in the order of the conditions at the start of every entry
+	idx_t key_offset = 0;
+	for (idx_t i = 0; i < filter.key_index; i++) {
+		key_offset += GetTypeIdSize(condition_types[i].InternalType());
+	}
+	switch (filter.type.InternalType()) {
+	case PhysicalType::INT8:
+		TemplatedBuildJoinFilter<int8_t>(filter, key_offset);
+		break;
+	case PhysicalType::INT16:
+		TemplatedBuildJoinFilter<int16_t>(filter, key_offset);
+		break;
+	case PhysicalType::INT32:
+		TemplatedBuildJoinFilter<int32_t>(filter, key_offset);
+		break;
+	case PhysicalType::INT64:
+		TemplatedBuildJoinFilter<int64_t>(filter, key_offset);
+		break;
+	default:
+		throw InternalException("Unsupported type for join filter");
+	}
+}
+
 } // namespace duckdb
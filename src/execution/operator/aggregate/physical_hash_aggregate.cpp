@@ -4,12 +4,16 @@
 #include "duckdb/execution/partitionable_hashtable.hpp"
 
 #include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/executor.hpp"
 #include "duckdb/parallel/pipeline.hpp"
+#include "duckdb/parallel/task_context.hpp"
 #include "duckdb/parallel/task_scheduler.hpp"
 #include "duckdb/planner/expression/bound_aggregate_expression.hpp"
 #include "duckdb/planner/expression/bound_constant_expression.hpp"
 #include "duckdb/catalog/catalog_entry/aggregate_function_catalog_entry.hpp"
 #include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
 
 namespace duckdb {
 
@@ -21,7 +25,8 @@ PhysicalHashAggregate::PhysicalHashAggregate(ClientContext &context, vector<Logi
 PhysicalHashAggregate::PhysicalHashAggregate(ClientContext &context, vector<LogicalType> types,
                                              vector<unique_ptr<Expression>> expressions,
                                              vector<unique_ptr<Expression>> groups_p, PhysicalOperatorType type)
-    : PhysicalSink(type, types), groups(move(groups_p)), all_combinable(true), any_distinct(false) {
+    : PhysicalSink(type, types), groups(move(groups_p)), all_combinable(true), any_distinct(false),
+      estimated_cardinality(0) {
 	// get a list of all aggregates to be computed
 	// fake a single group with a constant value for aggregation without groups
 	if (this->groups.size() == 0) {
@@ -65,7 +70,41 @@ class HashAggregateGlobalState : public GlobalOperatorState {
 public:
 	HashAggregateGlobalState(PhysicalHashAggregate &_op, ClientContext &context)
 	    : op(_op), is_empty(true), lossy_total_groups(0),
-	      partition_info((idx_t)TaskScheduler::GetScheduler(context).NumberOfThreads()) {
+	      threads((idx_t)TaskScheduler::GetScheduler(context).NumberOfThreads()), partition_info(threads),
+	      memory_budget(BufferManager::GetBufferManager(context).GetMaxMemory() / 2),
+	      tuple_size(op.EstimatedTupleSize()), external(false), max_ht_groups(NumericLimits<idx_t>::Maximum()),
+	      ht_memory(0), next_partition(0) {
+		if (!op.all_combinable) {
+			// these are aggregated in a single HT
+			return;
+		}
+		auto ht_size = op.estimated_cardinality * tuple_size;
+		if (ht_size > memory_budget) {
+			// the groups are not expected to fit in memory
+			SetExternal(ht_size, true);
+		}
+	}
+
+	//! Switch to external aggregation, where the HTs are unpinned once they are full or finalized. If repartition is
+	//! set, enough partitions are used so that every thread can combine its partition of ht_size bytes of groups
+	//! within the memory budget; this is only allowed while there are no thread-local HTs yet. Returns false if the
+	//! memory budget cannot keep a HT per partition in memory for every thread.
+	bool SetExternal(idx_t ht_size, bool repartition) {
+		// every thread needs to be able to keep a HT per partition in memory
+		auto affordable_partitions = memory_budget / (threads * 2 * Storage::BLOCK_ALLOC_SIZE);
+		if (affordable_partitions < 2) {
+			return false;
+		}
+		if (repartition) {
+			auto required_partitions = NextPowerOfTwo((ht_size * threads + memory_budget - 1) / memory_budget);
+			auto n_partitions = MinValue<idx_t>(required_partitions, affordable_partitions);
+			partition_info = RadixPartitionInfo(MaxValue<idx_t>(n_partitions, MaxValue<idx_t>(threads, 2)));
+		}
+		// cap the thread-local HTs so they can be unpinned and spilled once they are full
+		max_ht_groups = MaxValue<idx_t>(memory_budget / (threads * partition_info.n_partitions * tuple_size),
+		                                STANDARD_VECTOR_SIZE);
+		external = true;
+		return true;
 	}
 
 	PhysicalHashAggregate &op;
@@ -79,7 +118,23 @@ public:
 	//! a counter to determine if we should switch over to p
 	idx_t lossy_total_groups;
 
+	idx_t threads;
 	RadixPartitionInfo partition_info;
+	//! The amount of memory the HTs can use before the aggregation switches to external mode
+	idx_t memory_budget;
+	//! The estimated size of a single group
+	idx_t tuple_size;
+	//! Whether or not the HTs are unpinned when they are full or finalized, so they can be spilled to disk. This is
+	//! decided up front from the estimated cardinality, or during Sink once the HTs exceed the memory budget. Only the
+	//! blocks of the HTs are spilled: their string heaps and aggregate states allocated on the heap stay in memory, and
+	//! partitions can exceed the budget if the amount of partitions was fixed before the groups turned out not to fit
+	std::atomic<bool> external;
+	//! The maximum amount of groups in a thread-local HT
+	idx_t max_ht_groups;
+	//! The amount of memory held by the thread-local HTs, as last reported by the threads
+	std::atomic<idx_t> ht_memory;
+	//! The next partition to be finalized
+	std::atomic<idx_t> next_partition;
 };
 
 class HashAggregateLocalState : public LocalSinkState {
@@ -102,6 +157,8 @@ public:
 	DataChunk aggregate_input_chunk;
 	//! The aggregate HT
 	unique_ptr<PartitionableHashTable> ht;
+	//! The size of the HT that was last added to the global HT memory
+	idx_t reported_memory = 0;
 
 	//! Whether or not any tuples were added to the HT
 	bool is_empty;
@@ -146,8 +203,9 @@ void PhysicalHashAggregate::Sink(ExecutionContext &context, GlobalOperatorState
 	aggregate_input_chunk.Verify();
 	D_ASSERT(aggregate_input_chunk.ColumnCount() == 0 || group_chunk.size() == aggregate_input_chunk.size());
 
-	// if we have non-combinable aggregates (e.g. string_agg) or any distinct aggregates we cannot keep parallel hash
-	// tables
+	// if we have non-combinable aggregates (e.g. user-defined aggregates without a combine function) or a single
+	// partition we cannot keep parallel hash tables
+	unique_ptr<GroupedAggregateHashTable> ht;
 	if (ForceSingleHT(state)) {
 		lock_guard<mutex> glock(gstate.lock);
 		gstate.is_empty = gstate.is_empty && group_chunk.size() == 0;
@@ -158,11 +216,26 @@ void PhysicalHashAggregate::Sink(ExecutionContext &context, GlobalOperatorState
 		}
 		D_ASSERT(gstate.finalized_hts.size() == 1);
 		gstate.lossy_total_groups += gstate.finalized_hts[0]->AddChunk(group_chunk, aggregate_input_chunk);
+		if (!all_combinable) {
+			return;
+		}
+		auto ht_size = gstate.finalized_hts[0]->SizeInBytes();
+		// the estimate was too low, and the groups do not fit in memory: partition the groups so far, and
+		// continue with thread-local HTs that are spilled to disk once they are full. We reserve room for
+		// four times the current size, as the rest of the input is unknown.
+		if (ht_size <= gstate.memory_budget || !gstate.SetExternal(ht_size * 4, true)) {
+			return;
+		}
+		ht = move(gstate.finalized_hts[0]);
+		gstate.finalized_hts.clear();
+	}
+	if (ht) {
+		ht->Finalize();
+		CombineHT(context.client, state, move(ht));
 		return;
 	}
 
 	D_ASSERT(all_combinable);
-	D_ASSERT(!any_distinct);
 
 	if (group_chunk.size() > 0) {
 		llstate.is_empty = false;
@@ -170,19 +243,37 @@ void PhysicalHashAggregate::Sink(ExecutionContext &context, GlobalOperatorState
 
 	if (!llstate.ht) {
 		llstate.ht = make_unique<PartitionableHashTable>(BufferManager::GetBufferManager(context.client),
-		                                                 gstate.partition_info, group_types, payload_types, bindings);
+		                                                 gstate.partition_info, group_types, payload_types, bindings,
+		                                                 gstate.max_ht_groups);
 	}
 
 	gstate.lossy_total_groups +=
 	    llstate.ht->AddChunk(group_chunk, aggregate_input_chunk,
 	                         gstate.lossy_total_groups > radix_limit && gstate.partition_info.n_partitions > 1);
+
+	if (!gstate.external) {
+		// the estimate might have been too low: switch to external mode once the HTs exceed the memory budget. The
+		// partitions are already in use by the thread-local HTs, so their amount cannot change anymore
+		auto ht_size = llstate.ht->SizeInBytes();
+		auto total_size = gstate.ht_memory += ht_size - llstate.reported_memory;
+		llstate.reported_memory = ht_size;
+		if (total_size > gstate.memory_budget) {
+			lock_guard<mutex> glock(gstate.lock);
+			if (!gstate.external) {
+				gstate.SetExternal(total_size, false);
+			}
+		}
+	}
+	if (gstate.external && !llstate.ht->IsExternal()) {
+		llstate.ht->SetMaxGroups(gstate.max_ht_groups);
+	}
 }
 
 class PhysicalHashAggregateState : public PhysicalOperatorState {
 public:
 	PhysicalHashAggregateState(PhysicalOperator &op, vector<LogicalType> &group_types,
 	                           vector<LogicalType> &aggregate_types, PhysicalOperator *child)
-	    : PhysicalOperatorState(op, child), ht_index(0), ht_scan_position(0) {
+	    : PhysicalOperatorState(op, child), ht_index(0), ht_scan_position(0), ht_scan_end(0) {
 		auto scan_chunk_types = group_types;
 		for (auto &aggr_type : aggregate_types) {
 			scan_chunk_types.push_back(aggr_type);
@@ -196,6 +287,10 @@ public:
 	//! The current position to scan the HT for output tuples
 	idx_t ht_index;
 	idx_t ht_scan_position;
+	//! The end of the block of the HT that is assigned to this thread, if the HTs are scanned in parallel
+	idx_t ht_scan_end;
+	//! The pin of the assigned block
+	unique_ptr<BufferHandle> ht_block;
 };
 
 void PhysicalHashAggregate::Combine(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate) {
@@ -221,7 +316,6 @@ void PhysicalHashAggregate::Combine(ExecutionContext &context, GlobalOperatorSta
 
 	lock_guard<mutex> glock(gstate.lock);
 	D_ASSERT(all_combinable);
-	D_ASSERT(!any_distinct);
 
 	if (!llstate.is_empty) {
 		gstate.is_empty = false;
@@ -234,26 +328,72 @@ void PhysicalHashAggregate::Combine(ExecutionContext &context, GlobalOperatorSta
 	gstate.intermediate_hts.push_back(move(llstate.ht));
 }
 
+void PhysicalHashAggregate::CombineHT(ClientContext &context, GlobalOperatorState &state,
+                                      unique_ptr<GroupedAggregateHashTable> ht) {
+	auto &gstate = (HashAggregateGlobalState &)state;
+	if (ht->Size() == 0) {
+		return;
+	}
+	if (ForceSingleHT(state)) {
+		lock_guard<mutex> glock(gstate.lock);
+		gstate.is_empty = false;
+		if (gstate.finalized_hts.size() == 0) {
+			gstate.finalized_hts.push_back(move(ht));
+		} else {
+			gstate.finalized_hts[0]->Combine(*ht);
+		}
+		return;
+	}
+	auto pht = make_unique<PartitionableHashTable>(BufferManager::GetBufferManager(context), gstate.partition_info,
+	                                               group_types, payload_types, bindings, gstate.max_ht_groups);
+	pht->AddHT(move(ht));
+	if (gstate.partition_info.n_partitions > 1 && gstate.lossy_total_groups > radix_limit) {
+		pht->Partition();
+	}
+	pht->Finalize();
+
+	lock_guard<mutex> glock(gstate.lock);
+	gstate.is_empty = false;
+	gstate.intermediate_hts.push_back(move(pht));
+}
+
 // this task is run in multiple threads and combines the radix-partitioned hash tables into a single onen and then
-// folds them into the global ht finally.
+// folds them into the global ht finally. every task keeps finalizing partitions until all of them are done.
 class PhysicalHashAggregateFinalizeTask : public Task {
 public:
-	PhysicalHashAggregateFinalizeTask(Pipeline &parent_, HashAggregateGlobalState &state_, idx_t radix_)
-	    : parent(parent_), state(state_), radix(radix_) {
+	PhysicalHashAggregateFinalizeTask(Pipeline &parent_, HashAggregateGlobalState &state_)
+	    : parent(parent_), state(state_) {
 	}
 	static void FinalizeHT(HashAggregateGlobalState &gstate, idx_t radix) {
 		D_ASSERT(gstate.finalized_hts[radix]);
 		for (auto &pht : gstate.intermediate_hts) {
 			for (auto &ht : pht->GetPartition(radix)) {
+				ht->Pin();
 				gstate.finalized_hts[radix]->Combine(*ht);
 				ht.reset();
 			}
 		}
 		gstate.finalized_hts[radix]->Finalize();
+		if (gstate.external) {
+			// the partition is only needed again when it is scanned
+			gstate.finalized_hts[radix]->Unpin();
+		}
 	}
 
 	void Execute() {
-		FinalizeHT(state, radix);
+		try {
+			while (true) {
+				idx_t radix = state.next_partition++;
+				if (radix >= state.partition_info.n_partitions) {
+					break;
+				}
+				FinalizeHT(state, radix);
+			}
+		} catch (std::exception &ex) {
+			parent.executor.PushError(ex.what());
+		} catch (...) {
+			parent.executor.PushError("Unknown exception in hash aggregate finalize!");
+		}
 		lock_guard<mutex> glock(state.lock);
 		parent.finished_tasks++;
 		// finish the whole pipeline
@@ -265,7 +405,6 @@ public:
 private:
 	Pipeline &parent;
 	HashAggregateGlobalState &state;
-	idx_t radix;
 };
 
 void PhysicalHashAggregate::Finalize(Pipeline &pipeline, ClientContext &context,
@@ -306,23 +445,32 @@ void PhysicalHashAggregate::FinalizeInternal(ClientContext &context, unique_ptr<
 		for (auto &pht : gstate.intermediate_hts) {
 			if (!pht->IsPartitioned()) {
 				pht->Partition();
+				pht->Finalize();
 			}
 		}
-		// schedule additional tasks to combine the partial HTs
-		if (!immediate) {
-			D_ASSERT(pipeline);
-			pipeline->total_tasks += gstate.partition_info.n_partitions;
-		}
 		gstate.finalized_hts.resize(gstate.partition_info.n_partitions);
 		for (idx_t r = 0; r < gstate.partition_info.n_partitions; r++) {
 			gstate.finalized_hts[r] =
 			    make_unique<GroupedAggregateHashTable>(BufferManager::GetBufferManager(context), group_types,
 			                                           payload_types, bindings, HtEntryType::HT_WIDTH_64);
-			if (immediate) {
+		}
+		if (immediate) {
+			for (idx_t r = 0; r < gstate.partition_info.n_partitions; r++) {
 				PhysicalHashAggregateFinalizeTask::FinalizeHT(gstate, r);
-			} else {
-				D_ASSERT(pipeline);
-				auto new_task = make_unique<PhysicalHashAggregateFinalizeTask>(*pipeline, gstate, r);
+			}
+		} else {
+			// schedule additional tasks to combine the partial HTs
+			D_ASSERT(pipeline);
+			auto n_tasks = gstate.partition_info.n_partitions;
+			if (gstate.external) {
+				// only finalize as many partitions at the same time as fit in the memory budget
+				auto partition_size =
+				    MaxValue<idx_t>(gstate.lossy_total_groups * gstate.tuple_size / gstate.partition_info.n_partitions, 1);
+				n_tasks = MinValue<idx_t>(n_tasks, MaxValue<idx_t>(gstate.memory_budget / partition_size, 1));
+			}
+			pipeline->total_tasks += n_tasks;
+			for (idx_t i = 0; i < n_tasks; i++) {
+				auto new_task = make_unique<PhysicalHashAggregateFinalizeTask>(*pipeline, gstate);
 				TaskScheduler::GetScheduler(context).ScheduleTask(pipeline->token, move(new_task));
 			}
 		}
@@ -336,6 +484,7 @@ void PhysicalHashAggregate::FinalizeInternal(ClientContext &context, unique_ptr<
 			auto unpartitioned = pht->GetUnpartitioned();
 			for (auto &unpartitioned_ht : unpartitioned) {
 				D_ASSERT(unpartitioned_ht);
+				unpartitioned_ht->Pin();
 				gstate.finalized_hts[0]->Combine(*unpartitioned_ht);
 				unpartitioned_ht.reset();
 			}
@@ -345,6 +494,83 @@ void PhysicalHashAggregate::FinalizeInternal(ClientContext &context, unique_ptr<
 	}
 }
 
+class HashAggregateParallelState : public ParallelState {
+public:
+	explicit HashAggregateParallelState(idx_t ht_count) : ht_index(0), ht_scan_position(0), active_scans(ht_count, 0) {
+	}
+
+	std::mutex lock;
+	//! The HT of which the blocks are currently handed out, and the position of the next block in that HT
+	idx_t ht_index;
+	idx_t ht_scan_position;
+	//! The amount of threads that are scanning a block of each HT; an HT is released once all of its blocks have been
+	//! handed out and scanned
+	vector<idx_t> active_scans;
+};
+
+unique_ptr<ParallelState> PhysicalHashAggregate::GetParallelState() {
+	auto &gstate = (HashAggregateGlobalState &)*sink_state;
+	return make_unique<HashAggregateParallelState>(gstate.finalized_hts.size());
+}
+
+idx_t PhysicalHashAggregate::MaxThreads(ClientContext &context) {
+	auto &gstate = (HashAggregateGlobalState &)*sink_state;
+	if (gstate.is_empty) {
+		// nothing to scan, or the single row of an implicit aggregate over an empty input
+		return 0;
+	}
+	idx_t block_count = 0;
+	for (auto &ht : gstate.finalized_hts) {
+		block_count += (ht->Size() + ht->TuplesPerBlock() - 1) / ht->TuplesPerBlock();
+	}
+	return MinValue<idx_t>(context.db.NumberOfThreads(), block_count);
+}
+
+idx_t PhysicalHashAggregate::ScanParallel(PhysicalHashAggregateState &state, ParallelState &parallel_state_) {
+	auto &gstate = (HashAggregateGlobalState &)*sink_state;
+	auto &parallel_state = (HashAggregateParallelState &)parallel_state_;
+	while (true) {
+		if (state.ht_scan_position < state.ht_scan_end) {
+			return gstate.finalized_hts[state.ht_index]->ScanBlock(*state.ht_block, state.ht_scan_position,
+			                                                       state.ht_scan_end, state.scan_chunk);
+		}
+		// the assigned block has been scanned: fetch the next one
+		state.ht_block.reset();
+		GroupedAggregateHashTable *ht;
+		{
+			lock_guard<mutex> parallel_lock(parallel_state.lock);
+			if (state.ht_scan_end > 0) {
+				D_ASSERT(parallel_state.active_scans[state.ht_index] > 0);
+				if (--parallel_state.active_scans[state.ht_index] == 0 && state.ht_index < parallel_state.ht_index) {
+					// the last block of this HT has been scanned
+					gstate.finalized_hts[state.ht_index].reset();
+				}
+				state.ht_scan_end = 0;
+			}
+			while (parallel_state.ht_index < gstate.finalized_hts.size() &&
+			       parallel_state.ht_scan_position >= gstate.finalized_hts[parallel_state.ht_index]->Size()) {
+				// all blocks of this HT have been handed out: move to the next one
+				if (parallel_state.active_scans[parallel_state.ht_index] == 0) {
+					gstate.finalized_hts[parallel_state.ht_index].reset();
+				}
+				parallel_state.ht_index++;
+				parallel_state.ht_scan_position = 0;
+			}
+			if (parallel_state.ht_index >= gstate.finalized_hts.size()) {
+				return 0;
+			}
+			ht = gstate.finalized_hts[parallel_state.ht_index].get();
+			state.ht_index = parallel_state.ht_index;
+			state.ht_scan_position = parallel_state.ht_scan_position;
+			state.ht_scan_end = MinValue(state.ht_scan_position + ht->TuplesPerBlock(), ht->Size());
+			parallel_state.ht_scan_position = state.ht_scan_end;
+			parallel_state.active_scans[state.ht_index]++;
+		}
+		// only the assigned block is pinned, so the HT can remain spilled to disk
+		state.ht_block = ht->PinBlock(state.ht_scan_position);
+	}
+}
+
 void PhysicalHashAggregate::GetChunkInternal(ExecutionContext &context, DataChunk &chunk,
                                              PhysicalOperatorState *state_) {
 	auto &gstate = (HashAggregateGlobalState &)*sink_state;
@@ -379,19 +605,32 @@ void PhysicalHashAggregate::GetChunkInternal(ExecutionContext &context, DataChun
 	}
 	idx_t elements_found = 0;
 
-	while (true) {
-		if (state.ht_index == gstate.finalized_hts.size()) {
+	auto parallel_state = context.task.task_info.find(this);
+	if (parallel_state != context.task.task_info.end()) {
+		// other threads are scanning the HTs as well: scan the blocks that are assigned to this thread
+		elements_found = ScanParallel(state, *parallel_state->second);
+		if (elements_found == 0) {
 			state.finished = true;
 			return;
 		}
-		elements_found = gstate.finalized_hts[state.ht_index]->Scan(state.ht_scan_position, state.scan_chunk);
+	} else {
+		while (true) {
+			if (state.ht_index == gstate.finalized_hts.size()) {
+				state.finished = true;
+				return;
+			}
+			auto &ht = *gstate.finalized_hts[state.ht_index];
+			// the HT might have been unpinned after it was finalized
+			ht.Pin();
+			elements_found = ht.Scan(state.ht_scan_position, state.scan_chunk);
 
-		if (elements_found > 0) {
-			break;
+			if (elements_found > 0) {
+				break;
+			}
+			gstate.finalized_hts[state.ht_index].reset();
+			state.ht_index++;
+			state.ht_scan_position = 0;
 		}
-		gstate.finalized_hts[state.ht_index].reset();
-		state.ht_index++;
-		state.ht_scan_position = 0;
 	}
 
 	// compute the final projection list
@@ -418,7 +657,19 @@ unique_ptr<PhysicalOperatorState> PhysicalHashAggregate::GetOperatorState() {
 bool PhysicalHashAggregate::ForceSingleHT(GlobalOperatorState &state) {
 	auto &gstate = (HashAggregateGlobalState &)state;
 
-	return !all_combinable || any_distinct || gstate.partition_info.n_partitions < 2;
+	return !all_combinable || gstate.partition_info.n_partitions < 2;
+}
+
+idx_t PhysicalHashAggregate::EstimatedTupleSize() {
+	// every group stores its hash, the group values and the aggregate states, and has entries in the hash table
+	idx_t tuple_size = sizeof(hash_t) + 2 * sizeof(aggr_ht_entry_64);
+	for (auto &group_type : group_types) {
+		tuple_size += GetTypeIdSize(group_type.InternalType());
+	}
+	for (auto &aggr : bindings) {
+		tuple_size += aggr->function.state_size();
+	}
+	return tuple_size;
 }
 
 string PhysicalHashAggregate::ParamsToString() const {
@@ -1,9 +1,13 @@
 #include "duckdb/execution/operator/aggregate/physical_perfecthash_aggregate.hpp"
 #include "duckdb/execution/perfect_aggregate_hashtable.hpp"
+#include "duckdb/execution/aggregate_hashtable.hpp"
 #include "duckdb/storage/statistics/numeric_statistics.hpp"
 #include "duckdb/storage/buffer_manager.hpp"
 #include "duckdb/planner/expression/bound_aggregate_expression.hpp"
 #include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/common/types/string_heap.hpp"
 
 namespace duckdb {
 
@@ -13,18 +17,28 @@ PhysicalPerfectHashAggregate::PhysicalPerfectHashAggregate(ClientContext &contex
                                                            vector<unique_ptr<BaseStatistics>> group_stats,
                                                            vector<idx_t> required_bits_p)
     : PhysicalSink(PhysicalOperatorType::PERFECT_HASH_GROUP_BY, move(types_p)), groups(move(groups_p)),
-      aggregates(move(aggregates_p)), required_bits(move(required_bits_p)) {
+      aggregates(move(aggregates_p)), has_dictionary_groups(false), required_bits(move(required_bits_p)) {
 	D_ASSERT(groups.size() == group_stats.size());
 	group_minima.reserve(group_stats.size());
-	for (auto &stats : group_stats) {
+	for (idx_t group_idx = 0; group_idx < groups.size(); group_idx++) {
+		auto &group_type = groups[group_idx]->return_type;
+		group_types.push_back(group_type);
+		if (group_type.id() == LogicalTypeId::VARCHAR) {
+			// strings are stored in the HT as their id in the dictionary, which starts at 1
+			dictionary_encoded.push_back(true);
+			has_dictionary_groups = true;
+			ht_group_types.push_back(LogicalType::INTEGER);
+			group_minima.push_back(Value::INTEGER(1));
+			continue;
+		}
+		auto &stats = group_stats[group_idx];
 		D_ASSERT(stats);
 		auto &nstats = (NumericStatistics &)*stats;
 		D_ASSERT(!nstats.min.is_null);
+		dictionary_encoded.push_back(false);
+		ht_group_types.push_back(group_type);
 		group_minima.push_back(move(nstats.min));
 	}
-	for (auto &expr : groups) {
-		group_types.push_back(expr->return_type);
-	}
 
 	vector<BoundAggregateExpression *> bindings;
 	for (auto &expr : aggregates) {
@@ -40,42 +54,151 @@ PhysicalPerfectHashAggregate::PhysicalPerfectHashAggregate(ClientContext &contex
 		}
 	}
 	aggregate_objects = AggregateObject::CreateAggregateObjects(move(bindings));
+
+	if (has_dictionary_groups) {
+		// the dictionaries can fill up while the query runs: the remaining rows are aggregated by a hash aggregate
+		vector<unique_ptr<Expression>> overflow_groups;
+		for (auto &group : groups) {
+			overflow_groups.push_back(group->Copy());
+		}
+		vector<unique_ptr<Expression>> overflow_aggregates;
+		for (auto &aggr : aggregates) {
+			overflow_aggregates.push_back(aggr->Copy());
+		}
+		overflow_aggregate =
+		    make_unique<PhysicalHashAggregate>(context, types, move(overflow_aggregates), move(overflow_groups));
+	}
 }
 
 unique_ptr<PerfectAggregateHashTable> PhysicalPerfectHashAggregate::CreateHT(ClientContext &context) {
-	return make_unique<PerfectAggregateHashTable>(BufferManager::GetBufferManager(context), group_types, payload_types,
-	                                              aggregate_objects, group_minima, required_bits);
+	return make_unique<PerfectAggregateHashTable>(BufferManager::GetBufferManager(context), ht_group_types,
+	                                              payload_types, aggregate_objects, group_minima, required_bits);
 }
 
+//===--------------------------------------------------------------------===//
+// Dictionary
+//===--------------------------------------------------------------------===//
+struct StringHash {
+	std::size_t operator()(const string_t &val) const {
+		return Hash(val);
+	}
+};
+
+struct StringEquality {
+	bool operator()(const string_t &a, const string_t &b) const {
+		return Equals::Operation(a, b);
+	}
+};
+
+//! Maps strings to their dictionary id, the strings are looked up without copying them into a std::string
+using dictionary_id_map_t = unordered_map<string_t, uint32_t, StringHash, StringEquality>;
+
+//! The dictionary of a string group, mapping every string to an id in the range [1, capacity]. The id 0 is reserved
+//! for NULL.
+struct PerfectHashGroupDictionary {
+	//! The id returned for strings that are not in the dictionary when it is full
+	static constexpr uint32_t OVERFLOW_ID = 0xFFFFFFFF;
+
+	explicit PerfectHashGroupDictionary(idx_t capacity) : capacity(capacity) {
+	}
+
+	//! The maximum amount of strings in the dictionary
+	idx_t capacity;
+	//! The id of each of the strings
+	dictionary_id_map_t ids;
+	//! The strings, the string with id i is stored at position (i - 1)
+	vector<string_t> strings;
+	//! The heap that owns the strings of the dictionary
+	StringHeap heap;
+
+	bool IsFull() {
+		return strings.size() >= capacity;
+	}
+
+	uint32_t GetOrCreateId(const string_t &str) {
+		auto entry = ids.find(str);
+		if (entry != ids.end()) {
+			return entry->second;
+		}
+		if (IsFull()) {
+			return OVERFLOW_ID;
+		}
+		strings.push_back(heap.AddString(str));
+		uint32_t id = strings.size();
+		ids[strings.back()] = id;
+		return id;
+	}
+};
+
 //===--------------------------------------------------------------------===//
 // Sink
 //===--------------------------------------------------------------------===//
 class PerfectHashAggregateGlobalState : public GlobalOperatorState {
 public:
 	PerfectHashAggregateGlobalState(PhysicalPerfectHashAggregate &op, ClientContext &context)
-	    : ht(op.CreateHT(context)) {
+	    : ht(op.CreateHT(context)), has_overflow(false), skip_dictionaries(false) {
+		for (idx_t group_idx = 0; group_idx < op.groups.size(); group_idx++) {
+			// the id 0 is reserved for NULL
+			idx_t capacity = op.dictionary_encoded[group_idx] ? (idx_t(1) << op.required_bits[group_idx]) - 1 : 0;
+			dictionaries.emplace_back(capacity);
+		}
+		if (op.overflow_aggregate) {
+			overflow_state = op.overflow_aggregate->GetGlobalState(context);
+		}
 	}
 
-	//! The lock for updating the global aggregate state
+	//! The lock for updating the global aggregate state and the dictionaries
 	std::mutex lock;
 	//! The global aggregate hash table
 	unique_ptr<PerfectAggregateHashTable> ht;
+	//! The dictionaries of the dictionary encoded groups (empty for the other groups)
+	vector<PerfectHashGroupDictionary> dictionaries;
+	//! The global state of the overflow aggregate
+	unique_ptr<GlobalOperatorState> overflow_state;
+	//! Whether or not any rows were aggregated by the overflow aggregate
+	bool has_overflow;
+	//! Whether or not all remaining rows are aggregated by the overflow aggregate, because most strings did not fit in
+	//! the dictionaries. The perfect HT is then merged into the overflow aggregate when finalizing.
+	std::atomic<bool> skip_dictionaries;
 };
 
 class PerfectHashAggregateLocalState : public LocalSinkState {
 public:
 	PerfectHashAggregateLocalState(PhysicalPerfectHashAggregate &op, ClientContext &context)
-	    : ht(op.CreateHT(context)) {
+	    : ht(op.CreateHT(context)), sampled_rows(0), sampled_overflow_rows(0), overflow_sampled(false) {
 		group_chunk.InitializeEmpty(op.group_types);
 		if (op.payload_types.size() > 0) {
 			aggregate_input_chunk.InitializeEmpty(op.payload_types);
 		}
+		if (op.has_dictionary_groups) {
+			ht_group_chunk.Initialize(op.ht_group_types);
+			dictionary_ids.resize(op.groups.size());
+			dictionary_full.resize(op.groups.size(), false);
+			overflow_input_chunk.InitializeEmpty(op.children[0]->types);
+		}
 	}
 
 	//! The local aggregate hash table
 	unique_ptr<PerfectAggregateHashTable> ht;
 	DataChunk group_chunk;
 	DataChunk aggregate_input_chunk;
+
+	//! The groups as they are stored in the HT, i.e. with dictionary ids instead of strings
+	DataChunk ht_group_chunk;
+	//! A local copy of the dictionary ids that were looked up, so the global dictionaries are only locked on a miss.
+	//! The strings are owned by the global dictionaries.
+	vector<dictionary_id_map_t> dictionary_ids;
+	//! Whether or not the local copy holds the complete dictionary of a group, because the dictionary is full
+	vector<bool> dictionary_full;
+	//! The rows of the chunk that are aggregated by the overflow aggregate
+	DataChunk overflow_input_chunk;
+	//! The local state of the overflow aggregate (created when the first row overflows)
+	unique_ptr<LocalSinkState> overflow_state;
+	//! The amount of rows that have been added since the first row overflowed, and how many of them overflowed
+	idx_t sampled_rows;
+	idx_t sampled_overflow_rows;
+	//! Whether or not enough rows have been sampled to decide if the dictionaries should be skipped
+	bool overflow_sampled;
 };
 
 unique_ptr<GlobalOperatorState> PhysicalPerfectHashAggregate::GetGlobalState(ClientContext &context) {
@@ -115,7 +238,131 @@ void PhysicalPerfectHashAggregate::Sink(ExecutionContext &context, GlobalOperato
 	aggregate_input_chunk.Verify();
 	D_ASSERT(aggregate_input_chunk.ColumnCount() == 0 || group_chunk.size() == aggregate_input_chunk.size());
 
-	lstate.ht->AddChunk(group_chunk, aggregate_input_chunk);
+	if (!has_dictionary_groups) {
+		lstate.ht->AddChunk(group_chunk, aggregate_input_chunk);
+		return;
+	}
+	auto &gstate = (PerfectHashAggregateGlobalState &)state;
+	if (gstate.skip_dictionaries) {
+		SinkOverflow(context, state, lstate, input);
+		return;
+	}
+	// replace the strings by their dictionary ids, finding the rows that have a string that is not in a dictionary
+	bool row_overflows[STANDARD_VECTOR_SIZE];
+	memset(row_overflows, 0, sizeof(bool) * input.size());
+	auto &ht_group_chunk = lstate.ht_group_chunk;
+	for (idx_t group_idx = 0; group_idx < groups.size(); group_idx++) {
+		if (dictionary_encoded[group_idx]) {
+			EncodeDictionaryGroup(gstate, lstate, group_idx, input.size(), row_overflows);
+		} else {
+			ht_group_chunk.data[group_idx].Reference(group_chunk.data[group_idx]);
+		}
+	}
+	ht_group_chunk.SetCardinality(input.size());
+
+	SelectionVector ht_sel(STANDARD_VECTOR_SIZE);
+	SelectionVector overflow_sel(STANDARD_VECTOR_SIZE);
+	idx_t ht_count = 0;
+	idx_t overflow_count = 0;
+	for (idx_t i = 0; i < input.size(); i++) {
+		if (row_overflows[i]) {
+			overflow_sel.set_index(overflow_count++, i);
+		} else {
+			ht_sel.set_index(ht_count++, i);
+		}
+	}
+	if (!lstate.overflow_sampled && (lstate.sampled_rows > 0 || overflow_count > 0)) {
+		// a dictionary is full: check if most rows overflow
+		lstate.sampled_rows += input.size();
+		lstate.sampled_overflow_rows += overflow_count;
+		if (lstate.sampled_rows >= OVERFLOW_SAMPLE_SIZE) {
+			lstate.overflow_sampled = true;
+			if (double(lstate.sampled_overflow_rows) >= OVERFLOW_SKIP_RATIO * double(lstate.sampled_rows)) {
+				gstate.skip_dictionaries = true;
+			}
+		}
+	}
+	if (overflow_count == 0) {
+		lstate.ht->AddChunk(ht_group_chunk, aggregate_input_chunk);
+		return;
+	}
+	if (ht_count > 0) {
+		DataChunk ht_groups;
+		ht_groups.InitializeEmpty(ht_group_types);
+		ht_groups.Slice(ht_group_chunk, ht_sel, ht_count);
+		DataChunk ht_payload;
+		if (payload_types.size() > 0) {
+			ht_payload.InitializeEmpty(payload_types);
+		}
+		ht_payload.Slice(aggregate_input_chunk, ht_sel, ht_count);
+		lstate.ht->AddChunk(ht_groups, ht_payload);
+	}
+	if (ht_count == 0) {
+		SinkOverflow(context, state, lstate, input);
+		return;
+	}
+	lstate.overflow_input_chunk.Slice(input, overflow_sel, overflow_count);
+	SinkOverflow(context, state, lstate, lstate.overflow_input_chunk);
+}
+
+void PhysicalPerfectHashAggregate::SinkOverflow(ExecutionContext &context, GlobalOperatorState &state,
+                                                LocalSinkState &lstate_p, DataChunk &input) {
+	auto &gstate = (PerfectHashAggregateGlobalState &)state;
+	auto &lstate = (PerfectHashAggregateLocalState &)lstate_p;
+	if (!lstate.overflow_state) {
+		lstate.overflow_state = overflow_aggregate->GetLocalSinkState(context);
+	}
+	// the overflow aggregate computes its groups and payload from the input chunk itself
+	overflow_aggregate->Sink(context, *gstate.overflow_state, *lstate.overflow_state, input);
+}
+
+void PhysicalPerfectHashAggregate::EncodeDictionaryGroup(GlobalOperatorState &state, LocalSinkState &lstate_p,
+                                                         idx_t group_idx, idx_t count, bool row_overflows[]) {
+	auto &gstate = (PerfectHashAggregateGlobalState &)state;
+	auto &lstate = (PerfectHashAggregateLocalState &)lstate_p;
+	auto &local_ids = lstate.dictionary_ids[group_idx];
+
+	VectorData vdata;
+	lstate.group_chunk.data[group_idx].Orrify(count, vdata);
+	auto strings = (string_t *)vdata.data;
+
+	auto &result = lstate.ht_group_chunk.data[group_idx];
+	auto result_data = FlatVector::GetData<int32_t>(result);
+	auto &result_nullmask = FlatVector::Nullmask(result);
+	result_nullmask.reset();
+	for (idx_t i = 0; i < count; i++) {
+		auto idx = vdata.sel->get_index(i);
+		if ((*vdata.nullmask)[idx]) {
+			result_nullmask[i] = true;
+			continue;
+		}
+		auto &str = strings[idx];
+		uint32_t id;
+		auto entry = local_ids.find(str);
+		if (entry != local_ids.end()) {
+			id = entry->second;
+		} else if (lstate.dictionary_full[group_idx]) {
+			// the local copy holds the complete (full) dictionary: the string can never be added
+			id = PerfectHashGroupDictionary::OVERFLOW_ID;
+		} else {
+			lock_guard<mutex> glock(gstate.lock);
+			auto &dictionary = gstate.dictionaries[group_idx];
+			id = dictionary.GetOrCreateId(str);
+			if (id == PerfectHashGroupDictionary::OVERFLOW_ID) {
+				// the dictionary is full and will not change anymore: copy it so we no longer need to lock it
+				local_ids = dictionary.ids;
+				lstate.dictionary_full[group_idx] = true;
+			} else {
+				local_ids[dictionary.strings[id - 1]] = id;
+			}
+		}
+		if (id == PerfectHashGroupDictionary::OVERFLOW_ID) {
+			row_overflows[i] = true;
+			result_data[i] = 0;
+		} else {
+			result_data[i] = id;
+		}
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -126,8 +373,51 @@ void PhysicalPerfectHashAggregate::Combine(ExecutionContext &context, GlobalOper
 	auto &lstate = (PerfectHashAggregateLocalState &)lstate_p;
 	auto &gstate = (PerfectHashAggregateGlobalState &)gstate_p;
 
+	if (lstate.overflow_state) {
+		overflow_aggregate->Combine(context, *gstate.overflow_state, *lstate.overflow_state);
+	}
+
 	lock_guard<mutex> l(gstate.lock);
 	gstate.ht->Combine(*lstate.ht);
+	if (lstate.overflow_state) {
+		gstate.has_overflow = true;
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// Finalize
+//===--------------------------------------------------------------------===//
+void PhysicalPerfectHashAggregate::Finalize(Pipeline &pipeline, ClientContext &context,
+                                            unique_ptr<GlobalOperatorState> state) {
+	// the finalize tasks of the overflow aggregate can finish the pipeline: set the sink state first
+	PhysicalSink::Finalize(pipeline, context, move(state));
+	auto &gstate = (PerfectHashAggregateGlobalState &)*sink_state;
+	if (gstate.skip_dictionaries) {
+		// the groups of the perfect HT can also occur in the overflow aggregate: move them into it
+		auto ht = make_unique<GroupedAggregateHashTable>(BufferManager::GetBufferManager(context), group_types,
+		                                                 payload_types, overflow_aggregate->bindings);
+		DataChunk ht_groups;
+		ht_groups.Initialize(ht_group_types);
+		DataChunk decoded_groups;
+		decoded_groups.Initialize(group_types);
+		Vector state_addresses(LogicalType::POINTER);
+		idx_t scan_position = 0;
+		while (true) {
+			ht_groups.Reset();
+			decoded_groups.Reset();
+			auto count = gstate.ht->ScanGroups(scan_position, ht_groups, state_addresses);
+			if (count == 0) {
+				break;
+			}
+			DecodeGroups(gstate, ht_groups, decoded_groups, count);
+			decoded_groups.SetCardinality(count);
+			ht->CombineStates(decoded_groups, state_addresses);
+		}
+		overflow_aggregate->CombineHT(context, *gstate.overflow_state, move(ht));
+	}
+	if (gstate.has_overflow) {
+		overflow_aggregate->Finalize(pipeline, context, move(gstate.overflow_state));
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -140,6 +430,10 @@ public:
 	}
 	//! The current position to scan the HT for output tuples
 	idx_t ht_scan_position;
+	//! The chunk that the HT is scanned into if the groups have to be decoded
+	DataChunk scan_chunk;
+	//! The state for scanning the overflow aggregate
+	unique_ptr<PhysicalOperatorState> overflow_state;
 };
 
 void PhysicalPerfectHashAggregate::GetChunkInternal(ExecutionContext &context, DataChunk &chunk,
@@ -147,11 +441,69 @@ void PhysicalPerfectHashAggregate::GetChunkInternal(ExecutionContext &context, D
 	auto &state = (PerfectHashAggregateState &)*state_p;
 	auto &gstate = (PerfectHashAggregateGlobalState &)*sink_state;
 
-	gstate.ht->Scan(state.ht_scan_position, chunk);
+	if (!has_dictionary_groups) {
+		gstate.ht->Scan(state.ht_scan_position, chunk);
+		return;
+	}
+	auto &scan_chunk = state.scan_chunk;
+	if (!gstate.skip_dictionaries) {
+		scan_chunk.Reset();
+		gstate.ht->Scan(state.ht_scan_position, scan_chunk);
+		if (scan_chunk.size() > 0) {
+			DecodeGroups(gstate, scan_chunk, chunk, scan_chunk.size());
+			for (idx_t col_idx = groups.size(); col_idx < scan_chunk.ColumnCount(); col_idx++) {
+				chunk.data[col_idx].Reference(scan_chunk.data[col_idx]);
+			}
+			chunk.SetCardinality(scan_chunk.size());
+			return;
+		}
+	}
+	// the perfect HT has been scanned: scan the groups of the overflow aggregate
+	if (!gstate.has_overflow) {
+		return;
+	}
+	if (!state.overflow_state) {
+		state.overflow_state = overflow_aggregate->GetOperatorState();
+	}
+	overflow_aggregate->GetChunk(context, chunk, state.overflow_state.get());
+}
+
+void PhysicalPerfectHashAggregate::DecodeGroups(GlobalOperatorState &state, DataChunk &ht_groups, DataChunk &result,
+                                                idx_t count) {
+	auto &gstate = (PerfectHashAggregateGlobalState &)state;
+	for (idx_t group_idx = 0; group_idx < groups.size(); group_idx++) {
+		if (!dictionary_encoded[group_idx]) {
+			result.data[group_idx].Reference(ht_groups.data[group_idx]);
+			continue;
+		}
+		// look up the strings of the dictionary ids
+		auto &strings = gstate.dictionaries[group_idx].strings;
+		auto ids = FlatVector::GetData<int32_t>(ht_groups.data[group_idx]);
+		auto &id_nullmask = FlatVector::Nullmask(ht_groups.data[group_idx]);
+		auto &target = result.data[group_idx];
+		auto target_data = FlatVector::GetData<string_t>(target);
+		auto &target_nullmask = FlatVector::Nullmask(target);
+		for (idx_t i = 0; i < count; i++) {
+			if (id_nullmask[i]) {
+				target_nullmask[i] = true;
+			} else {
+				D_ASSERT(ids[i] >= 1 && idx_t(ids[i]) <= strings.size());
+				target_data[i] = StringVector::AddString(target, strings[ids[i] - 1]);
+			}
+		}
+	}
 }
 
 unique_ptr<PhysicalOperatorState> PhysicalPerfectHashAggregate::GetOperatorState() {
-	return make_unique<PerfectHashAggregateState>(*this, children[0].get());
+	auto state = make_unique<PerfectHashAggregateState>(*this, children[0].get());
+	if (has_dictionary_groups) {
+		auto scan_types = ht_group_types;
+		for (idx_t i = groups.size(); i < types.size(); i++) {
+			scan_types.push_back(types[i]);
+		}
+		state->scan_chunk.Initialize(scan_types);
+	}
+	return move(state);
 }
 
 string PhysicalPerfectHashAggregate::ParamsToString() const {
@@ -0,0 +1,414 @@
+#include "duckdb/execution/operator/aggregate/physical_streaming_window.hpp"
+
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/planner/expression/bound_window_expression.hpp"
+
+namespace duckdb {
+
+PhysicalStreamingWindow::PhysicalStreamingWindow(vector<LogicalType> types, vector<unique_ptr<Expression>> select_list)
+    : PhysicalOperator(PhysicalOperatorType::STREAMING_WINDOW, move(types)), select_list(move(select_list)) {
+}
+
+static bool IsStreamableType(const LogicalType &type) {
+	// the keys of consecutive rows are compared for equality, and LAG shifts its argument from one chunk to the next
+	switch (type.InternalType()) {
+	case PhysicalType::LIST:
+	case PhysicalType::STRUCT:
+		return false;
+	default:
+		return true;
+	}
+}
+
+static int64_t GetLagOffset(BoundWindowExpression &wexpr) {
+	if (!wexpr.offset_expr) {
+		return 1;
+	}
+	return ExpressionExecutor::EvaluateScalar(*wexpr.offset_expr).GetValue<int64_t>();
+}
+
+static bool FrameContainsCurrentRow(BoundWindowExpression &wexpr) {
+	switch (wexpr.start) {
+	case WindowBoundary::UNBOUNDED_PRECEDING:
+	case WindowBoundary::CURRENT_ROW_ROWS:
+	case WindowBoundary::CURRENT_ROW_RANGE:
+		break;
+	default:
+		return false;
+	}
+	switch (wexpr.end) {
+	case WindowBoundary::CURRENT_ROW_ROWS:
+	case WindowBoundary::CURRENT_ROW_RANGE:
+	case WindowBoundary::UNBOUNDED_FOLLOWING:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool PhysicalStreamingWindow::IsStreamable(BoundWindowExpression &wexpr) {
+	for (auto &pexpr : wexpr.partitions) {
+		if (!IsStreamableType(pexpr->return_type)) {
+			return false;
+		}
+	}
+	for (auto &order : wexpr.orders) {
+		if (!IsStreamableType(order.expression->return_type)) {
+			return false;
+		}
+	}
+	switch (wexpr.type) {
+	case ExpressionType::WINDOW_ROW_NUMBER:
+	case ExpressionType::WINDOW_RANK:
+	case ExpressionType::WINDOW_RANK_DENSE:
+		// the result of a row is NULL if its frame is empty
+		return FrameContainsCurrentRow(wexpr) && wexpr.return_type.InternalType() == PhysicalType::INT64;
+	case ExpressionType::WINDOW_LAG: {
+		// the offset and the default value have to be constant, and the offset can only point backwards
+		if (!FrameContainsCurrentRow(wexpr) || wexpr.children.size() != 1 ||
+		    !IsStreamableType(wexpr.children[0]->return_type) || (wexpr.offset_expr && !wexpr.offset_expr->IsFoldable()) ||
+		    (wexpr.default_expr && !wexpr.default_expr->IsFoldable())) {
+			return false;
+		}
+		auto offset = GetLagOffset(wexpr);
+		return offset >= 0 && offset <= (int64_t)STANDARD_VECTOR_SIZE;
+	}
+	case ExpressionType::WINDOW_AGGREGATE:
+		// running aggregates, the state of every row is copied from the running state with combine
+		return wexpr.aggregate->combine && wexpr.start == WindowBoundary::UNBOUNDED_PRECEDING &&
+		       wexpr.end == WindowBoundary::CURRENT_ROW_ROWS;
+	default:
+		return false;
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// GetChunkInternal
+//===--------------------------------------------------------------------===//
+//! The state of a single window expression, which is carried over from one chunk to the next
+class StreamingWindowExpressionState {
+public:
+	explicit StreamingWindowExpressionState(BoundWindowExpression &wexpr)
+	    : wexpr(wexpr), has_previous(false), row_number(0), rank(0), dense_rank(0), rank_equal(0), lag_offset(0),
+	      lag_count(0), statep(LogicalType::POINTER), state_initialized(false), row_statep(LogicalType::POINTER) {
+		vector<LogicalType> key_types;
+		for (auto &pexpr : wexpr.partitions) {
+			key_types.push_back(pexpr->return_type);
+			key_executor.AddExpression(*pexpr);
+		}
+		for (auto &order : wexpr.orders) {
+			key_types.push_back(order.expression->return_type);
+			key_executor.AddExpression(*order.expression);
+		}
+		if (!key_types.empty()) {
+			keys.Initialize(key_types);
+			previous_keys.Initialize(key_types);
+		}
+		vector<LogicalType> payload_types;
+		for (auto &child : wexpr.children) {
+			payload_types.push_back(child->return_type);
+			payload_executor.AddExpression(*child);
+		}
+		if (!payload_types.empty()) {
+			payload.Initialize(payload_types);
+			row_payload.InitializeEmpty(payload_types);
+		}
+		if (wexpr.type == ExpressionType::WINDOW_LAG) {
+			lag_offset = GetLagOffset(wexpr);
+			auto default_value = wexpr.default_expr ? ExpressionExecutor::EvaluateScalar(*wexpr.default_expr)
+			                                        : Value(wexpr.return_type);
+			lag_defaults.Reference(default_value.CastAs(wexpr.return_type));
+			lag_defaults.Normalify(STANDARD_VECTOR_SIZE);
+			// the first row of the input starts a partition, so the initial history is never read
+			lag_history.Reference(Value(wexpr.return_type));
+			lag_history.Normalify(lag_offset);
+		}
+		if (wexpr.aggregate) {
+			auto state_size = wexpr.aggregate->state_size();
+			state.resize(state_size);
+			FlatVector::GetData<data_ptr_t>(statep)[0] = state.data();
+			row_states = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * state_size]);
+			auto row_pointers = FlatVector::GetData<data_ptr_t>(row_statep);
+			for (idx_t i = 0; i < STANDARD_VECTOR_SIZE; i++) {
+				row_pointers[i] = row_states.get() + i * state_size;
+			}
+		}
+	}
+	~StreamingWindowExpressionState() {
+		DestroyState();
+	}
+
+	BoundWindowExpression &wexpr;
+
+	//! Evaluates the PARTITION BY and ORDER BY keys
+	ExpressionExecutor key_executor;
+	DataChunk keys;
+	//! The keys of the last row of the previous chunk (if any)
+	DataChunk previous_keys;
+	bool has_previous;
+	//! Evaluates the arguments of the window function
+	ExpressionExecutor payload_executor;
+	DataChunk payload;
+	//! The arguments of a single row, used to update the running aggregate
+	DataChunk row_payload;
+
+	//! ROW_NUMBER, RANK and DENSE_RANK of the previous row
+	int64_t row_number;
+	int64_t rank;
+	int64_t dense_rank;
+	int64_t rank_equal;
+
+	//! LAG: the values of the last lag_offset rows of the input, and the number of rows of the current partition
+	int64_t lag_offset;
+	Vector lag_defaults;
+	Vector lag_history;
+	idx_t lag_count;
+
+	//! The state of the running aggregate
+	vector<data_t> state;
+	Vector statep;
+	bool state_initialized;
+	//! The states that are finalized into the results of the rows of a chunk. The running state itself is never
+	//! finalized, as finalize is allowed to modify the state.
+	unique_ptr<data_t[]> row_states;
+	Vector row_statep;
+
+public:
+	void ResetState() {
+		DestroyState();
+		wexpr.aggregate->initialize(state.data());
+		state_initialized = true;
+	}
+
+private:
+	void DestroyState() {
+		if (state_initialized && wexpr.aggregate->destructor) {
+			wexpr.aggregate->destructor(statep, 1);
+		}
+		state_initialized = false;
+	}
+};
+
+class PhysicalStreamingWindowOperatorState : public PhysicalOperatorState {
+public:
+	PhysicalStreamingWindowOperatorState(PhysicalStreamingWindow &op, PhysicalOperator *child)
+	    : PhysicalOperatorState(op, child) {
+		for (auto &expr : op.select_list) {
+			D_ASSERT(expr->GetExpressionClass() == ExpressionClass::BOUND_WINDOW);
+			expressions.push_back(make_unique<StreamingWindowExpressionState>((BoundWindowExpression &)*expr));
+		}
+	}
+
+	vector<unique_ptr<StreamingWindowExpressionState>> expressions;
+};
+
+//! Marks the rows for which one of the key columns [column_begin, column_end) differs from the previous row. NULL
+//! values are considered equal to each other.
+static void MarkKeyChanges(StreamingWindowExpressionState &estate, idx_t column_begin, idx_t column_end, idx_t count,
+                           bool changes[]) {
+	Vector equal(LogicalType::BOOLEAN);
+	for (idx_t col_idx = column_begin; col_idx < column_end; col_idx++) {
+		auto &current = estate.keys.data[col_idx];
+		// line up every row with the row before it
+		Vector previous(current.type);
+		if (estate.has_previous) {
+			VectorOperations::Copy(estate.previous_keys.data[col_idx], previous, 1, 0, 0);
+		} else {
+			FlatVector::SetNull(previous, 0, true);
+		}
+		VectorOperations::Copy(current, previous, count - 1, 0, 1);
+		VectorOperations::Equals(previous, current, equal, count);
+
+		VectorData equal_data, previous_data, current_data;
+		equal.Orrify(count, equal_data);
+		previous.Orrify(count, previous_data);
+		current.Orrify(count, current_data);
+		auto equals = (bool *)equal_data.data;
+		for (idx_t i = 0; i < count; i++) {
+			auto equal_idx = equal_data.sel->get_index(i);
+			if (!(*equal_data.nullmask)[equal_idx]) {
+				changes[i] = changes[i] || !equals[equal_idx];
+				continue;
+			}
+			// the comparison is NULL if either side is NULL
+			auto previous_null = (*previous_data.nullmask)[previous_data.sel->get_index(i)];
+			auto current_null = (*current_data.nullmask)[current_data.sel->get_index(i)];
+			changes[i] = changes[i] || previous_null != current_null;
+		}
+	}
+	if (!estate.has_previous) {
+		// the very first row starts a new partition
+		changes[0] = true;
+	}
+}
+
+static void ComputeStreamingWindow(StreamingWindowExpressionState &estate, DataChunk &input, Vector &result) {
+	auto &wexpr = estate.wexpr;
+	auto count = input.size();
+
+	// figure out where the partitions and peer groups of the chunk start
+	bool partition_starts[STANDARD_VECTOR_SIZE];
+	bool peer_starts[STANDARD_VECTOR_SIZE];
+	memset(partition_starts, 0, sizeof(bool) * count);
+	if (estate.keys.ColumnCount() > 0) {
+		estate.keys.Reset();
+		estate.key_executor.Execute(input, estate.keys);
+	}
+	auto partition_count = wexpr.partitions.size();
+	MarkKeyChanges(estate, 0, partition_count, count, partition_starts);
+	memcpy(peer_starts, partition_starts, sizeof(bool) * count);
+	MarkKeyChanges(estate, partition_count, estate.keys.ColumnCount(), count, peer_starts);
+	if (estate.keys.ColumnCount() > 0) {
+		estate.previous_keys.Reset();
+		for (idx_t col_idx = 0; col_idx < estate.keys.ColumnCount(); col_idx++) {
+			VectorOperations::Copy(estate.keys.data[col_idx], estate.previous_keys.data[col_idx], count, count - 1, 0);
+		}
+		estate.previous_keys.SetCardinality(1);
+	}
+	estate.has_previous = true;
+
+	if (estate.payload.ColumnCount() > 0) {
+		estate.payload.Reset();
+		estate.payload_executor.Execute(input, estate.payload);
+		estate.payload.Normalify();
+	}
+
+	switch (wexpr.type) {
+	case ExpressionType::WINDOW_ROW_NUMBER: {
+		auto result_data = FlatVector::GetData<int64_t>(result);
+		for (idx_t i = 0; i < count; i++) {
+			estate.row_number = partition_starts[i] ? 1 : estate.row_number + 1;
+			result_data[i] = estate.row_number;
+		}
+		break;
+	}
+	case ExpressionType::WINDOW_RANK:
+	case ExpressionType::WINDOW_RANK_DENSE: {
+		auto result_data = FlatVector::GetData<int64_t>(result);
+		for (idx_t i = 0; i < count; i++) {
+			if (partition_starts[i]) {
+				estate.rank = 1;
+				estate.dense_rank = 1;
+				estate.rank_equal = 0;
+			} else if (peer_starts[i]) {
+				estate.dense_rank++;
+				estate.rank += estate.rank_equal;
+				estate.rank_equal = 0;
+			}
+			estate.rank_equal++;
+			result_data[i] = wexpr.type == ExpressionType::WINDOW_RANK ? estate.rank : estate.dense_rank;
+		}
+		break;
+	}
+	case ExpressionType::WINDOW_LAG: {
+		auto &values = estate.payload.data[0];
+		auto offset = (idx_t)estate.lag_offset;
+		// shift the values by lag_offset rows, the first rows of the chunk lag behind the last rows of the history
+		VectorOperations::Copy(estate.lag_history, result, MinValue<idx_t>(offset, count), 0, 0);
+		if (count > offset) {
+			VectorOperations::Copy(values, result, count - offset, 0, offset);
+		}
+		// the first lag_offset rows of every partition have no preceding row to lag behind and get the default
+		idx_t default_start = 0;
+		bool in_default = false;
+		for (idx_t i = 0; i < count; i++) {
+			if (partition_starts[i]) {
+				estate.lag_count = 0;
+			}
+			bool is_default = estate.lag_count < offset;
+			estate.lag_count++;
+			if (is_default && !in_default) {
+				default_start = i;
+			} else if (!is_default && in_default) {
+				VectorOperations::Copy(estate.lag_defaults, result, i, default_start, default_start);
+			}
+			in_default = is_default;
+		}
+		if (in_default) {
+			VectorOperations::Copy(estate.lag_defaults, result, count, default_start, default_start);
+		}
+		// keep the last lag_offset rows for the next chunk, the new history has its own string heap
+		Vector history(values.type);
+		if (count >= offset) {
+			VectorOperations::Copy(values, history, count, count - offset, 0);
+		} else {
+			VectorOperations::Copy(estate.lag_history, history, offset, count, 0);
+			VectorOperations::Copy(values, history, count, 0, offset - count);
+		}
+		estate.lag_history.Reference(history);
+		break;
+	}
+	case ExpressionType::WINDOW_AGGREGATE: {
+		auto &aggregate = *wexpr.aggregate;
+		auto &row_payload = estate.row_payload;
+		auto row_pointers = FlatVector::GetData<data_ptr_t>(estate.row_statep);
+		Vector target_statep(LogicalType::POINTER);
+		auto row_target = FlatVector::GetData<data_ptr_t>(target_statep);
+		for (idx_t i = 0; i < count; i++) {
+			if (partition_starts[i] || !estate.state_initialized) {
+				estate.ResetState();
+			}
+			// add the row to the running state, and copy the running state into the state of the row
+			for (idx_t col_idx = 0; col_idx < row_payload.ColumnCount(); col_idx++) {
+				row_payload.data[col_idx].Slice(estate.payload.data[col_idx], i);
+			}
+			row_payload.SetCardinality(1);
+			if (aggregate.simple_update) {
+				aggregate.simple_update(row_payload.data.data(), row_payload.ColumnCount(), estate.state.data(), 1);
+			} else {
+				aggregate.update(row_payload.data.data(), row_payload.ColumnCount(), estate.statep, 1);
+			}
+			aggregate.initialize(row_pointers[i]);
+			row_target[0] = row_pointers[i];
+			aggregate.combine(estate.statep, target_statep, 1);
+		}
+		// finalize the states of all rows of the chunk at once
+		FlatVector::Nullmask(result).reset();
+		aggregate.finalize(estate.row_statep, wexpr.bind_info.get(), result, count);
+		if (aggregate.destructor) {
+			aggregate.destructor(estate.row_statep, count);
+		}
+		break;
+	}
+	default:
+		throw InternalException("Window function %s cannot be streamed", ExpressionTypeToString(wexpr.type));
+	}
+}
+
+void PhysicalStreamingWindow::GetChunkInternal(ExecutionContext &context, DataChunk &chunk,
+                                               PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalStreamingWindowOperatorState *>(state_);
+
+	children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+	auto &input = state->child_chunk;
+	if (input.size() == 0) {
+		return;
+	}
+	// the input columns are passed through, the results of the window expressions are appended
+	idx_t out_idx = 0;
+	for (idx_t col_idx = 0; col_idx < input.ColumnCount(); col_idx++) {
+		chunk.data[out_idx++].Reference(input.data[col_idx]);
+	}
+	for (idx_t expr_idx = 0; expr_idx < state->expressions.size(); expr_idx++) {
+		ComputeStreamingWindow(*state->expressions[expr_idx], input, chunk.data[out_idx++]);
+	}
+	chunk.SetCardinality(input);
+}
+
+unique_ptr<PhysicalOperatorState> PhysicalStreamingWindow::GetOperatorState() {
+	return make_unique<PhysicalStreamingWindowOperatorState>(*this, children[0].get());
+}
+
+string PhysicalStreamingWindow::ParamsToString() const {
+	string result;
+	for (idx_t i = 0; i < select_list.size(); i++) {
+		if (i > 0) {
+			result += "\n";
+		}
+		result += select_list[i]->GetName();
+	}
+	return result;
+}
+
+} // namespace duckdb
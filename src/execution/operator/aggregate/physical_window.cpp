@@ -1,9 +1,15 @@
 #include "duckdb/execution/operator/aggregate/physical_window.hpp"
 
+#include "duckdb/common/operator/comparison_operators.hpp"
 #include "duckdb/common/types/chunk_collection.hpp"
+#include "duckdb/common/types/hugeint.hpp"
 #include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/executor.hpp"
 #include "duckdb/execution/expression_executor.hpp"
 #include "duckdb/execution/window_segment_tree.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/parallel/pipeline.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 #include "duckdb/planner/expression/bound_reference_expression.hpp"
 #include "duckdb/planner/expression/bound_window_expression.hpp"
 
@@ -11,40 +17,98 @@
 
 namespace duckdb {
 
+//! A hash partition of the window input. All rows with the same PARTITION BY keys end up in the same partition, hence
+//! the window expressions of every partition can be computed independently.
+//! Note that, like the single partition of a window without PARTITION BY keys, the partitions are fully materialized
+//! in memory: they are not managed by the buffer manager, so their size is not bounded by the memory limit, and a
+//! skewed PARTITION BY key can put (almost) all of the input in a single partition.
+class WindowHashPartition {
+public:
+	ChunkCollection chunks;
+	ChunkCollection window_results;
+};
+
+static idx_t WindowPartitionCount(PhysicalWindow &op) {
+	return op.is_partitioned ? (idx_t)1 << PhysicalWindow::WINDOW_RADIX_BITS : 1;
+}
+
 class WindowGlobalState : public GlobalOperatorState {
 public:
 	WindowGlobalState(PhysicalWindow &_op, ClientContext &context) : op(_op) {
+		for (idx_t i = 0; i < WindowPartitionCount(op); i++) {
+			partitions.push_back(make_unique<WindowHashPartition>());
+		}
 	}
 
 	PhysicalWindow &op;
 	std::mutex lock;
-	ChunkCollection chunks;
-	ChunkCollection window_results;
+	vector<unique_ptr<WindowHashPartition>> partitions;
 };
 
 class WindowLocalState : public LocalSinkState {
 public:
-	WindowLocalState(PhysicalWindow &_op) : op(_op) {
+	WindowLocalState(PhysicalWindow &_op) : op(_op), hashes(LogicalType::HASH) {
+		for (idx_t i = 0; i < WindowPartitionCount(op); i++) {
+			partitions.push_back(make_unique<ChunkCollection>());
+			partition_sel.emplace_back(STANDARD_VECTOR_SIZE);
+		}
+		if (op.is_partitioned) {
+			auto wexpr = reinterpret_cast<BoundWindowExpression *>(op.select_list[0].get());
+			vector<LogicalType> partition_types;
+			for (auto &pexpr : wexpr->partitions) {
+				partition_types.push_back(pexpr->return_type);
+				executor.AddExpression(*pexpr);
+			}
+			partition_keys.Initialize(partition_types);
+			slice_chunk.InitializeEmpty(op.children[0]->types);
+		}
 	}
 
 	PhysicalWindow &op;
-	ChunkCollection chunks;
+	//! The input rows of every hash partition
+	vector<unique_ptr<ChunkCollection>> partitions;
+	//! Computes the PARTITION BY keys of the input
+	ExpressionExecutor executor;
+	DataChunk partition_keys;
+	Vector hashes;
+	//! The rows of the current input chunk that belong to every partition
+	vector<SelectionVector> partition_sel;
+	DataChunk slice_chunk;
 };
 
 //! The operator state of the window
 class PhysicalWindowOperatorState : public PhysicalOperatorState {
 public:
 	PhysicalWindowOperatorState(PhysicalOperator &op, PhysicalOperator *child)
-	    : PhysicalOperatorState(op, child), position(0) {
+	    : PhysicalOperatorState(op, child), partition_idx(0), position(0) {
 	}
 
+	//! The partition that is currently being scanned
+	idx_t partition_idx;
+	//! The position within that partition
 	idx_t position;
 };
 
 // this implements a sorted window functions variant
 PhysicalWindow::PhysicalWindow(vector<LogicalType> types, vector<unique_ptr<Expression>> select_list,
                                PhysicalOperatorType type)
-    : PhysicalSink(type, move(types)), select_list(move(select_list)) {
+    : PhysicalSink(type, move(types)), select_list(move(select_list)), is_partitioned(true) {
+	// the input can be hash-partitioned if all window expressions share the same (non-empty) PARTITION BY keys
+	auto first = reinterpret_cast<BoundWindowExpression *>(this->select_list[0].get());
+	for (auto &expr : this->select_list) {
+		D_ASSERT(expr->GetExpressionClass() == ExpressionClass::BOUND_WINDOW);
+		auto wexpr = reinterpret_cast<BoundWindowExpression *>(expr.get());
+		if (wexpr->partitions.empty() || wexpr->partitions.size() != first->partitions.size()) {
+			is_partitioned = false;
+			break;
+		}
+		for (idx_t prt_idx = 0; prt_idx < wexpr->partitions.size(); prt_idx++) {
+			if (!Expression::Equals(wexpr->partitions[prt_idx].get(), first->partitions[prt_idx].get())) {
+				is_partitioned = false;
+				break;
+			}
+		}
+	}
 }
 
 static bool EqualsSubset(vector<Value> &a, vector<Value> &b, idx_t start, idx_t end) {
@@ -293,6 +357,309 @@ static void UpdateWindowBoundaries(BoundWindowExpression *wexpr, ChunkCollection
 	}
 }
 
+//! The aggregates that can be computed by a WindowSlidingAggregate
+enum class WindowSlidingAggregateType : uint8_t { SUM, AVG, COUNT, MIN, MAX };
+
+//! The WindowSlidingAggregate computes an aggregate over frames whose begin and end never move backwards, e.g. the
+//! frames of ROWS BETWEEN n PRECEDING AND CURRENT ROW. Instead of aggregating every frame from scratch, the frame of
+//! the previous row is updated by removing the rows that left it and adding the rows that entered it. SUM, AVG and
+//! COUNT are inverted by subtracting the rows that leave the frame, MIN and MAX keep a monotonic queue of the rows that
+//! can still become the extreme value of the frame. Every row enters and leaves the frame once, which makes the
+//! (amortized) cost O(1) per row regardless of the frame size.
+class WindowSlidingAggregate {
+public:
+	WindowSlidingAggregate(WindowSlidingAggregateType type, ChunkCollection &input);
+
+	//! Returns whether or not the window expression can be computed by a WindowSlidingAggregate, and its type if so
+	static bool CanCompute(BoundWindowExpression &wexpr, WindowSlidingAggregateType &type);
+
+	//! Computes the aggregate over the frames [begins[i], ends[i]) of count rows, and writes the results into the
+	//! (flat) result vector. The frames must not move backwards, also not across calls. Empty frames produce NULL.
+	void Compute(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result);
+
+private:
+	template <class T> inline T GetInput(idx_t row_idx) {
+		return ((T *)input_data[row_idx / STANDARD_VECTOR_SIZE])[row_idx % STANDARD_VECTOR_SIZE];
+	}
+	inline bool IsValid(idx_t row_idx) {
+		return !(*input_nullmasks[row_idx / STANDARD_VECTOR_SIZE])[row_idx % STANDARD_VECTOR_SIZE];
+	}
+	//! Moves the current frame to [begin, end), returns false if the frame is empty
+	template <class ADD, class REMOVE> bool SlideFrame(idx_t begin, idx_t end, ADD add, REMOVE remove);
+
+	void ComputeCount(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result);
+	template <class T> void ComputeSum(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result);
+	template <class T, class OP>
+	void ComputeMinMax(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result);
+	template <class OP> void ComputeMinMax(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result);
+
+private:
+	WindowSlidingAggregateType type;
+	//! The physical type of the aggregated input
+	PhysicalType input_type;
+	//! The data and nullmask of the input, per chunk of the input collection
+	vector<data_ptr_t> input_data;
+	vector<nullmask_t *> input_nullmasks;
+
+	//! The current frame [frame_begin, frame_end)
+	idx_t frame_begin;
+	idx_t frame_end;
+	//! The sum and the amount of non-NULL rows of the current frame (SUM, AVG, COUNT)
+	hugeint_t sum;
+	idx_t valid_count;
+	//! The monotonic queue of the current frame (MIN, MAX): the rows of the frame that are not dominated by a later
+	//! row, from queue_head on. The values of the rows in the queue are ordered, so the front is the result.
+	vector<idx_t> queue;
+	idx_t queue_head;
+};
+
+WindowSlidingAggregate::WindowSlidingAggregate(WindowSlidingAggregateType type, ChunkCollection &input)
+    : type(type), frame_begin(0), frame_end(0), sum(0), valid_count(0), queue_head(0) {
+	D_ASSERT(input.ColumnCount() == 1);
+	input_type = input.Types()[0].InternalType();
+	for (auto &chunk : input.Chunks()) {
+		auto &vector = chunk->data[0];
+		D_ASSERT(vector.vector_type == VectorType::FLAT_VECTOR);
+		input_data.push_back(FlatVector::GetData(vector));
+		input_nullmasks.push_back(&FlatVector::Nullmask(vector));
+	}
+}
+
+bool WindowSlidingAggregate::CanCompute(BoundWindowExpression &wexpr, WindowSlidingAggregateType &type) {
+	if (wexpr.type != ExpressionType::WINDOW_AGGREGATE) {
+		return false;
+	}
+	// the begin and end of the frames can only move backwards for offsets that differ per row
+	switch (wexpr.start) {
+	case WindowBoundary::UNBOUNDED_PRECEDING:
+	case WindowBoundary::CURRENT_ROW_ROWS:
+	case WindowBoundary::CURRENT_ROW_RANGE:
+		break;
+	case WindowBoundary::EXPR_PRECEDING:
+	case WindowBoundary::EXPR_FOLLOWING:
+		if (!wexpr.start_expr->IsScalar()) {
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+	switch (wexpr.end) {
+	case WindowBoundary::UNBOUNDED_FOLLOWING:
+	case WindowBoundary::CURRENT_ROW_ROWS:
+	case WindowBoundary::CURRENT_ROW_RANGE:
+		break;
+	case WindowBoundary::EXPR_PRECEDING:
+	case WindowBoundary::EXPR_FOLLOWING:
+		if (!wexpr.end_expr->IsScalar()) {
+			return false;
+		}
+		break;
+	default:
+		return false;
+	}
+	// COUNT(*) is computed from the frame boundaries directly
+	if (wexpr.children.size() != 1) {
+		return false;
+	}
+	auto &name = wexpr.aggregate->name;
+	auto result_type = wexpr.return_type.InternalType();
+	auto input_type = wexpr.children[0]->return_type.InternalType();
+	if (name == "count") {
+		type = WindowSlidingAggregateType::COUNT;
+		return result_type == PhysicalType::INT64;
+	}
+	if (name == "sum" || name == "avg") {
+		// only integers (and decimals stored as integers) are summed exactly, and can be subtracted again
+		if (input_type != PhysicalType::INT16 && input_type != PhysicalType::INT32 &&
+		    input_type != PhysicalType::INT64) {
+			return false;
+		}
+		if (name == "sum") {
+			type = WindowSlidingAggregateType::SUM;
+			return result_type == PhysicalType::INT128;
+		}
+		// the average of decimals is scaled using the bind info
+		type = WindowSlidingAggregateType::AVG;
+		return result_type == PhysicalType::DOUBLE && !wexpr.bind_info;
+	}
+	if (name == "min" || name == "max") {
+		type = name == "min" ? WindowSlidingAggregateType::MIN : WindowSlidingAggregateType::MAX;
+		switch (input_type) {
+		case PhysicalType::INT8:
+		case PhysicalType::INT16:
+		case PhysicalType::INT32:
+		case PhysicalType::INT64:
+		case PhysicalType::INT128:
+		case PhysicalType::FLOAT:
+		case PhysicalType::DOUBLE:
+			return result_type == input_type;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+template <class ADD, class REMOVE>
+bool WindowSlidingAggregate::SlideFrame(idx_t begin, idx_t end, ADD add, REMOVE remove) {
+	if (begin >= end) {
+		return false;
+	}
+	D_ASSERT(begin >= frame_begin && end >= frame_end);
+	if (begin >= frame_end) {
+		// the frames do not overlap (e.g. a new partition started): start over
+		sum = 0;
+		valid_count = 0;
+		queue.clear();
+		queue_head = 0;
+		frame_begin = frame_end = begin;
+	}
+	for (; frame_begin < begin; frame_begin++) {
+		remove(frame_begin);
+	}
+	for (; frame_end < end; frame_end++) {
+		add(frame_end);
+	}
+	return true;
+}
+
+void WindowSlidingAggregate::ComputeCount(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result) {
+	auto result_data = FlatVector::GetData<int64_t>(result);
+	auto add = [&](idx_t row_idx) {
+		if (IsValid(row_idx)) {
+			valid_count++;
+		}
+	};
+	auto remove = [&](idx_t row_idx) {
+		if (IsValid(row_idx)) {
+			valid_count--;
+		}
+	};
+	for (idx_t i = 0; i < count; i++) {
+		if (!SlideFrame(begins[i], ends[i], add, remove)) {
+			FlatVector::SetNull(result, i, true);
+			continue;
+		}
+		result_data[i] = valid_count;
+	}
+}
+
+template <class T>
+void WindowSlidingAggregate::ComputeSum(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result) {
+	auto add = [&](idx_t row_idx) {
+		if (IsValid(row_idx)) {
+			sum += hugeint_t(GetInput<T>(row_idx));
+			valid_count++;
+		}
+	};
+	auto remove = [&](idx_t row_idx) {
+		if (IsValid(row_idx)) {
+			sum -= hugeint_t(GetInput<T>(row_idx));
+			valid_count--;
+		}
+	};
+	for (idx_t i = 0; i < count; i++) {
+		if (!SlideFrame(begins[i], ends[i], add, remove) || valid_count == 0) {
+			FlatVector::SetNull(result, i, true);
+			continue;
+		}
+		if (type == WindowSlidingAggregateType::SUM) {
+			FlatVector::GetData<hugeint_t>(result)[i] = sum;
+		} else {
+			FlatVector::GetData<double>(result)[i] = Hugeint::Cast<double>(sum) / double(valid_count);
+		}
+	}
+}
+
+template <class T, class OP>
+void WindowSlidingAggregate::ComputeMinMax(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result) {
+	auto result_data = FlatVector::GetData<T>(result);
+	auto add = [&](idx_t row_idx) {
+		if (!IsValid(row_idx)) {
+			return;
+		}
+		// rows that are not better than the new row can never become the result anymore
+		auto value = GetInput<T>(row_idx);
+		while (queue.size() > queue_head && !OP::Operation(GetInput<T>(queue.back()), value)) {
+			queue.pop_back();
+		}
+		queue.push_back(row_idx);
+	};
+	auto remove = [&](idx_t row_idx) {
+		if (queue.size() > queue_head && queue[queue_head] == row_idx) {
+			queue_head++;
+		}
+	};
+	for (idx_t i = 0; i < count; i++) {
+		if (!SlideFrame(begins[i], ends[i], add, remove) || queue.size() == queue_head) {
+			FlatVector::SetNull(result, i, true);
+			continue;
+		}
+		result_data[i] = GetInput<T>(queue[queue_head]);
+	}
+}
+
+template <class OP>
+void WindowSlidingAggregate::ComputeMinMax(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result) {
+	switch (input_type) {
+	case PhysicalType::INT8:
+		ComputeMinMax<int8_t, OP>(begins, ends, count, result);
+		break;
+	case PhysicalType::INT16:
+		ComputeMinMax<int16_t, OP>(begins, ends, count, result);
+		break;
+	case PhysicalType::INT32:
+		ComputeMinMax<int32_t, OP>(begins, ends, count, result);
+		break;
+	case PhysicalType::INT64:
+		ComputeMinMax<int64_t, OP>(begins, ends, count, result);
+		break;
+	case PhysicalType::INT128:
+		ComputeMinMax<hugeint_t, OP>(begins, ends, count, result);
+		break;
+	case PhysicalType::FLOAT:
+		ComputeMinMax<float, OP>(begins, ends, count, result);
+		break;
+	case PhysicalType::DOUBLE:
+		ComputeMinMax<double, OP>(begins, ends, count, result);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented type for sliding window MIN/MAX");
+	}
+}
+
+void WindowSlidingAggregate::Compute(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result) {
+	D_ASSERT(result.vector_type == VectorType::FLAT_VECTOR);
+	switch (type) {
+	case WindowSlidingAggregateType::COUNT:
+		ComputeCount(begins, ends, count, result);
+		break;
+	case WindowSlidingAggregateType::SUM:
+	case WindowSlidingAggregateType::AVG:
+		switch (input_type) {
+		case PhysicalType::INT16:
+			ComputeSum<int16_t>(begins, ends, count, result);
+			break;
+		case PhysicalType::INT32:
+			ComputeSum<int32_t>(begins, ends, count, result);
+			break;
+		case PhysicalType::INT64:
+			ComputeSum<int64_t>(begins, ends, count, result);
+			break;
+		default:
+			throw NotImplementedException("Unimplemented type for sliding window SUM/AVG");
+		}
+		break;
+	case WindowSlidingAggregateType::MIN:
+		ComputeMinMax<LessThan>(begins, ends, count, result);
+		break;
+	case WindowSlidingAggregateType::MAX:
+		ComputeMinMax<GreaterThan>(begins, ends, count, result);
+		break;
+	}
+}
+
 static void ComputeWindowExpression(BoundWindowExpression *wexpr, ChunkCollection &input, ChunkCollection &output,
                                     idx_t output_idx) {
 
@@ -341,14 +708,22 @@ static void ComputeWindowExpression(BoundWindowExpression *wexpr, ChunkCollectio
 	// build a segment tree for frame-adhering aggregates
 	// see http://www.vldb.org/pvldb/vol8/p1058-leis.pdf
 	unique_ptr<WindowSegmentTree> segment_tree = nullptr;
+	// frames that only slide forward are aggregated incrementally instead
+	unique_ptr<WindowSlidingAggregate> sliding_aggregate = nullptr;
 
-	if (wexpr->aggregate) {
+	WindowSlidingAggregateType sliding_type;
+	if (WindowSlidingAggregate::CanCompute(*wexpr, sliding_type)) {
+		sliding_aggregate = make_unique<WindowSlidingAggregate>(sliding_type, payload_collection);
+	} else if (wexpr->aggregate) {
 		segment_tree = make_unique<WindowSegmentTree>(*(wexpr->aggregate), wexpr->bind_info.get(), wexpr->return_type,
 		                                              &payload_collection);
 	}
 
 	WindowBoundariesState bounds;
 	uint64_t dense_rank = 1, rank_equal = 0, rank = 1;
+	// the frames of the rows of the current output chunk, aggregates are computed for an entire chunk at once
+	idx_t frame_begins[STANDARD_VECTOR_SIZE];
+	idx_t frame_ends[STANDARD_VECTOR_SIZE];
 
 	if (needs_sorting) {
 		bounds.row_prev = sort_collection.GetRow(0);
@@ -372,6 +747,22 @@ static void ComputeWindowExpression(BoundWindowExpression *wexpr, ChunkCollectio
 			rank_equal++;
 		}
 
+		if (wexpr->type == ExpressionType::WINDOW_AGGREGATE) {
+			auto chunk_row = row_idx % STANDARD_VECTOR_SIZE;
+			frame_begins[chunk_row] = bounds.window_start;
+			frame_ends[chunk_row] = bounds.window_end;
+			if (chunk_row + 1 == STANDARD_VECTOR_SIZE || row_idx + 1 == input.Count()) {
+				Vector result(wexpr->return_type);
+				if (sliding_aggregate) {
+					sliding_aggregate->Compute(frame_begins, frame_ends, chunk_row + 1, result);
+				} else {
+					segment_tree->Compute(frame_begins, frame_ends, chunk_row + 1, result);
+				}
+				output.GetChunkForRow(row_idx).data[output_idx].Reference(result);
+			}
+			continue;
+		}
+
 		Value res;
 
 		// if no values are read for window, result is NULL
@@ -381,10 +772,6 @@ static void ComputeWindowExpression(BoundWindowExpression *wexpr, ChunkCollectio
 		}
 
 		switch (wexpr->type) {
-		case ExpressionType::WINDOW_AGGREGATE: {
-			res = segment_tree->Compute(bounds.window_start, bounds.window_end);
-			break;
-		}
 		case ExpressionType::WINDOW_ROW_NUMBER: {
 			res = Value::Numeric(wexpr->return_type, row_idx - bounds.partition_start + 1);
 			break;
@@ -492,16 +879,17 @@ void PhysicalWindow::GetChunkInternal(ExecutionContext &context, DataChunk &chun
 
 	auto &gstate = (WindowGlobalState &)*sink_state;
 
-	ChunkCollection &big_data = gstate.chunks;
-	ChunkCollection &window_results = gstate.window_results;
-
-	if (big_data.Count() == 0) {
-		return;
+	// skip the partitions that have been scanned entirely
+	while (state->partition_idx < gstate.partitions.size() &&
+	       state->position >= gstate.partitions[state->partition_idx]->chunks.Count()) {
+		state->partition_idx++;
+		state->position = 0;
 	}
-
-	if (state->position >= big_data.Count()) {
+	if (state->partition_idx >= gstate.partitions.size()) {
 		return;
 	}
+	ChunkCollection &big_data = gstate.partitions[state->partition_idx]->chunks;
+	ChunkCollection &window_results = gstate.partitions[state->partition_idx]->window_results;
 
 	// just return what was computed before, appending the result cols of the window expressions at the end
 	auto &proj_ch = big_data.GetChunkForRow(state->position);
@@ -526,30 +914,64 @@ unique_ptr<PhysicalOperatorState> PhysicalWindow::GetOperatorState() {
 void PhysicalWindow::Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate_,
                           DataChunk &input) {
 	auto &lstate = (WindowLocalState &)lstate_;
-	lstate.chunks.Append(input);
+	if (!is_partitioned) {
+		lstate.partitions[0]->Append(input);
+		return;
+	}
+	// hash the PARTITION BY keys
+	lstate.partition_keys.Reset();
+	lstate.executor.Execute(input, lstate.partition_keys);
+	VectorOperations::Hash(lstate.partition_keys.data[0], lstate.hashes, input.size());
+	for (idx_t col_idx = 1; col_idx < lstate.partition_keys.ColumnCount(); col_idx++) {
+		VectorOperations::CombineHash(lstate.hashes, lstate.partition_keys.data[col_idx], input.size());
+	}
+	lstate.hashes.Normalify(input.size());
+	auto hash_data = FlatVector::GetData<hash_t>(lstate.hashes);
+
+	// radix-partition the rows on their hash
+	idx_t partition_counts[(idx_t)1 << WINDOW_RADIX_BITS];
+	memset(partition_counts, 0, sizeof(partition_counts));
+	for (idx_t i = 0; i < input.size(); i++) {
+		auto partition_idx = GetPartition(hash_data[i]);
+		lstate.partition_sel[partition_idx].set_index(partition_counts[partition_idx]++, i);
+	}
+	for (idx_t partition_idx = 0; partition_idx < lstate.partitions.size(); partition_idx++) {
+		auto count = partition_counts[partition_idx];
+		if (count == 0) {
+			continue;
+		}
+		if (count == input.size()) {
+			// all rows belong to this partition
+			lstate.partitions[partition_idx]->Append(input);
+			break;
+		}
+		lstate.slice_chunk.Reference(input);
+		lstate.slice_chunk.Slice(lstate.partition_sel[partition_idx], count);
+		lstate.partitions[partition_idx]->Append(lstate.slice_chunk);
+	}
 }
 
 void PhysicalWindow::Combine(ExecutionContext &context, GlobalOperatorState &gstate_, LocalSinkState &lstate_) {
 	auto &gstate = (WindowGlobalState &)gstate_;
 	auto &lstate = (WindowLocalState &)lstate_;
 	lock_guard<mutex> glock(gstate.lock);
-	gstate.chunks.Merge(lstate.chunks);
+	for (idx_t partition_idx = 0; partition_idx < gstate.partitions.size(); partition_idx++) {
+		gstate.partitions[partition_idx]->chunks.Merge(*lstate.partitions[partition_idx]);
+	}
 }
 
-void PhysicalWindow::Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> gstate_) {
-	this->sink_state = move(gstate_);
-	auto &gstate = (WindowGlobalState &)*this->sink_state;
-
-	ChunkCollection &big_data = gstate.chunks;
-	ChunkCollection &window_results = gstate.window_results;
+//! Computes all window expressions over the rows of a single partition
+static void ComputeWindowPartition(PhysicalWindow &op, WindowHashPartition &partition) {
+	ChunkCollection &big_data = partition.chunks;
+	ChunkCollection &window_results = partition.window_results;
 
 	if (big_data.Count() == 0) {
 		return;
 	}
 
 	vector<LogicalType> window_types;
-	for (idx_t expr_idx = 0; expr_idx < select_list.size(); expr_idx++) {
-		window_types.push_back(select_list[expr_idx]->return_type);
+	for (idx_t expr_idx = 0; expr_idx < op.select_list.size(); expr_idx++) {
+		window_types.push_back(op.select_list[expr_idx]->return_type);
 	}
 
 	for (idx_t i = 0; i < big_data.ChunkCount(); i++) {
@@ -565,17 +987,69 @@ void PhysicalWindow::Finalize(Pipeline &pipeline, ClientContext &context, unique
 		window_results.Append(window_chunk);
 	}
 
-	D_ASSERT(window_results.ColumnCount() == select_list.size());
+	D_ASSERT(window_results.ColumnCount() == op.select_list.size());
 	idx_t window_output_idx = 0;
 	// we can have multiple window functions
-	for (idx_t expr_idx = 0; expr_idx < select_list.size(); expr_idx++) {
-		D_ASSERT(select_list[expr_idx]->GetExpressionClass() == ExpressionClass::BOUND_WINDOW);
+	for (idx_t expr_idx = 0; expr_idx < op.select_list.size(); expr_idx++) {
+		D_ASSERT(op.select_list[expr_idx]->GetExpressionClass() == ExpressionClass::BOUND_WINDOW);
 		// sort by partition and order clause in window def
-		auto wexpr = reinterpret_cast<BoundWindowExpression *>(select_list[expr_idx].get());
+		auto wexpr = reinterpret_cast<BoundWindowExpression *>(op.select_list[expr_idx].get());
 		ComputeWindowExpression(wexpr, big_data, window_results, window_output_idx++);
 	}
 }
 
+class PhysicalWindowFinalizeTask : public Task {
+public:
+	PhysicalWindowFinalizeTask(Pipeline &parent_, PhysicalWindow &op_, WindowHashPartition &partition_)
+	    : parent(parent_), op(op_), partition(partition_) {
+	}
+
+	void Execute() override {
+		try {
+			ComputeWindowPartition(op, partition);
+		} catch (std::exception &ex) {
+			parent.executor.PushError(ex.what());
+		} catch (...) {
+			parent.executor.PushError("Unknown exception in window computation!");
+		}
+		auto &gstate = (WindowGlobalState &)*op.sink_state;
+		lock_guard<mutex> glock(gstate.lock);
+		parent.finished_tasks++;
+		// finish the whole pipeline
+		if (parent.total_tasks == parent.finished_tasks) {
+			parent.Finish();
+		}
+	}
+
+private:
+	Pipeline &parent;
+	PhysicalWindow &op;
+	WindowHashPartition &partition;
+};
+
+void PhysicalWindow::Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> gstate_) {
+	this->sink_state = move(gstate_);
+	auto &gstate = (WindowGlobalState &)*this->sink_state;
+
+	if (gstate.partitions.size() == 1) {
+		ComputeWindowPartition(*this, *gstate.partitions[0]);
+		return;
+	}
+	// compute the hash partitions in parallel, the pipeline is finished when the last task completes
+	vector<WindowHashPartition *> partitions;
+	for (auto &partition : gstate.partitions) {
+		if (partition->chunks.Count() > 0) {
+			partitions.push_back(partition.get());
+		}
+	}
+	lock_guard<mutex> glock(gstate.lock);
+	pipeline.total_tasks += partitions.size();
+	for (auto &partition : partitions) {
+		auto new_task = make_unique<PhysicalWindowFinalizeTask>(pipeline, *this, *partition);
+		TaskScheduler::GetScheduler(context).ScheduleTask(pipeline.token, move(new_task));
+	}
+}
+
 unique_ptr<LocalSinkState> PhysicalWindow::GetLocalSinkState(ExecutionContext &context) {
 	return make_unique<WindowLocalState>(*this);
 }
@@ -2,9 +2,16 @@
 
 #include "duckdb/storage/storage_manager.hpp"
 #include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/executor.hpp"
 #include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/sorted_run.hpp"
 #include "duckdb/storage/buffer_manager.hpp"
 #include "duckdb/function/aggregate/distributive_functions.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/parallel/pipeline.hpp"
+#include "duckdb/parallel/task_context.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
 
 namespace duckdb {
 
@@ -12,7 +19,8 @@ PhysicalHashJoin::PhysicalHashJoin(LogicalOperator &op, unique_ptr<PhysicalOpera
                                    unique_ptr<PhysicalOperator> right, vector<JoinCondition> cond, JoinType join_type,
                                    vector<idx_t> left_projection_map, vector<idx_t> right_projection_map)
     : PhysicalComparisonJoin(op, PhysicalOperatorType::HASH_JOIN, move(cond), join_type),
-      right_projection_map(right_projection_map) {
+      right_projection_map(right_projection_map), perfect_min(0), perfect_range(0),
+      probe_cardinality(NumericLimits<idx_t>::Maximum()) {
 	children.push_back(move(left));
 	children.push_back(move(right));
 
@@ -40,21 +48,30 @@ public:
 	DataChunk build_chunk;
 	DataChunk join_keys;
 	ExpressionExecutor build_executor;
+	//! The thread-local HT that is built into, merged into the global HT in Combine. This is not used for the correlated
+	//! MARK join, which aggregates into the global HT while building.
+	unique_ptr<JoinHashTable> hash_table;
 };
 
 class HashJoinGlobalState : public GlobalOperatorState {
 public:
-	HashJoinGlobalState() {
+	HashJoinGlobalState() : swap_pending(false) {
 	}
 
 	//! The HT used by the join
 	unique_ptr<JoinHashTable> hash_table;
+	//! Whether or not the build side was much larger than the estimated probe side. The HT is then not finalized yet:
+	//! the probe decides whether to swap the sides of the join once it has seen the actual probe input.
+	bool swap_pending;
 	//! Only used for FULL OUTER JOIN: scan state of the final scan to find unmatched tuples in the build-side
 	JoinHTScanState ht_scan_state;
 };
 
 unique_ptr<GlobalOperatorState> PhysicalHashJoin::GetGlobalState(ClientContext &context) {
 	auto state = make_unique<HashJoinGlobalState>();
+	for (auto &join_filter : join_filters) {
+		join_filter->Reset();
+	}
 	state->hash_table =
 	    make_unique<JoinHashTable>(BufferManager::GetBufferManager(context), conditions, build_types, join_type);
 	if (delim_types.size() > 0 && join_type == JoinType::MARK) {
@@ -111,6 +128,10 @@ unique_ptr<LocalSinkState> PhysicalHashJoin::GetLocalSinkState(ExecutionContext
 		state->build_executor.AddExpression(*cond.right);
 	}
 	state->join_keys.Initialize(condition_types);
+	if (delim_types.empty() || join_type != JoinType::MARK) {
+		state->hash_table = make_unique<JoinHashTable>(BufferManager::GetBufferManager(context.client), conditions,
+		                                               build_types, join_type);
+	}
 	return move(state);
 }
 
@@ -118,6 +139,7 @@ void PhysicalHashJoin::Sink(ExecutionContext &context, GlobalOperatorState &stat
                             DataChunk &input) {
 	auto &sink = (HashJoinGlobalState &)state;
 	auto &lstate = (HashJoinLocalState &)lstate_;
+	auto &hash_table = lstate.hash_table ? *lstate.hash_table : *sink.hash_table;
 	// resolve the join keys for the right chunk
 	lstate.build_executor.Execute(input, lstate.join_keys);
 	// build the HT
@@ -128,21 +150,166 @@ void PhysicalHashJoin::Sink(ExecutionContext &context, GlobalOperatorState &stat
 		for (idx_t i = 0; i < right_projection_map.size(); i++) {
 			lstate.build_chunk.data[i].Reference(input.data[right_projection_map[i]]);
 		}
-		sink.hash_table->Build(lstate.join_keys, lstate.build_chunk);
+		hash_table.Build(lstate.join_keys, lstate.build_chunk);
 	} else {
 		// there is not a projected map: place the entire right chunk in the HT
-		sink.hash_table->Build(lstate.join_keys, input);
+		hash_table.Build(lstate.join_keys, input);
+	}
+}
+
+void PhysicalHashJoin::Combine(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate_) {
+	auto &sink = (HashJoinGlobalState &)state;
+	auto &lstate = (HashJoinLocalState &)lstate_;
+	if (lstate.hash_table) {
+		sink.hash_table->Merge(*lstate.hash_table);
 	}
 }
 
 //===--------------------------------------------------------------------===//
 // Finalize
 //===--------------------------------------------------------------------===//
+class HashJoinFinalizeTask : public Task {
+public:
+	HashJoinFinalizeTask(Pipeline &parent_, JoinHashTable &hash_table_, idx_t block_begin_, idx_t block_end_)
+	    : parent(parent_), hash_table(hash_table_), block_begin(block_begin_), block_end(block_end_) {
+	}
+
+	void Execute() override {
+		try {
+			hash_table.InsertPinnedBlocks(block_begin, block_end, true);
+		} catch (std::exception &ex) {
+			parent.executor.PushError(ex.what());
+		} catch (...) {
+			parent.executor.PushError("Unknown exception in hash join finalize!");
+		}
+		parent.finished_tasks++;
+		// finish the whole pipeline
+		if (parent.total_tasks == parent.finished_tasks) {
+			parent.Finish();
+		}
+	}
+
+private:
+	Pipeline &parent;
+	JoinHashTable &hash_table;
+	idx_t block_begin;
+	idx_t block_end;
+};
+
 void PhysicalHashJoin::Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> state) {
 	auto &sink = (HashJoinGlobalState &)*state;
-	sink.hash_table->Finalize();
-
+	auto &hash_table = *sink.hash_table;
+	// the estimate of the build side might have been far off: if the HT is much larger than the probe side is
+	// estimated to be, defer finalizing the HT until the size of the probe side is known
+	sink.swap_pending = join_type == JoinType::INNER && delim_types.empty() &&
+	                    hash_table.size() >= MIN_SWAP_BUILD_COUNT &&
+	                    hash_table.size() / SWAP_THRESHOLD > probe_cardinality;
+	if (!sink.swap_pending && (perfect_range == 0 || !hash_table.TryFinalizePerfect(perfect_min, perfect_range))) {
+		hash_table.PrepareFinalize();
+	}
+	for (auto &join_filter : join_filters) {
+		hash_table.BuildJoinFilter(*join_filter);
+	}
+	bool swap_pending = sink.swap_pending;
 	PhysicalSink::Finalize(pipeline, context, move(state));
+	if (swap_pending) {
+		return;
+	}
+
+	// the hash map of a perfect HT is already complete
+	idx_t block_count = hash_table.perfect ? 0 : hash_table.PinnedBlockCount();
+	idx_t task_count = MinValue<idx_t>(context.db.NumberOfThreads(), block_count / MIN_FINALIZE_BLOCKS_PER_TASK);
+	if (task_count <= 1) {
+		// small HT: construct the hash map on this thread
+		hash_table.InsertPinnedBlocks(0, block_count, false);
+		return;
+	}
+	// divide the blocks over a set of tasks that construct the hash map in parallel
+	// the pipeline is finished when the last of these tasks completes
+	pipeline.total_tasks += task_count;
+	for (idx_t task_idx = 0; task_idx < task_count; task_idx++) {
+		idx_t block_begin = task_idx * block_count / task_count;
+		idx_t block_end = (task_idx + 1) * block_count / task_count;
+		auto new_task = make_unique<HashJoinFinalizeTask>(pipeline, hash_table, block_begin, block_end);
+		TaskScheduler::GetScheduler(context).ScheduleTask(pipeline.token, move(new_task));
+	}
+}
+
+string PhysicalHashJoin::ParamsToString() const {
+	auto extra_info = PhysicalComparisonJoin::ParamsToString();
+	if (perfect_range > 0) {
+		extra_info += "Perfect Hash\n";
+	}
+	return extra_info;
+}
+
+bool PhysicalHashJoin::ParallelProbe() {
+	if (!sink_state) {
+		return true;
+	}
+	auto &sink = (HashJoinGlobalState &)*sink_state;
+	return !sink.swap_pending;
+}
+
+bool PhysicalHashJoin::HasParallelPhases() {
+	auto &sink = (HashJoinGlobalState &)*sink_state;
+	return sink.hash_table->external || IsRightOuterJoin(join_type);
+}
+
+class HashJoinParallelState : public ParallelState {
+public:
+	HashJoinParallelState() : probing_buffered(false), next_chunk(0), scanning(false), next_block(0) {
+	}
+
+	std::mutex lock;
+	//! Whether or not all threads have finished probing their input, and the buffered input of the currently pinned
+	//! partition group of an external HT is being probed
+	bool probing_buffered;
+	//! The input of every partition group of an external HT, buffered by all threads together
+	vector<unique_ptr<SortedRun>> buffered_runs;
+	//! The next chunk of the buffered input of the pinned group that has to be probed
+	idx_t next_chunk;
+	//! Whether or not all threads have finished probing, and the unmatched build rows are being scanned
+	bool scanning;
+	//! The next block of the HT that has to be scanned for unmatched rows
+	idx_t next_block;
+};
+
+unique_ptr<ParallelState> PhysicalHashJoin::GetParallelState() {
+	return make_unique<HashJoinParallelState>();
+}
+
+idx_t PhysicalHashJoin::StartParallelPhase(ClientContext &context, ParallelState &state_) {
+	auto &state = (HashJoinParallelState &)state_;
+	auto &ht = *((HashJoinGlobalState &)*sink_state).hash_table;
+	if (ht.external && !state.scanning) {
+		if (!state.probing_buffered) {
+			// all threads have finished probing their input: unpin the blocks the buffered input was written to
+			for (auto &run : state.buffered_runs) {
+				run->Finalize();
+			}
+			state.probing_buffered = true;
+		} else if (ht.current_group < state.buffered_runs.size()) {
+			// the buffered input of the previous group has been probed: release it
+			state.buffered_runs[ht.current_group].reset();
+		}
+		// pin the next partition group that has buffered input, and divide its chunks over the threads
+		while (ht.LoadNextGroup()) {
+			if (ht.current_group < state.buffered_runs.size() && state.buffered_runs[ht.current_group]->count > 0) {
+				state.next_chunk = 0;
+				return MinValue<idx_t>(context.db.NumberOfThreads(),
+				                       state.buffered_runs[ht.current_group]->ChunkCount());
+			}
+		}
+		state.buffered_runs.clear();
+		state.probing_buffered = false;
+	}
+	if (!IsRightOuterJoin(join_type) || state.scanning) {
+		return 0;
+	}
+	state.scanning = true;
+	state.next_block = 0;
+	return MinValue<idx_t>(context.db.NumberOfThreads(), ht.BlockCount());
 }
 
 //===--------------------------------------------------------------------===//
@@ -152,13 +319,42 @@ class PhysicalHashJoinState : public PhysicalOperatorState {
 public:
 	PhysicalHashJoinState(PhysicalOperator &op, PhysicalOperator *left, PhysicalOperator *right,
 	                      vector<JoinCondition> &conditions)
-	    : PhysicalOperatorState(op, left) {
+	    : PhysicalOperatorState(op, left), probing_buffered(false), swap_resolved(false) {
 	}
 
 	DataChunk cached_chunk;
 	DataChunk join_keys;
 	ExpressionExecutor probe_executor;
 	unique_ptr<JoinHashTable::ScanStructure> scan_structure;
+
+	//! The following are only used when probing an external HT
+	//! The buffered input rows of every partition group; order does not matter so the runs are never sorted
+	vector<unique_ptr<SortedRun>> buffered_runs;
+	//! The input rows of every partition group that have not been appended to the run yet
+	vector<unique_ptr<DataChunk>> buffered_chunks;
+	//! Whether or not the child is exhausted, and the buffered input is being probed
+	bool probing_buffered;
+	//! The scanner over the buffered input of the current partition group
+	unique_ptr<SortedRunScanner> buffered_scanner;
+
+	//! The scan over the blocks that are assigned to this thread, when the unmatched build rows of a RIGHT/FULL OUTER
+	//! join are scanned in parallel
+	JoinHTScanState outer_scan_state;
+
+	//! The following are only used when the swap of the join sides is pending
+	//! Whether or not the probe input has been collected and the sides of the join have been decided on
+	bool swap_resolved;
+	//! The collected probe input, which is probed before the rest of the input if the sides are not swapped
+	unique_ptr<SortedRun> swap_run;
+	unique_ptr<SortedRunScanner> swap_scanner;
+	//! The HT built over the probe input if the sides are swapped
+	unique_ptr<JoinHashTable> swapped_ht;
+	//! The scan over the entries of the original HT, which are the probe input of the swapped HT
+	JoinHTScanState swap_scan_state;
+	DataChunk swap_keys;
+	DataChunk swap_payload;
+	//! The result of probing the swapped HT: the columns of the original build side come first
+	DataChunk swap_result;
 };
 
 unique_ptr<PhysicalOperatorState> PhysicalHashJoin::GetOperatorState() {
@@ -168,19 +364,36 @@ unique_ptr<PhysicalOperatorState> PhysicalHashJoin::GetOperatorState() {
 	for (auto &cond : conditions) {
 		state->probe_executor.AddExpression(*cond.left);
 	}
+	// blocks are only assigned to the parallel scan of the unmatched rows once the scan has started
+	state->outer_scan_state.block_end = 0;
 	return move(state);
 }
 
 void PhysicalHashJoin::GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
 	auto state = reinterpret_cast<PhysicalHashJoinState *>(state_);
 	auto &sink = (HashJoinGlobalState &)*sink_state;
+	// the state shared with the other threads, if the HT is probed in parallel
+	auto parallel_state = context.task.task_info.find(this);
+	bool parallel_probe = parallel_state != context.task.task_info.end();
+	if (parallel_probe && ((HashJoinParallelState &)*parallel_state->second).scanning) {
+		// all threads have finished probing: scan the unmatched build rows
+		ScanParallelOuter(chunk, state, *parallel_state->second);
+		return;
+	}
 	if (sink.hash_table->size() == 0 &&
 	    (sink.hash_table->join_type == JoinType::INNER || sink.hash_table->join_type == JoinType::SEMI)) {
 		// empty hash table with INNER or SEMI join means empty result set
 		return;
 	}
+	if (sink.swap_pending && !state->swap_resolved) {
+		ResolveSwap(context, state);
+	}
 	do {
-		ProbeHashTable(context, chunk, state);
+		if (state->swapped_ht) {
+			ProbeSwappedHashTable(context, chunk, state);
+		} else {
+			ProbeHashTable(context, chunk, state);
+		}
 		if (chunk.size() == 0) {
 #if STANDARD_VECTOR_SIZE >= 128
 			if (state->cached_chunk.size() > 0) {
@@ -189,8 +402,9 @@ void PhysicalHashJoin::GetChunkInternal(ExecutionContext &context, DataChunk &ch
 				state->cached_chunk.Reset();
 			} else
 #endif
-			    if (IsRightOuterJoin(join_type)) {
+			    if (IsRightOuterJoin(join_type) && !parallel_probe) {
 				// check if we need to scan any unmatched tuples from the RHS for the full/right outer join
+				// if other threads are probing too, the unmatched rows are only scanned once all of them have finished
 				sink.hash_table->ScanFullOuter(chunk, sink.ht_scan_state);
 			}
 			return;
@@ -234,22 +448,315 @@ void PhysicalHashJoin::ProbeHashTable(ExecutionContext &context, DataChunk &chun
 
 	// probe the HT
 	do {
-		// fetch the chunk from the left side
+		if (sink.hash_table->external) {
+			// fetch the next chunk of the currently pinned partition group (this also resolves the join keys)
+			auto parallel_state = context.task.task_info.find(this);
+			FetchExternalProbeChunk(context, state,
+			                        parallel_state == context.task.task_info.end() ? nullptr : parallel_state->second);
+			if (state->child_chunk.size() == 0) {
+				return;
+			}
+		} else {
+			// fetch the chunk from the left side
+			FetchProbeInput(context, state);
+			if (state->child_chunk.size() == 0) {
+				return;
+			}
+			if (sink.hash_table->size() == 0) {
+				ConstructEmptyJoinResult(sink.hash_table->join_type, sink.hash_table->has_null, state->child_chunk,
+				                         chunk);
+				return;
+			}
+			// resolve the join keys for the left chunk
+			state->probe_executor.Execute(state->child_chunk, state->join_keys);
+		}
+
+		// perform the actual probe
+		state->scan_structure = sink.hash_table->Probe(state->join_keys);
+		state->scan_structure->Next(state->join_keys, state->child_chunk, chunk);
+	} while (chunk.size() == 0);
+}
+
+void PhysicalHashJoin::FetchExternalProbeChunk(ExecutionContext &context, PhysicalOperatorState *state_,
+                                               ParallelState *parallel_state_) {
+	auto state = reinterpret_cast<PhysicalHashJoinState *>(state_);
+	auto parallel_state = (HashJoinParallelState *)parallel_state_;
+	auto &ht = *((HashJoinGlobalState &)*sink_state).hash_table;
+	auto &input_types = children[0]->types;
+	if (parallel_state && parallel_state->probing_buffered) {
+		// all threads have finished probing their input: the buffered chunks of the pinned group are divided over them
+		idx_t chunk_index;
+		{
+			lock_guard<mutex> parallel_lock(parallel_state->lock);
+			chunk_index = parallel_state->next_chunk++;
+		}
+		auto &run = *parallel_state->buffered_runs[ht.current_group];
+		if (chunk_index >= run.ChunkCount()) {
+			state->child_chunk.SetCardinality(0);
+			return;
+		}
+		if (!state->buffered_scanner) {
+			state->buffered_scanner = make_unique<SortedRunScanner>(run);
+		}
+		state->buffered_scanner->Seek(chunk_index);
+		state->buffered_scanner->Scan(state->child_chunk);
+		state->probe_executor.Execute(state->child_chunk, state->join_keys);
+		return;
+	}
+	if (state->buffered_chunks.empty() && !state->probing_buffered) {
+		auto &buffer_manager = BufferManager::GetBufferManager(context.client);
+		if (parallel_state) {
+			// the buffered input of all threads is appended to the same runs, so that every group only has a single
+			// block pinned for writing, regardless of the amount of threads
+			lock_guard<mutex> parallel_lock(parallel_state->lock);
+			for (idx_t group = parallel_state->buffered_runs.size(); group < ht.GroupCount(); group++) {
+				parallel_state->buffered_runs.push_back(make_unique<SortedRun>(buffer_manager, input_types));
+			}
+		} else {
+			for (idx_t group = 0; group < ht.GroupCount(); group++) {
+				state->buffered_runs.push_back(make_unique<SortedRun>(buffer_manager, input_types));
+			}
+		}
+		for (idx_t group = 0; group < ht.GroupCount(); group++) {
+			auto buffered_chunk = make_unique<DataChunk>();
+			buffered_chunk->Initialize(input_types);
+			state->buffered_chunks.push_back(move(buffered_chunk));
+		}
+	}
+	while (!state->probing_buffered) {
+		FetchProbeInput(context, state);
+		if (state->child_chunk.size() == 0) {
+			// the child is exhausted: flush the buffered input
+			for (idx_t group = 0; group < ht.GroupCount(); group++) {
+				AppendBufferedChunk(*state, parallel_state, group);
+				if (!parallel_state) {
+					state->buffered_runs[group]->Finalize();
+				}
+			}
+			state->buffered_chunks.clear();
+			state->probing_buffered = true;
+			break;
+		}
+		// partition the chunk: rows of the pinned group are probed right away, the others are buffered until their
+		// group is pinned
+		state->probe_executor.Execute(state->child_chunk, state->join_keys);
+		idx_t groups[STANDARD_VECTOR_SIZE];
+		ht.ComputeGroups(state->join_keys, groups);
+		SelectionVector sel(STANDARD_VECTOR_SIZE);
+		for (idx_t group = 0; group < ht.GroupCount(); group++) {
+			if (group == ht.current_group) {
+				continue;
+			}
+			idx_t group_count = 0;
+			for (idx_t i = 0; i < state->child_chunk.size(); i++) {
+				if (groups[i] == group) {
+					sel.set_index(group_count++, i);
+				}
+			}
+			if (group_count == 0) {
+				continue;
+			}
+			auto &buffered_chunk = *state->buffered_chunks[group];
+			if (buffered_chunk.size() + group_count > STANDARD_VECTOR_SIZE) {
+				AppendBufferedChunk(*state, parallel_state, group);
+			}
+			DataChunk group_chunk;
+			group_chunk.InitializeEmpty(input_types);
+			group_chunk.Slice(state->child_chunk, sel, group_count);
+			buffered_chunk.Append(group_chunk);
+		}
+		idx_t current_count = 0;
+		for (idx_t i = 0; i < state->child_chunk.size(); i++) {
+			if (groups[i] == ht.current_group) {
+				sel.set_index(current_count++, i);
+			}
+		}
+		if (current_count == 0) {
+			continue;
+		}
+		if (current_count < state->child_chunk.size()) {
+			state->child_chunk.Slice(sel, current_count);
+			state->probe_executor.Execute(state->child_chunk, state->join_keys);
+		}
+		return;
+	}
+	if (parallel_state) {
+		// all input has been partitioned: the buffered input is probed once all threads have finished
+		state->child_chunk.SetCardinality(0);
+		return;
+	}
+	// all input has been partitioned: probe the buffered input of the remaining groups one group at a time
+	while (true) {
+		if (state->buffered_scanner) {
+			state->buffered_scanner->Scan(state->child_chunk);
+			if (state->child_chunk.size() > 0) {
+				state->probe_executor.Execute(state->child_chunk, state->join_keys);
+				return;
+			}
+			// the buffered input of this group has been probed: release it
+			state->buffered_scanner.reset();
+			state->buffered_runs[ht.current_group].reset();
+		}
+		if (!ht.LoadNextGroup()) {
+			state->child_chunk.SetCardinality(0);
+			return;
+		}
+		state->buffered_scanner = make_unique<SortedRunScanner>(*state->buffered_runs[ht.current_group]);
+	}
+}
+
+void PhysicalHashJoin::AppendBufferedChunk(PhysicalOperatorState &state_, ParallelState *parallel_state_,
+                                           idx_t group) {
+	auto &state = (PhysicalHashJoinState &)state_;
+	auto &buffered_chunk = *state.buffered_chunks[group];
+	if (buffered_chunk.size() == 0) {
+		return;
+	}
+	if (parallel_state_) {
+		auto &parallel_state = (HashJoinParallelState &)*parallel_state_;
+		lock_guard<mutex> parallel_lock(parallel_state.lock);
+		parallel_state.buffered_runs[group]->Append(buffered_chunk);
+	} else {
+		state.buffered_runs[group]->Append(buffered_chunk);
+	}
+	buffered_chunk.Reset();
+}
+
+void PhysicalHashJoin::FetchProbeInput(ExecutionContext &context, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalHashJoinState *>(state_);
+	if (state->swap_scanner) {
+		state->swap_scanner->Scan(state->child_chunk);
+		if (state->child_chunk.size() > 0) {
+			return;
+		}
+		// the collected input has been probed: release it
+		state->swap_scanner.reset();
+		state->swap_run.reset();
+	}
+	children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+}
+
+void PhysicalHashJoin::ResolveSwap(ExecutionContext &context, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalHashJoinState *>(state_);
+	auto &ht = *((HashJoinGlobalState &)*sink_state).hash_table;
+	auto &buffer_manager = BufferManager::GetBufferManager(context.client);
+	auto &input_types = children[0]->types;
+	state->swap_resolved = true;
+
+	// collect the probe input until it is exhausted, or until it is too large to be worth swapping the sides for
+	state->swap_run = make_unique<SortedRun>(buffer_manager, input_types);
+	bool exhausted = false;
+	while (state->swap_run->count * SWAP_THRESHOLD <= ht.size()) {
 		children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
 		if (state->child_chunk.size() == 0) {
+			exhausted = true;
+			break;
+		}
+		state->swap_run->Append(state->child_chunk);
+	}
+	state->swap_run->Finalize();
+	state->child_chunk.Reset();
+
+	if (exhausted) {
+		// the probe side is small: build a HT over it, and probe it with the entries of the original HT
+		vector<JoinCondition> swapped_conditions;
+		for (auto &cond : conditions) {
+			JoinCondition swapped;
+			swapped.left = cond.right->Copy();
+			swapped.right = cond.left->Copy();
+			swapped.comparison = FlipComparisionExpression(cond.comparison);
+			swapped.null_values_are_equal = cond.null_values_are_equal;
+			swapped_conditions.push_back(move(swapped));
+		}
+		auto swapped_ht = make_unique<JoinHashTable>(buffer_manager, swapped_conditions, input_types, JoinType::INNER);
+		SortedRunScanner scanner(*state->swap_run);
+		while (true) {
+			scanner.Scan(state->child_chunk);
+			if (state->child_chunk.size() == 0) {
+				break;
+			}
+			state->probe_executor.Execute(state->child_chunk, state->join_keys);
+			swapped_ht->Build(state->join_keys, state->child_chunk);
+		}
+		state->child_chunk.Reset();
+		swapped_ht->PrepareFinalize();
+		if (!swapped_ht->external) {
+			swapped_ht->InsertPinnedBlocks(0, swapped_ht->PinnedBlockCount(), false);
+			state->swap_keys.Initialize(condition_types);
+			state->swap_payload.Initialize(build_types);
+			auto result_types = build_types;
+			result_types.insert(result_types.end(), input_types.begin(), input_types.end());
+			state->swap_result.Initialize(result_types);
+			state->swapped_ht = move(swapped_ht);
+			state->swap_run.reset();
 			return;
 		}
-		if (sink.hash_table->size() == 0) {
-			ConstructEmptyJoinResult(sink.hash_table->join_type, sink.hash_table->has_null, state->child_chunk, chunk);
+		// the probe side does not fit in memory either: fall back to probing the (partitioned) original HT
+	}
+	// the probe side is not much smaller than the build side after all: finalize the original HT, and probe it with
+	// the collected input first
+	if (perfect_range == 0 || !ht.TryFinalizePerfect(perfect_min, perfect_range)) {
+		ht.PrepareFinalize();
+	}
+	if (!ht.perfect) {
+		ht.InsertPinnedBlocks(0, ht.PinnedBlockCount(), false);
+	}
+	state->swap_scanner = make_unique<SortedRunScanner>(*state->swap_run);
+}
+
+void PhysicalHashJoin::ProbeSwappedHashTable(ExecutionContext &context, DataChunk &chunk,
+                                             PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalHashJoinState *>(state_);
+	auto &ht = *((HashJoinGlobalState &)*sink_state).hash_table;
+	auto &swapped_ht = *state->swapped_ht;
+	if (swapped_ht.size() == 0) {
+		return;
+	}
+	state->swap_result.Reset();
+	if (state->scan_structure) {
+		state->scan_structure->Next(state->swap_keys, state->swap_payload, state->swap_result);
+	}
+	while (state->swap_result.size() == 0) {
+		// probe the swapped HT with the next batch of entries of the original HT
+		ht.ScanEntries(state->swap_scan_state, state->swap_keys, state->swap_payload);
+		if (state->swap_keys.size() == 0) {
+			state->scan_structure = nullptr;
 			return;
 		}
-		// resolve the join keys for the left chunk
-		state->probe_executor.Execute(state->child_chunk, state->join_keys);
+		state->scan_structure = swapped_ht.Probe(state->swap_keys);
+		state->scan_structure->Next(state->swap_keys, state->swap_payload, state->swap_result);
+	}
+	// the result of the swapped HT has the build side columns first: reorder them into the regular join result
+	idx_t build_column_count = build_types.size();
+	idx_t probe_column_count = chunk.ColumnCount() - build_column_count;
+	for (idx_t i = 0; i < probe_column_count; i++) {
+		chunk.data[i].Reference(state->swap_result.data[build_column_count + i]);
+	}
+	for (idx_t i = 0; i < build_column_count; i++) {
+		chunk.data[probe_column_count + i].Reference(state->swap_result.data[i]);
+	}
+	chunk.SetCardinality(state->swap_result);
+}
 
-		// perform the actual probe
-		state->scan_structure = sink.hash_table->Probe(state->join_keys);
-		state->scan_structure->Next(state->join_keys, state->child_chunk, chunk);
-	} while (chunk.size() == 0);
+void PhysicalHashJoin::ScanParallelOuter(DataChunk &chunk, PhysicalOperatorState *state_,
+                                         ParallelState &parallel_state_) {
+	auto state = reinterpret_cast<PhysicalHashJoinState *>(state_);
+	auto &parallel_state = (HashJoinParallelState &)parallel_state_;
+	auto &ht = *((HashJoinGlobalState &)*sink_state).hash_table;
+	while (true) {
+		ht.ScanFullOuter(chunk, state->outer_scan_state);
+		if (chunk.size() > 0) {
+			return;
+		}
+		// the assigned block has been scanned: fetch the next one
+		lock_guard<mutex> parallel_lock(parallel_state.lock);
+		if (parallel_state.next_block >= ht.BlockCount()) {
+			return;
+		}
+		state->outer_scan_state.block_position = parallel_state.next_block++;
+		state->outer_scan_state.position = 0;
+		state->outer_scan_state.block_end = state->outer_scan_state.block_position + 1;
+	}
 }
 
 } // namespace duckdb
@@ -0,0 +1,666 @@
+#include "duckdb/execution/operator/join/physical_iejoin.hpp"
+
+#include "duckdb/common/types/sort_key.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/sorted_run.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+namespace duckdb {
+
+PhysicalIEJoin::PhysicalIEJoin(LogicalOperator &op, unique_ptr<PhysicalOperator> left,
+                               unique_ptr<PhysicalOperator> right, vector<JoinCondition> cond, JoinType join_type)
+    : PhysicalComparisonJoin(op, PhysicalOperatorType::IE_JOIN, move(cond), join_type) {
+	D_ASSERT(IsSupported(conditions, join_type));
+	for (auto &cond : conditions) {
+		join_key_types.push_back(cond.left->return_type);
+	}
+	if (join_type == JoinType::INNER || join_type == JoinType::LEFT) {
+		// semi and anti joins only output the LHS: the RHS payload does not need to be materialized
+		payload_types = right->types;
+	}
+	children.push_back(move(left));
+	children.push_back(move(right));
+}
+
+bool PhysicalIEJoin::IsSupported(vector<JoinCondition> &conditions, JoinType join_type) {
+	switch (join_type) {
+	case JoinType::INNER:
+	case JoinType::LEFT:
+	case JoinType::SEMI:
+	case JoinType::ANTI:
+		break;
+	default:
+		// the found flags of the RHS rows of right/full outer joins are not tracked
+		return false;
+	}
+	if (conditions.size() != 2) {
+		return false;
+	}
+	for (auto &cond : conditions) {
+		switch (cond.comparison) {
+		case ExpressionType::COMPARE_LESSTHAN:
+		case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+		case ExpressionType::COMPARE_GREATERTHAN:
+		case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+			break;
+		default:
+			return false;
+		}
+		if (cond.null_values_are_equal || cond.left->return_type != cond.right->return_type) {
+			return false;
+		}
+		switch (cond.left->return_type.InternalType()) {
+		case PhysicalType::INT8:
+		case PhysicalType::INT16:
+		case PhysicalType::INT32:
+		case PhysicalType::INT64:
+		case PhysicalType::INT128:
+		case PhysicalType::FLOAT:
+		case PhysicalType::DOUBLE:
+			break;
+		default:
+			// the keys are compared on their sort key encoding, which is only decisive for these types
+			return false;
+		}
+	}
+	return true;
+}
+
+//! Whether or not "l comparison r" holds for values r that are greater than l
+static bool MatchesGreater(ExpressionType comparison) {
+	return comparison == ExpressionType::COMPARE_LESSTHAN || comparison == ExpressionType::COMPARE_LESSTHANOREQUALTO;
+}
+
+//! Whether or not "l comparison r" holds for values r that are equal to l
+static bool MatchesEqual(ExpressionType comparison) {
+	return comparison == ExpressionType::COMPARE_LESSTHANOREQUALTO ||
+	       comparison == ExpressionType::COMPARE_GREATERTHANOREQUALTO;
+}
+
+//! Whether or not "l comparison r" can hold for any l in [left_min, left_max] and r in [right_min, right_max]
+static bool CanMatch(ExpressionType comparison, const_data_ptr_t left_min, const_data_ptr_t left_max,
+                     const_data_ptr_t right_min, const_data_ptr_t right_max, idx_t width) {
+	if (MatchesGreater(comparison)) {
+		auto cmp = memcmp(right_max, left_min, width);
+		return MatchesEqual(comparison) ? cmp >= 0 : cmp > 0;
+	} else {
+		auto cmp = memcmp(right_min, left_max, width);
+		return MatchesEqual(comparison) ? cmp <= 0 : cmp < 0;
+	}
+}
+
+//! Selects the rows of which none of the join keys is NULL, returns the amount of selected rows
+static idx_t SelectNotNull(DataChunk &keys, SelectionVector &sel) {
+	VectorData first_data, second_data;
+	keys.data[0].Orrify(keys.size(), first_data);
+	keys.data[1].Orrify(keys.size(), second_data);
+	idx_t result_count = 0;
+	for (idx_t i = 0; i < keys.size(); i++) {
+		if (!(*first_data.nullmask)[first_data.sel->get_index(i)] &&
+		    !(*second_data.nullmask)[second_data.sel->get_index(i)]) {
+			sel.set_index(result_count++, i);
+		}
+	}
+	return result_count;
+}
+
+//===--------------------------------------------------------------------===//
+// Sink
+//===--------------------------------------------------------------------===//
+class IEJoinGlobalState : public GlobalOperatorState {
+public:
+	IEJoinGlobalState(BufferManager &buffer_manager) : buffer_manager(buffer_manager), count(0) {
+	}
+
+	BufferManager &buffer_manager;
+	//! The lock for updating the global state
+	mutex lock;
+	//! The sorted runs of the RHS, every chunk of a run is a block that is ordered on the first key
+	vector<unique_ptr<SortedRun>> runs;
+	//! The amount of RHS rows of which the join keys are not NULL
+	idx_t count;
+};
+
+class IEJoinLocalState : public LocalSinkState {
+public:
+	IEJoinLocalState(PhysicalIEJoin &op) {
+		for (auto &cond : op.conditions) {
+			rhs_executor.AddExpression(*cond.right);
+		}
+		join_keys.Initialize(op.join_key_types);
+		vector<LogicalType> sink_types = op.join_key_types;
+		sink_types.insert(sink_types.end(), op.payload_types.begin(), op.payload_types.end());
+		sink_chunk.InitializeEmpty(sink_types);
+	}
+
+	//! The executor of the RHS conditions
+	ExpressionExecutor rhs_executor;
+	//! The join keys of the RHS chunk
+	DataChunk join_keys;
+	//! The chunk combining the join keys and the payload
+	DataChunk sink_chunk;
+	//! The data that has not been sorted into a run yet
+	ChunkCollection unsorted;
+};
+
+unique_ptr<GlobalOperatorState> PhysicalIEJoin::GetGlobalState(ClientContext &context) {
+	return make_unique<IEJoinGlobalState>(BufferManager::GetBufferManager(context));
+}
+
+unique_ptr<LocalSinkState> PhysicalIEJoin::GetLocalSinkState(ExecutionContext &context) {
+	return make_unique<IEJoinLocalState>(*this);
+}
+
+//! Sorts the thread-local data on the first key into a run. Every chunk of the run stores the row order of the chunk
+//! on the second key after the join keys, followed by the payload.
+static void SortLocalData(IEJoinGlobalState &gstate, IEJoinLocalState &lstate) {
+	auto &unsorted = lstate.unsorted;
+	if (unsorted.Count() == 0) {
+		return;
+	}
+	auto sorted_vector = unique_ptr<idx_t[]>(new idx_t[unsorted.Count()]);
+	vector<OrderType> order_types {OrderType::ASCENDING};
+	vector<OrderByNullType> null_orders {OrderByNullType::NULLS_LAST};
+	unsorted.Sort(order_types, null_orders, sorted_vector.get());
+
+	auto run_types = unsorted.Types();
+	run_types.insert(run_types.begin() + 2, LogicalType::INTEGER);
+	auto run = make_unique<SortedRun>(gstate.buffer_manager, run_types);
+
+	SortKeyEncoder encoder({run_types[1]}, {OrderType::ASCENDING}, {OrderByNullType::NULLS_LAST});
+	auto keys = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * encoder.key_width]);
+	idx_t order[STANDARD_VECTOR_SIZE];
+	Vector second_order(LogicalType::INTEGER);
+	auto second_order_data = FlatVector::GetData<int32_t>(second_order);
+
+	DataChunk sorted_chunk;
+	sorted_chunk.Initialize(unsorted.Types());
+	DataChunk block;
+	block.InitializeEmpty(run_types);
+	for (idx_t position = 0; position < unsorted.Count(); position += STANDARD_VECTOR_SIZE) {
+		sorted_chunk.Reset();
+		unsorted.MaterializeSortedChunk(sorted_chunk, sorted_vector.get(), position);
+		auto count = sorted_chunk.size();
+		// order the rows of the block on the second key
+		encoder.EncodeColumn(sorted_chunk.data[1], count, 0, keys.get(), encoder.key_width);
+		for (idx_t i = 0; i < count; i++) {
+			order[i] = i;
+		}
+		encoder.SortKeys(keys.get(), order, count);
+		for (idx_t i = 0; i < count; i++) {
+			second_order_data[i] = order[i];
+		}
+		block.data[0].Reference(sorted_chunk.data[0]);
+		block.data[1].Reference(sorted_chunk.data[1]);
+		block.data[2].Reference(second_order);
+		for (idx_t col_idx = 2; col_idx < sorted_chunk.ColumnCount(); col_idx++) {
+			block.data[col_idx + 1].Reference(sorted_chunk.data[col_idx]);
+		}
+		block.SetCardinality(count);
+		run->Append(block);
+	}
+	run->Finalize();
+	unsorted.Reset();
+
+	lock_guard<mutex> glock(gstate.lock);
+	gstate.count += run->count;
+	gstate.runs.push_back(move(run));
+}
+
+void PhysicalIEJoin::Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate_p,
+                          DataChunk &input) {
+	auto &gstate = (IEJoinGlobalState &)state;
+	auto &lstate = (IEJoinLocalState &)lstate_p;
+
+	// resolve the join keys for this chunk
+	lstate.join_keys.Reset();
+	lstate.rhs_executor.Execute(input, lstate.join_keys);
+
+	// rows with a NULL key can never find a match: drop them
+	SelectionVector sel(STANDARD_VECTOR_SIZE);
+	idx_t count = SelectNotNull(lstate.join_keys, sel);
+	if (count == 0) {
+		return;
+	}
+	auto &sink_chunk = lstate.sink_chunk;
+	sink_chunk.data[0].Reference(lstate.join_keys.data[0]);
+	sink_chunk.data[1].Reference(lstate.join_keys.data[1]);
+	for (idx_t col_idx = 0; col_idx < payload_types.size(); col_idx++) {
+		sink_chunk.data[2 + col_idx].Reference(input.data[col_idx]);
+	}
+	sink_chunk.SetCardinality(input);
+	if (count < input.size()) {
+		sink_chunk.Slice(sel, count);
+	}
+	lstate.unsorted.Append(sink_chunk);
+
+	if (lstate.unsorted.Count() >= IEJOIN_RUN_SIZE) {
+		SortLocalData(gstate, lstate);
+	}
+}
+
+void PhysicalIEJoin::Combine(ExecutionContext &context, GlobalOperatorState &gstate, LocalSinkState &lstate) {
+	SortLocalData((IEJoinGlobalState &)gstate, (IEJoinLocalState &)lstate);
+}
+
+//===--------------------------------------------------------------------===//
+// IEJoin
+//===--------------------------------------------------------------------===//
+//! The encoded join keys of (at most STANDARD_VECTOR_SIZE) rows, together with the order of the rows on both keys
+struct IEJoinKeys {
+	IEJoinKeys(idx_t first_width, idx_t second_width)
+	    : first_width(first_width), second_width(second_width), count(0) {
+		first_keys = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * first_width]);
+		second_keys = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * second_width]);
+	}
+
+	idx_t first_width;
+	idx_t second_width;
+	unique_ptr<data_t[]> first_keys;
+	unique_ptr<data_t[]> second_keys;
+	//! The rows of which the keys are not NULL, in the order of the first key
+	idx_t first_order[STANDARD_VECTOR_SIZE];
+	//! The rows of which the keys are not NULL, in the order of the second key
+	idx_t second_order[STANDARD_VECTOR_SIZE];
+	//! The amount of rows of which the keys are not NULL
+	idx_t count;
+
+	data_ptr_t GetFirst(idx_t row) {
+		return first_keys.get() + row * first_width;
+	}
+	data_ptr_t GetSecond(idx_t row) {
+		return second_keys.get() + row * second_width;
+	}
+};
+
+//! The IEJoin of the rows of an LHS chunk with a single RHS block. The rows of both sides are visited in the order of
+//! the second condition, such that the RHS rows that satisfy the second condition for an LHS row are exactly the RHS
+//! rows visited before it. The visited RHS rows are marked in a bitmap over the block, which is ordered on the first
+//! key: the RHS rows that satisfy the first condition form a prefix or a suffix of the block.
+class IEJoinPair {
+public:
+	IEJoinPair(ExpressionType first, ExpressionType second)
+	    : first_greater(MatchesGreater(first)), first_equal(MatchesEqual(first)),
+	      second_greater(MatchesGreater(second)), second_equal(MatchesEqual(second)) {
+	}
+
+	//! Starts the join of the given LHS rows with the given RHS block
+	void Initialize(IEJoinKeys &left, IEJoinKeys &right);
+	//! Writes the next matching pairs to the selection vectors and returns their amount (at most
+	//! STANDARD_VECTOR_SIZE), returns 0 if all matches have been produced
+	idx_t Next(IEJoinKeys &left, IEJoinKeys &right, SelectionVector &left_result, SelectionVector &right_result);
+	//! Sets found_match for every LHS row that has a match in the block
+	void FindMatches(IEJoinKeys &left, IEJoinKeys &right, bool found_match[]);
+
+private:
+	//! Whether or not the RHS rows that satisfy the first condition have greater keys than the LHS row, and whether
+	//! or not the RHS rows with keys equal to the LHS row satisfy it
+	bool first_greater;
+	bool first_equal;
+	//! The same for the second condition
+	bool second_greater;
+	bool second_equal;
+
+	//! For every LHS row, the amount of RHS rows that precede it in the order of the first key
+	idx_t cuts[STANDARD_VECTOR_SIZE];
+	//! The visited RHS rows
+	vector<uint64_t> bitmap;
+	//! The amount of visited LHS and RHS rows
+	idx_t left_position;
+	idx_t right_position;
+	//! The current LHS row, and the range of the bitmap that remains to be scanned for it
+	idx_t current_left;
+	idx_t bit_position;
+	idx_t bit_end;
+
+private:
+	//! The LHS and RHS row that are visited next: rows are visited in descending order if the RHS rows that satisfy
+	//! the second condition are greater than the LHS row
+	idx_t NextLeft(IEJoinKeys &left) {
+		return left.second_order[second_greater ? left.count - 1 - left_position : left_position];
+	}
+	idx_t NextRight(IEJoinKeys &right) {
+		return right.second_order[second_greater ? right.count - 1 - right_position : right_position];
+	}
+	//! Whether or not an RHS row is visited next
+	bool NextIsRight(IEJoinKeys &left, IEJoinKeys &right) {
+		if (right_position >= right.count) {
+			return false;
+		}
+		if (left_position >= left.count) {
+			return true;
+		}
+		auto cmp = memcmp(right.GetSecond(NextRight(right)), left.GetSecond(NextLeft(left)), left.second_width);
+		if (second_greater) {
+			cmp = -cmp;
+		}
+		return cmp < 0 || (cmp == 0 && second_equal);
+	}
+	//! Visits the next LHS row: sets up the range of the bitmap that satisfies the first condition
+	void VisitLeft(IEJoinKeys &left, IEJoinKeys &right) {
+		current_left = NextLeft(left);
+		left_position++;
+		auto cut = cuts[current_left];
+		bit_position = first_greater ? cut : 0;
+		bit_end = first_greater ? right.count : cut;
+	}
+	void VisitRight(IEJoinKeys &right) {
+		auto row = NextRight(right);
+		bitmap[row / 64] |= uint64_t(1) << (row % 64);
+		right_position++;
+	}
+	//! Returns the next set bit in [bit_position, bit_end), or bit_end if there is none
+	idx_t NextBit() {
+		while (bit_position < bit_end) {
+			auto word_idx = bit_position / 64;
+			auto word = bitmap[word_idx] & (~uint64_t(0) << (bit_position % 64));
+			if (word != 0) {
+				return MinValue<idx_t>(word_idx * 64 + CountTrailingZeros(word), bit_end);
+			}
+			bit_position = (word_idx + 1) * 64;
+		}
+		return bit_end;
+	}
+};
+
+void IEJoinPair::Initialize(IEJoinKeys &left, IEJoinKeys &right) {
+	// the block is ordered on the first key: for every LHS row find the position in the block where the RHS rows that
+	// satisfy the first condition start (or end)
+	bool count_equal = first_greater != first_equal;
+	idx_t right_idx = 0;
+	for (idx_t i = 0; i < left.count; i++) {
+		auto row = left.first_order[i];
+		auto key = left.GetFirst(row);
+		while (right_idx < right.count) {
+			auto cmp = memcmp(right.GetFirst(right_idx), key, left.first_width);
+			if (cmp > 0 || (cmp == 0 && !count_equal)) {
+				break;
+			}
+			right_idx++;
+		}
+		cuts[row] = right_idx;
+	}
+	bitmap.assign((right.count + 63) / 64, 0);
+	left_position = 0;
+	right_position = 0;
+	bit_position = 0;
+	bit_end = 0;
+}
+
+idx_t IEJoinPair::Next(IEJoinKeys &left, IEJoinKeys &right, SelectionVector &left_result,
+                       SelectionVector &right_result) {
+	idx_t result_count = 0;
+	while (true) {
+		// output the visited RHS rows that satisfy the first condition for the current LHS row
+		while (true) {
+			auto bit = NextBit();
+			if (bit >= bit_end) {
+				bit_position = bit_end;
+				break;
+			}
+			left_result.set_index(result_count, current_left);
+			right_result.set_index(result_count, bit);
+			result_count++;
+			bit_position = bit + 1;
+			if (result_count == STANDARD_VECTOR_SIZE) {
+				return result_count;
+			}
+		}
+		if (left_position >= left.count) {
+			// all LHS rows have been visited
+			return result_count;
+		}
+		if (NextIsRight(left, right)) {
+			VisitRight(right);
+		} else {
+			VisitLeft(left, right);
+		}
+	}
+}
+
+void IEJoinPair::FindMatches(IEJoinKeys &left, IEJoinKeys &right, bool found_match[]) {
+	while (left_position < left.count) {
+		if (NextIsRight(left, right)) {
+			VisitRight(right);
+			continue;
+		}
+		VisitLeft(left, right);
+		if (!found_match[current_left] && NextBit() < bit_end) {
+			found_match[current_left] = true;
+		}
+	}
+}
+
+//===--------------------------------------------------------------------===//
+// GetChunkInternal
+//===--------------------------------------------------------------------===//
+class PhysicalIEJoinState : public PhysicalOperatorState {
+public:
+	PhysicalIEJoinState(PhysicalIEJoin &op, PhysicalOperator *left)
+	    : PhysicalOperatorState(op, left),
+	      first_encoder({op.join_key_types[0]}, {OrderType::ASCENDING}, {OrderByNullType::NULLS_LAST}),
+	      second_encoder({op.join_key_types[1]}, {OrderType::ASCENDING}, {OrderByNullType::NULLS_LAST}),
+	      left_keys(first_encoder.key_width, second_encoder.key_width),
+	      right_keys(first_encoder.key_width, second_encoder.key_width),
+	      pair(op.conditions[0].comparison, op.conditions[1].comparison), fetch_next_left(true), run_idx(0),
+	      left_result(STANDARD_VECTOR_SIZE), right_result(STANDARD_VECTOR_SIZE) {
+		for (auto &cond : op.conditions) {
+			lhs_executor.AddExpression(*cond.left);
+		}
+		join_keys.Initialize(op.join_key_types);
+		vector<LogicalType> run_types = op.join_key_types;
+		run_types.push_back(LogicalType::INTEGER);
+		run_types.insert(run_types.end(), op.payload_types.begin(), op.payload_types.end());
+		right_chunk.Initialize(run_types);
+		right_payload.InitializeEmpty(op.payload_types);
+	}
+
+	//! The executor of the LHS conditions
+	ExpressionExecutor lhs_executor;
+	//! The join keys of the LHS chunk
+	DataChunk join_keys;
+	SortKeyEncoder first_encoder;
+	SortKeyEncoder second_encoder;
+	//! The encoded keys of the LHS chunk and of the current RHS block
+	IEJoinKeys left_keys;
+	IEJoinKeys right_keys;
+	//! The join of the LHS chunk with the current RHS block
+	IEJoinPair pair;
+
+	bool fetch_next_left;
+	//! The run of the current RHS block
+	idx_t run_idx;
+	unique_ptr<SortedRunScanner> scanner;
+	//! The current RHS block
+	DataChunk right_chunk;
+	//! The payload columns of the current RHS block
+	DataChunk right_payload;
+	SelectionVector left_result;
+	SelectionVector right_result;
+	unique_ptr<bool[]> left_found_match;
+
+public:
+	//! Computes and sorts the join keys of the LHS chunk
+	void InitializeLeft() {
+		join_keys.Reset();
+		lhs_executor.Execute(child_chunk, join_keys);
+		SelectionVector sel(STANDARD_VECTOR_SIZE);
+		left_keys.count = SelectNotNull(join_keys, sel);
+		first_encoder.EncodeColumn(join_keys.data[0], join_keys.size(), 0, left_keys.first_keys.get(),
+		                           left_keys.first_width);
+		second_encoder.EncodeColumn(join_keys.data[1], join_keys.size(), 0, left_keys.second_keys.get(),
+		                            left_keys.second_width);
+		for (idx_t i = 0; i < left_keys.count; i++) {
+			left_keys.first_order[i] = sel.get_index(i);
+			left_keys.second_order[i] = sel.get_index(i);
+		}
+		first_encoder.SortKeys(left_keys.first_keys.get(), left_keys.first_order, left_keys.count);
+		second_encoder.SortKeys(left_keys.second_keys.get(), left_keys.second_order, left_keys.count);
+		run_idx = 0;
+		scanner.reset();
+	}
+
+	//! Moves to the next RHS block that can contain matches for the LHS chunk and starts the join with it. Returns
+	//! false if all blocks have been joined.
+	bool NextBlock(PhysicalIEJoin &op, IEJoinGlobalState &gstate) {
+		if (left_keys.count == 0) {
+			return false;
+		}
+		while (run_idx < gstate.runs.size()) {
+			if (!scanner) {
+				scanner = make_unique<SortedRunScanner>(*gstate.runs[run_idx]);
+			}
+			scanner->Scan(right_chunk);
+			if (right_chunk.size() == 0) {
+				// exhausted this run: move to the next one
+				scanner.reset();
+				run_idx++;
+				continue;
+			}
+			LoadBlock();
+			// skip the block if the ranges of the keys show that no pair of rows can satisfy both conditions
+			if (!CanMatch(op.conditions[0].comparison, left_keys.GetFirst(left_keys.first_order[0]),
+			              left_keys.GetFirst(left_keys.first_order[left_keys.count - 1]), right_keys.GetFirst(0),
+			              right_keys.GetFirst(right_keys.count - 1), left_keys.first_width) ||
+			    !CanMatch(op.conditions[1].comparison, left_keys.GetSecond(left_keys.second_order[0]),
+			              left_keys.GetSecond(left_keys.second_order[left_keys.count - 1]),
+			              right_keys.GetSecond(right_keys.second_order[0]),
+			              right_keys.GetSecond(right_keys.second_order[right_keys.count - 1]),
+			              left_keys.second_width)) {
+				continue;
+			}
+			pair.Initialize(left_keys, right_keys);
+			return true;
+		}
+		return false;
+	}
+
+private:
+	//! Encodes the keys of the current RHS block, the block is ordered on the first key
+	void LoadBlock() {
+		auto count = right_chunk.size();
+		right_keys.count = count;
+		first_encoder.EncodeColumn(right_chunk.data[0], count, 0, right_keys.first_keys.get(), right_keys.first_width);
+		second_encoder.EncodeColumn(right_chunk.data[1], count, 0, right_keys.second_keys.get(),
+		                            right_keys.second_width);
+		auto second_order = FlatVector::GetData<int32_t>(right_chunk.data[2]);
+		for (idx_t i = 0; i < count; i++) {
+			right_keys.first_order[i] = i;
+			right_keys.second_order[i] = second_order[i];
+		}
+		for (idx_t col_idx = 0; col_idx < right_payload.ColumnCount(); col_idx++) {
+			right_payload.data[col_idx].Reference(right_chunk.data[3 + col_idx]);
+		}
+		right_payload.SetCardinality(count);
+	}
+};
+
+void PhysicalIEJoin::ResolveSimpleJoin(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalIEJoinState *>(state_);
+	auto &gstate = (IEJoinGlobalState &)*sink_state;
+	do {
+		children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+		if (state->child_chunk.size() == 0) {
+			return;
+		}
+		state->InitializeLeft();
+		bool found_match[STANDARD_VECTOR_SIZE] = {false};
+		while (state->NextBlock(*this, gstate)) {
+			state->pair.FindMatches(state->left_keys, state->right_keys, found_match);
+		}
+		switch (join_type) {
+		case JoinType::SEMI:
+			PhysicalJoin::ConstructSemiJoinResult(state->child_chunk, chunk, found_match);
+			break;
+		case JoinType::ANTI:
+			PhysicalJoin::ConstructAntiJoinResult(state->child_chunk, chunk, found_match);
+			break;
+		default:
+			throw NotImplementedException("Unimplemented join type for IEJoin");
+		}
+	} while (chunk.size() == 0);
+}
+
+void PhysicalIEJoin::ResolveComplexJoin(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalIEJoinState *>(state_);
+	auto &gstate = (IEJoinGlobalState &)*sink_state;
+	do {
+		if (state->fetch_next_left) {
+			if (state->left_found_match) {
+				// left join: before we move to the next chunk, output the rows that did not find a match
+				PhysicalJoin::ConstructLeftJoinResult(state->child_chunk, chunk, state->left_found_match.get());
+				state->left_found_match.reset();
+				if (chunk.size() > 0) {
+					return;
+				}
+			}
+			children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+			if (state->child_chunk.size() == 0) {
+				return;
+			}
+			if (join_type == JoinType::LEFT) {
+				state->left_found_match = unique_ptr<bool[]>(new bool[STANDARD_VECTOR_SIZE]);
+				memset(state->left_found_match.get(), 0, sizeof(bool) * STANDARD_VECTOR_SIZE);
+			}
+			state->InitializeLeft();
+			if (!state->NextBlock(*this, gstate)) {
+				continue;
+			}
+			state->fetch_next_left = false;
+		}
+		auto result_count =
+		    state->pair.Next(state->left_keys, state->right_keys, state->left_result, state->right_result);
+		if (result_count == 0) {
+			// exhausted this block: move to the next one
+			if (!state->NextBlock(*this, gstate)) {
+				state->fetch_next_left = true;
+			}
+			continue;
+		}
+		if (state->left_found_match) {
+			for (idx_t i = 0; i < result_count; i++) {
+				state->left_found_match[state->left_result.get_index(i)] = true;
+			}
+		}
+		chunk.Slice(state->child_chunk, state->left_result, result_count);
+		chunk.Slice(state->right_payload, state->right_result, result_count, state->child_chunk.ColumnCount());
+	} while (chunk.size() == 0);
+}
+
+void PhysicalIEJoin::GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
+	auto state = reinterpret_cast<PhysicalIEJoinState *>(state_);
+	auto &gstate = (IEJoinGlobalState &)*sink_state;
+
+	if (gstate.count == 0) {
+		// empty RHS: construct empty result
+		if (join_type == JoinType::SEMI || join_type == JoinType::INNER) {
+			return;
+		}
+		children[0]->GetChunk(context, state->child_chunk, state->child_state.get());
+		if (state->child_chunk.size() == 0) {
+			return;
+		}
+		ConstructEmptyJoinResult(join_type, false, state->child_chunk, chunk);
+		return;
+	}
+
+	switch (join_type) {
+	case JoinType::SEMI:
+	case JoinType::ANTI:
+		// simple joins can have max STANDARD_VECTOR_SIZE matches per chunk
+		ResolveSimpleJoin(context, chunk, state_);
+		break;
+	case JoinType::LEFT:
+	case JoinType::INNER:
+		ResolveComplexJoin(context, chunk, state_);
+		break;
+	default:
+		throw NotImplementedException("Unimplemented type for IEJoin!");
+	}
+}
+
+unique_ptr<PhysicalOperatorState> PhysicalIEJoin::GetOperatorState() {
+	return make_unique<PhysicalIEJoinState>(*this, children[0].get());
+}
+
+} // namespace duckdb
@@ -9,7 +9,7 @@
 #include "duckdb/storage/storage_manager.hpp"
 #include "duckdb/transaction/transaction.hpp"
 
-#include <iostream>
+#include <algorithm>
 #include <utility>
 
 namespace duckdb {
@@ -20,7 +20,7 @@ public:
 	    : PhysicalOperatorState(op, left) {
 		D_ASSERT(left && right);
 		for (idx_t i = 0; i < STANDARD_VECTOR_SIZE; i++) {
-			rhs_rows.emplace_back();
+			rhs_leaves.emplace_back();
 			result_sizes.emplace_back();
 		}
 	}
@@ -30,8 +30,8 @@ public:
 	idx_t result_size = 0;
 	vector<idx_t> result_sizes;
 	DataChunk join_keys;
-	//! Vector of rows that mush be fetched for every LHS key
-	vector<vector<row_t>> rhs_rows;
+	//! The leaf holding the rows that must be fetched for every LHS key
+	vector<Leaf *> rhs_leaves;
 	ExpressionExecutor probe_executor;
 	IndexLock lock;
 };
@@ -60,6 +60,10 @@ PhysicalIndexJoin::PhysicalIndexJoin(LogicalOperator &op, unique_ptr<PhysicalOpe
 			fetch_types.push_back(children[1]->types[column_id]);
 		}
 	}
+	//! Also fetch the row ids, to find out which of the fetched rows are visible to the transaction. This is needed
+	//! even if no other columns are fetched, as the index also holds rows that are not visible
+	fetch_ids.push_back(COLUMN_IDENTIFIER_ROW_ID);
+	fetch_types.push_back(LOGICAL_ROW_TYPE);
 }
 
 void PhysicalIndexJoin::Output(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
@@ -71,16 +75,14 @@ void PhysicalIndexJoin::Output(ExecutionContext &context, DataChunk &chunk, Phys
 	idx_t rhs_column_idx = 0;
 	SelectionVector sel;
 	sel.Initialize(STANDARD_VECTOR_SIZE);
-	size_t output_sel_idx{};
-	vector<row_t> fetch_rows;
+	size_t output_sel_idx {};
+	row_t fetch_rows[STANDARD_VECTOR_SIZE];
 	auto state = reinterpret_cast<PhysicalIndexJoinOperatorState *>(state_);
 	while (output_sel_idx < STANDARD_VECTOR_SIZE && state->lhs_idx < state->child_chunk.size()) {
 		if (state->rhs_idx < state->result_sizes[state->lhs_idx]) {
+			//! We need to collect the rows we want to fetch
+			fetch_rows[output_sel_idx] = state->rhs_leaves[state->lhs_idx]->GetRowId(state->rhs_idx);
 			sel.set_index(output_sel_idx++, state->lhs_idx);
-			if (!fetch_types.empty()) {
-				//! We need to collect the rows we want to fetch
-				fetch_rows.push_back(state->rhs_rows[state->lhs_idx][state->rhs_idx]);
-			}
 			state->rhs_idx++;
 		} else {
 			//! We are done with the matches from this LHS Key
@@ -89,17 +91,48 @@ void PhysicalIndexJoin::Output(ExecutionContext &context, DataChunk &chunk, Phys
 		}
 	}
 	//! Now we fetch the RHS data
-	if (!fetch_types.empty()) {
-		if (fetch_rows.size() == 0) {
-			return;
+	SelectionVector rhs_sel;
+	if (output_sel_idx == 0) {
+		return;
+	}
+	//! Fetch the rows in the order of their row ids, so the rows of a segment are fetched together
+	idx_t fetch_order[STANDARD_VECTOR_SIZE];
+	for (idx_t i = 0; i < output_sel_idx; i++) {
+		fetch_order[i] = i;
+	}
+	std::sort(fetch_order, fetch_order + output_sel_idx,
+	          [&](idx_t a, idx_t b) { return fetch_rows[a] < fetch_rows[b]; });
+	row_t sorted_rows[STANDARD_VECTOR_SIZE];
+	for (idx_t i = 0; i < output_sel_idx; i++) {
+		sorted_rows[i] = fetch_rows[fetch_order[i]];
+	}
+	rhs_chunk.Initialize(fetch_types);
+	ColumnFetchState fetch_state;
+	Vector row_ids;
+	row_ids.type = LOGICAL_ROW_TYPE;
+	FlatVector::SetData(row_ids, (data_ptr_t)sorted_rows);
+	tbl->Fetch(transaction, rhs_chunk, fetch_ids, row_ids, output_sel_idx, fetch_state);
+
+	//! The fetch skips the rows that are not visible to the transaction: find the fetched row of every match
+	auto fetched_rows = FlatVector::GetData<row_t>(rhs_chunk.data.back());
+	idx_t fetched_idx[STANDARD_VECTOR_SIZE];
+	idx_t fetched_count = 0;
+	for (idx_t i = 0; i < output_sel_idx; i++) {
+		if (fetched_count < rhs_chunk.size() && fetched_rows[fetched_count] == sorted_rows[i]) {
+			fetched_idx[fetch_order[i]] = fetched_count++;
+		} else {
+			fetched_idx[fetch_order[i]] = INVALID_INDEX;
 		}
-		rhs_chunk.Initialize(fetch_types);
-		ColumnFetchState fetch_state;
-		Vector row_ids;
-		row_ids.type = LOGICAL_ROW_TYPE;
-		FlatVector::SetData(row_ids, (data_ptr_t)&fetch_rows[0]);
-		tbl->Fetch(transaction, rhs_chunk, fetch_ids, row_ids, output_sel_idx, fetch_state);
 	}
+	rhs_sel.Initialize(STANDARD_VECTOR_SIZE);
+	idx_t result_count = 0;
+	for (idx_t i = 0; i < output_sel_idx; i++) {
+		if (fetched_idx[i] != INVALID_INDEX) {
+			sel.set_index(result_count, sel.get_index(i));
+			rhs_sel.set_index(result_count++, fetched_idx[i]);
+		}
+	}
+	output_sel_idx = result_count;
 
 	//! Now we actually produce our result chunk
 	idx_t left_offset = lhs_first ? 0 : right_projection_map.size();
@@ -107,7 +140,7 @@ void PhysicalIndexJoin::Output(ExecutionContext &context, DataChunk &chunk, Phys
 	for (idx_t i = 0; i < right_projection_map.size(); i++) {
 		auto it = index_ids.find(column_ids[right_projection_map[i]]);
 		if (it == index_ids.end()) {
-			chunk.data[right_offset + i].Reference(rhs_chunk.data[rhs_column_idx++]);
+			chunk.data[right_offset + i].Slice(rhs_chunk.data[rhs_column_idx++], rhs_sel, output_sel_idx);
 		} else {
 			chunk.data[right_offset + i].Reference(state->join_keys.data[0]);
 			chunk.data[right_offset + i].Slice(sel, output_sel_idx);
@@ -125,23 +158,11 @@ void PhysicalIndexJoin::Output(ExecutionContext &context, DataChunk &chunk, Phys
 void PhysicalIndexJoin::GetRHSMatches(ExecutionContext &context, PhysicalOperatorState *state_) const {
 	auto state = reinterpret_cast<PhysicalIndexJoinOperatorState *>(state_);
 	auto &art = (ART &)*index;
-	auto &transaction = Transaction::GetTransaction(context.client);
+	//! Look up all keys of the LHS chunk at once
+	art.SearchEqualJoin(state->join_keys, state->rhs_leaves.data());
 	for (idx_t i = 0; i < state->child_chunk.size(); i++) {
-		auto equal_value = state->join_keys.GetValue(0, i);
-		auto index_state = art.InitializeScanSinglePredicate(transaction, equal_value, ExpressionType::COMPARE_EQUAL);
-		state->rhs_rows[i].clear();
-		if (!equal_value.is_null) {
-			if (fetch_types.empty()) {
-				//! Nothing to materialize
-				art.SearchEqualJoinNoFetch(equal_value, state->result_sizes[i]);
-			} else {
-				art.SearchEqual((ARTIndexScanState *)index_state.get(), (size_t)-1, state->rhs_rows[i]);
-				state->result_sizes[i] = state->rhs_rows[i].size();
-			}
-		} else {
-			//! This is null so no matches
-			state->result_sizes[i] = 0;
-		}
+		auto leaf = state->rhs_leaves[i];
+		state->result_sizes[i] = leaf ? leaf->num_elements : 0;
 	}
 	for (idx_t i = state->child_chunk.size(); i < STANDARD_VECTOR_SIZE; i++) {
 		//! No LHS chunk value so result size is empty
@@ -3,7 +3,11 @@
 #include "duckdb/common/vector_operations/vector_operations.hpp"
 #include "duckdb/execution/expression_executor.hpp"
 #include "duckdb/execution/merge_join.hpp"
-#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/execution/sorted_run.hpp"
+#include "duckdb/common/types/sort_key.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+#include <algorithm>
 
 namespace duckdb {
 
@@ -28,46 +32,126 @@ PhysicalPiecewiseMergeJoin::PhysicalPiecewiseMergeJoin(LogicalOperator &op, uniq
 //===--------------------------------------------------------------------===//
 class MergeJoinLocalState : public LocalSinkState {
 public:
-	MergeJoinLocalState(vector<JoinCondition> &conditions) {
+	MergeJoinLocalState(PhysicalPiecewiseMergeJoin &op) {
 		vector<LogicalType> condition_types;
-		for (auto &cond : conditions) {
+		for (auto &cond : op.conditions) {
 			rhs_executor.AddExpression(*cond.right);
 			condition_types.push_back(cond.right->return_type);
 		}
 		join_keys.Initialize(condition_types);
+		vector<LogicalType> run_types = condition_types;
+		run_types.insert(run_types.end(), op.children[1]->types.begin(), op.children[1]->types.end());
+		run_chunk.InitializeEmpty(run_types);
 	}
 
 	//! The chunk holding the right condition
 	DataChunk join_keys;
 	//! The executor of the RHS condition
 	ExpressionExecutor rhs_executor;
+	//! The chunk combining the join key and the RHS data
+	DataChunk run_chunk;
+	//! The data that has not been sorted into a run yet
+	ChunkCollection unsorted;
+};
+
+//! A run of the RHS, sorted on the join key. The run holds the join key followed by the RHS data.
+struct MergeJoinRun {
+	unique_ptr<SortedRun> run;
+	//! The smallest and largest join key of every chunk of the run. The NULL keys are sorted last: the chunks that
+	//! only hold NULL keys have no bounds.
+	vector<Value> chunk_min;
+	vector<Value> chunk_max;
+	//! The index of the first row of the run in the right_found_match
+	idx_t offset;
 };
 
 class MergeJoinGlobalState : public GlobalOperatorState {
 public:
-	MergeJoinGlobalState() : has_null(false), right_outer_position(0) {
+	MergeJoinGlobalState(BufferManager &buffer_manager)
+	    : buffer_manager(buffer_manager), count(0), has_null(false), right_outer_run(0), right_outer_position(0) {
 	}
 
-	//! The materialized data of the RHS
-	ChunkCollection right_chunks;
-	//! The materialized join keys of the RHS
-	ChunkCollection right_conditions;
-	//! The join orders of the RHS
-	vector<MergeOrder> right_orders;
+	BufferManager &buffer_manager;
+	//! The lock for updating the global state
+	mutex lock;
+	//! The sorted runs of the RHS
+	vector<MergeJoinRun> runs;
+	//! The total amount of rows in the RHS
+	idx_t count;
+	//! The smallest and largest non-NULL join key of the RHS
+	Value min;
+	Value max;
+	//! A single chunk holding the smallest and largest join key of the RHS, and its order. Joins that output max N
+	//! elements (SEMI, ANTI, MARK) only need these to decide whether an LHS row has a match.
+	ChunkCollection right_bounds;
+	vector<MergeOrder> right_bounds_order;
 	//! Whether or not the RHS of the nested loop join has NULL values
 	bool has_null;
 	//! A bool indicating for each tuple in the RHS if they found a match (only used in FULL OUTER JOIN)
 	unique_ptr<bool[]> right_found_match;
 	//! The position in the RHS in the final scan of the FULL OUTER JOIN
+	idx_t right_outer_run;
 	idx_t right_outer_position;
+	unique_ptr<SortedRunScanner> right_outer_scanner;
 };
 
 unique_ptr<GlobalOperatorState> PhysicalPiecewiseMergeJoin::GetGlobalState(ClientContext &context) {
-	return make_unique<MergeJoinGlobalState>();
+	return make_unique<MergeJoinGlobalState>(BufferManager::GetBufferManager(context));
 }
 
 unique_ptr<LocalSinkState> PhysicalPiecewiseMergeJoin::GetLocalSinkState(ExecutionContext &context) {
-	return make_unique<MergeJoinLocalState>(conditions);
+	return make_unique<MergeJoinLocalState>(*this);
+}
+
+//! Sorts the thread-local data on the join key into a run, NULL keys are sorted last
+static void SortLocalData(MergeJoinGlobalState &gstate, MergeJoinLocalState &lstate) {
+	auto &unsorted = lstate.unsorted;
+	if (unsorted.Count() == 0) {
+		return;
+	}
+	auto sorted_vector = unique_ptr<idx_t[]>(new idx_t[unsorted.Count()]);
+	vector<OrderType> order_types {OrderType::ASCENDING};
+	vector<OrderByNullType> null_orders {OrderByNullType::NULLS_LAST};
+	unsorted.Sort(order_types, null_orders, sorted_vector.get());
+
+	MergeJoinRun run;
+	run.run = make_unique<SortedRun>(gstate.buffer_manager, unsorted.Types());
+	DataChunk sorted_chunk;
+	sorted_chunk.Initialize(unsorted.Types());
+	bool has_null = false;
+	for (idx_t position = 0; position < unsorted.Count(); position += STANDARD_VECTOR_SIZE) {
+		sorted_chunk.Reset();
+		unsorted.MaterializeSortedChunk(sorted_chunk, sorted_vector.get(), position);
+		run.run->Append(sorted_chunk);
+		// the smallest key is the first row, the largest key the last row that is not NULL
+		auto &keys = sorted_chunk.data[0];
+		idx_t not_null_count = sorted_chunk.size();
+		while (not_null_count > 0 && FlatVector::IsNull(keys, not_null_count - 1)) {
+			not_null_count--;
+		}
+		has_null = has_null || not_null_count < sorted_chunk.size();
+		if (not_null_count > 0) {
+			run.chunk_min.push_back(keys.GetValue(0));
+			run.chunk_max.push_back(keys.GetValue(not_null_count - 1));
+		}
+	}
+	run.run->Finalize();
+	unsorted.Reset();
+
+	lock_guard<mutex> glock(gstate.lock);
+	if (!run.chunk_min.empty()) {
+		auto &min = run.chunk_min[0];
+		auto &max = run.chunk_max.back();
+		if (gstate.min.is_null || min < gstate.min) {
+			gstate.min = min;
+		}
+		if (gstate.max.is_null || max > gstate.max) {
+			gstate.max = max;
+		}
+	}
+	gstate.has_null = gstate.has_null || has_null;
+	gstate.count += run.run->count;
+	gstate.runs.push_back(move(run));
 }
 
 void PhysicalPiecewiseMergeJoin::Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate,
@@ -84,70 +168,200 @@ void PhysicalPiecewiseMergeJoin::Sink(ExecutionContext &context, GlobalOperatorS
 		// resolve the join key
 		mj_state.rhs_executor.ExecuteExpression(k, mj_state.join_keys.data[k]);
 	}
-	// append the join keys and the chunk to the chunk collection
-	gstate.right_chunks.Append(input);
-	gstate.right_conditions.Append(mj_state.join_keys);
+	// append the join keys and the chunk to the thread-local data
+	auto &run_chunk = mj_state.run_chunk;
+	idx_t key_count = mj_state.join_keys.ColumnCount();
+	for (idx_t k = 0; k < key_count; k++) {
+		run_chunk.data[k].Reference(mj_state.join_keys.data[k]);
+	}
+	for (idx_t col_idx = 0; col_idx < input.ColumnCount(); col_idx++) {
+		run_chunk.data[key_count + col_idx].Reference(input.data[col_idx]);
+	}
+	run_chunk.SetCardinality(input);
+	mj_state.unsorted.Append(run_chunk);
+
+	if (mj_state.unsorted.Count() >= SORTED_RUN_SIZE) {
+		SortLocalData(gstate, mj_state);
+	}
+}
+
+void PhysicalPiecewiseMergeJoin::Combine(ExecutionContext &context, GlobalOperatorState &gstate,
+                                         LocalSinkState &lstate) {
+	SortLocalData((MergeJoinGlobalState &)gstate, (MergeJoinLocalState &)lstate);
 }
 
 //===--------------------------------------------------------------------===//
 // Finalize
 //===--------------------------------------------------------------------===//
-static void OrderVector(Vector &vector, idx_t count, MergeOrder &order);
+static void OrderVector(Vector &input, idx_t count, MergeOrder &order);
 
 void PhysicalPiecewiseMergeJoin::Finalize(Pipeline &pipeline, ClientContext &context,
                                           unique_ptr<GlobalOperatorState> state) {
 	auto &gstate = (MergeJoinGlobalState &)*state;
-	if (gstate.right_conditions.ChunkCount() > 0) {
-		// now order all the chunks
-		gstate.right_orders.resize(gstate.right_conditions.ChunkCount());
-		for (idx_t i = 0; i < gstate.right_conditions.ChunkCount(); i++) {
-			auto &chunk_to_order = gstate.right_conditions.GetChunk(i);
-			D_ASSERT(chunk_to_order.ColumnCount() == 1);
-			for (idx_t col_idx = 0; col_idx < chunk_to_order.ColumnCount(); col_idx++) {
-				OrderVector(chunk_to_order.data[col_idx], chunk_to_order.size(), gstate.right_orders[i]);
-				if (gstate.right_orders[i].count < chunk_to_order.size()) {
-					// the amount of entries in the order vector is smaller than the amount of entries in the vector
-					// this only happens if there are NULL values in the right-hand side
-					// hence we set the has_null to true (this is required for the MARK join)
-					gstate.has_null = true;
-				}
-			}
-		}
+	idx_t offset = 0;
+	for (auto &run : gstate.runs) {
+		run.offset = offset;
+		offset += run.run->count;
+	}
+	if (!gstate.min.is_null) {
+		// order the bounds of the RHS
+		DataChunk bounds;
+		bounds.Initialize(join_key_types);
+		bounds.SetValue(0, 0, gstate.min);
+		bounds.SetValue(0, 1, gstate.max);
+		bounds.SetCardinality(2);
+		gstate.right_bounds.Append(bounds);
+		gstate.right_bounds_order.resize(1);
+		OrderVector(gstate.right_bounds.GetChunk(0).data[0], 2, gstate.right_bounds_order[0]);
 	}
 	if (IsRightOuterJoin(join_type)) {
 		// for FULL/RIGHT OUTER JOIN, initialize found_match to false for every tuple
-		gstate.right_found_match = unique_ptr<bool[]>(new bool[gstate.right_chunks.Count()]);
-		memset(gstate.right_found_match.get(), 0, sizeof(bool) * gstate.right_chunks.Count());
+		gstate.right_found_match = unique_ptr<bool[]>(new bool[gstate.count]);
+		memset(gstate.right_found_match.get(), 0, sizeof(bool) * gstate.count);
 	}
 	PhysicalSink::Finalize(pipeline, context, move(state));
 }
 
+bool PhysicalPiecewiseMergeJoin::ParallelProbe() {
+	// the RHS rows of right/full outer joins that found no match are output by a single thread at the end of the probe
+	return !IsRightOuterJoin(join_type);
+}
+
 //===--------------------------------------------------------------------===//
 // GetChunkInternal
 //===--------------------------------------------------------------------===//
 class PhysicalPiecewiseMergeJoinState : public PhysicalOperatorState {
 public:
-	PhysicalPiecewiseMergeJoinState(PhysicalOperator &op, PhysicalOperator *left, vector<JoinCondition> &conditions)
-	    : PhysicalOperatorState(op, left), fetch_next_left(true), left_position(0), right_position(0),
-	      right_chunk_index(0) {
+	PhysicalPiecewiseMergeJoinState(PhysicalPiecewiseMergeJoin &op, PhysicalOperator *left)
+	    : PhysicalOperatorState(op, left), fetch_next_left(true), left_position(0), right_position(0), run_idx(0),
+	      run_chunk_idx(0), run_chunk_end(0), right_base(0) {
 		vector<LogicalType> condition_types;
-		for (auto &cond : conditions) {
+		for (auto &cond : op.conditions) {
 			lhs_executor.AddExpression(*cond.left);
 			condition_types.push_back(cond.left->return_type);
 		}
 		join_keys.Initialize(condition_types);
+		vector<LogicalType> run_types = condition_types;
+		run_types.insert(run_types.end(), op.children[1]->types.begin(), op.children[1]->types.end());
+		right_chunk.Initialize(run_types);
+		right_payload.InitializeEmpty(op.children[1]->types);
+		// the chunks of a run are sorted with the NULL keys last: the order of the non-NULL keys is the identity
+		right_orders.order.Initialize(STANDARD_VECTOR_SIZE);
+		for (idx_t i = 0; i < STANDARD_VECTOR_SIZE; i++) {
+			right_orders.order.set_index(i, i);
+		}
 	}
 
 	bool fetch_next_left;
 	idx_t left_position;
 	idx_t right_position;
-	idx_t right_chunk_index;
 	DataChunk left_chunk;
 	DataChunk join_keys;
 	MergeOrder left_orders;
 	//! The executor of the RHS condition
 	ExpressionExecutor lhs_executor;
 	unique_ptr<bool[]> left_found_match;
+	//! The run of the current RHS chunk
+	idx_t run_idx;
+	unique_ptr<SortedRunScanner> scanner;
+	//! The next chunk of the run to scan, and the end of the chunks of the run that can match the LHS chunk
+	idx_t run_chunk_idx;
+	idx_t run_chunk_end;
+	//! The current RHS chunk: the join key followed by the RHS data
+	DataChunk right_chunk;
+	//! The RHS data of the current RHS chunk
+	DataChunk right_payload;
+	MergeOrder right_orders;
+	//! The index of the first row of the current RHS chunk in the right_found_match
+	idx_t right_base;
+
+public:
+	//! Moves to the next RHS chunk that can contain matches for the current LHS chunk, returns false if all RHS chunks
+	//! have been joined with it
+	bool NextRightChunk(PhysicalPiecewiseMergeJoin &op, MergeJoinGlobalState &gstate) {
+		if (left_orders.count == 0) {
+			return false;
+		}
+		while (run_idx < gstate.runs.size()) {
+			auto &run = gstate.runs[run_idx];
+			if (!scanner) {
+				// the keys of a run are sorted: the chunks that can match the LHS chunk are a consecutive range
+				FindChunkRange(op, run);
+				if (run_chunk_idx >= run_chunk_end) {
+					run_idx++;
+					continue;
+				}
+				scanner = make_unique<SortedRunScanner>(*run.run);
+				scanner->Seek(run_chunk_idx);
+			}
+			if (run_chunk_idx >= run_chunk_end) {
+				// exhausted this run: move to the next one
+				scanner.reset();
+				run_idx++;
+				continue;
+			}
+			scanner->Scan(right_chunk);
+			D_ASSERT(right_chunk.size() > 0);
+			// all chunks but the last chunk of a run are full
+			right_base = run.offset + run_chunk_idx * STANDARD_VECTOR_SIZE;
+			run_chunk_idx++;
+
+			auto &nullmask = FlatVector::Nullmask(right_chunk.data[0]);
+			idx_t not_null_count = right_chunk.size();
+			while (not_null_count > 0 && nullmask[not_null_count - 1]) {
+				not_null_count--;
+			}
+			right_chunk.data[0].Orrify(right_chunk.size(), right_orders.vdata);
+			right_orders.count = not_null_count;
+			for (idx_t col_idx = 0; col_idx < right_payload.ColumnCount(); col_idx++) {
+				right_payload.data[col_idx].Reference(right_chunk.data[1 + col_idx]);
+			}
+			right_payload.SetCardinality(right_chunk);
+			left_position = 0;
+			right_position = 0;
+			return true;
+		}
+		return false;
+	}
+
+private:
+	//! Returns the index of the first bound that is bigger than (or equal to, if inclusive) the key
+	static idx_t FindFirstBound(vector<Value> &bounds, const Value &key, bool inclusive) {
+		idx_t lower = 0;
+		idx_t upper = bounds.size();
+		while (lower < upper) {
+			idx_t middle = (lower + upper) / 2;
+			if (inclusive ? bounds[middle] >= key : bounds[middle] > key) {
+				upper = middle;
+			} else {
+				lower = middle + 1;
+			}
+		}
+		return lower;
+	}
+
+	void FindChunkRange(PhysicalPiecewiseMergeJoin &op, MergeJoinRun &run) {
+		auto &left_keys = join_keys.data[0];
+		auto left_min = left_keys.GetValue(left_orders.order.get_index(0));
+		auto left_max = left_keys.GetValue(left_orders.order.get_index(left_orders.count - 1));
+		run_chunk_idx = 0;
+		run_chunk_end = run.chunk_min.size();
+		switch (op.conditions[0].comparison) {
+		case ExpressionType::COMPARE_LESSTHAN:
+			run_chunk_idx = FindFirstBound(run.chunk_max, left_min, false);
+			break;
+		case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+			run_chunk_idx = FindFirstBound(run.chunk_max, left_min, true);
+			break;
+		case ExpressionType::COMPARE_GREATERTHAN:
+			run_chunk_end = FindFirstBound(run.chunk_min, left_max, true);
+			break;
+		default:
+			D_ASSERT(op.conditions[0].comparison == ExpressionType::COMPARE_GREATERTHANOREQUALTO);
+			run_chunk_end = FindFirstBound(run.chunk_min, left_max, false);
+			break;
+		}
+	}
 };
 
 void PhysicalPiecewiseMergeJoin::ResolveSimpleJoin(ExecutionContext &context, DataChunk &chunk,
@@ -168,10 +382,12 @@ void PhysicalPiecewiseMergeJoin::ResolveSimpleJoin(ExecutionContext &context, Da
 			OrderVector(state->join_keys.data[k], state->join_keys.size(), state->left_orders);
 		}
 		ScalarMergeInfo left_info(state->left_orders, state->join_keys.data[0].type, state->left_position);
-		ChunkMergeInfo right_info(gstate.right_conditions, gstate.right_orders);
+		ChunkMergeInfo right_info(gstate.right_bounds, gstate.right_bounds_order);
 
-		// perform the actual join
-		MergeJoinSimple::Perform(left_info, right_info, conditions[0].comparison);
+		// perform the actual join against the smallest and largest key of the RHS
+		if (state->left_orders.count > 0 && gstate.right_bounds.Count() > 0) {
+			MergeJoinSimple::Perform(left_info, right_info, conditions[0].comparison);
+		}
 
 		// now construct the result based ont he join result
 		switch (join_type) {
@@ -191,6 +407,46 @@ void PhysicalPiecewiseMergeJoin::ResolveSimpleJoin(ExecutionContext &context, Da
 	} while (chunk.size() == 0);
 }
 
+//! Outputs the RHS rows of a right/full outer join that did not find a match
+static void ScanRightOuter(MergeJoinGlobalState &gstate, DataChunk &scan_chunk, DataChunk &result) {
+	SelectionVector rsel(STANDARD_VECTOR_SIZE);
+	while (gstate.right_outer_run < gstate.runs.size()) {
+		if (!gstate.right_outer_scanner) {
+			auto &run = gstate.runs[gstate.right_outer_run];
+			gstate.right_outer_scanner = make_unique<SortedRunScanner>(*run.run);
+			gstate.right_outer_position = run.offset;
+		}
+		gstate.right_outer_scanner->Scan(scan_chunk);
+		if (scan_chunk.size() == 0) {
+			gstate.right_outer_scanner.reset();
+			gstate.right_outer_run++;
+			continue;
+		}
+		// figure out which tuples didn't find a match
+		idx_t result_count = 0;
+		for (idx_t i = 0; i < scan_chunk.size(); i++) {
+			if (!gstate.right_found_match[gstate.right_outer_position + i]) {
+				rsel.set_index(result_count++, i);
+			}
+		}
+		gstate.right_outer_position += scan_chunk.size();
+		if (result_count > 0) {
+			// fill in NULL values for the LHS, and output the RHS data (i.e. without the join key)
+			idx_t right_column_count = scan_chunk.ColumnCount() - 1;
+			idx_t left_column_count = result.ColumnCount() - right_column_count;
+			for (idx_t i = 0; i < left_column_count; i++) {
+				result.data[i].vector_type = VectorType::CONSTANT_VECTOR;
+				ConstantVector::SetNull(result.data[i], true);
+			}
+			for (idx_t col_idx = 0; col_idx < right_column_count; col_idx++) {
+				result.data[left_column_count + col_idx].Slice(scan_chunk.data[1 + col_idx], rsel, result_count);
+			}
+			result.SetCardinality(result_count);
+			return;
+		}
+	}
+}
+
 void PhysicalPiecewiseMergeJoin::ResolveComplexJoin(ExecutionContext &context, DataChunk &chunk,
                                                     PhysicalOperatorState *state_) {
 	auto state = reinterpret_cast<PhysicalPiecewiseMergeJoinState *>(state_);
@@ -218,8 +474,7 @@ void PhysicalPiecewiseMergeJoin::ResolveComplexJoin(ExecutionContext &context, D
 				if (IsRightOuterJoin(join_type)) {
 					// if the LHS is exhausted in a FULL OUTER JOIN, we scan the found_match for any chunks we still
 					// need to output
-					ConstructFullOuterJoinResult(gstate.right_found_match.get(), gstate.right_chunks, chunk,
-					                             gstate.right_outer_position);
+					ScanRightOuter(gstate, state->right_chunk, chunk);
 				}
 				return;
 			}
@@ -234,27 +489,23 @@ void PhysicalPiecewiseMergeJoin::ResolveComplexJoin(ExecutionContext &context, D
 				OrderVector(state->join_keys.data[k], state->join_keys.size(), state->left_orders);
 			}
 
-			state->right_chunk_index = 0;
-			state->left_position = 0;
-			state->right_position = 0;
+			state->run_idx = 0;
+			state->scanner.reset();
+			if (!state->NextRightChunk(*this, gstate)) {
+				// no RHS chunk can contain a match for this chunk
+				continue;
+			}
 			state->fetch_next_left = false;
 		}
 
-		auto &right_chunk = gstate.right_chunks.GetChunk(state->right_chunk_index);
-		auto &right_condition_chunk = gstate.right_conditions.GetChunk(state->right_chunk_index);
-		auto &right_orders = gstate.right_orders[state->right_chunk_index];
-
 		ScalarMergeInfo left_info(state->left_orders, state->join_keys.data[0].type, state->left_position);
-		ScalarMergeInfo right_info(right_orders, right_condition_chunk.data[0].type, state->right_position);
+		ScalarMergeInfo right_info(state->right_orders, state->right_chunk.data[0].type, state->right_position);
 
 		idx_t result_count = MergeJoinComplex::Perform(left_info, right_info, conditions[0].comparison);
 		if (result_count == 0) {
 			// exhausted this chunk on the right side
 			// move to the next right chunk
-			state->left_position = 0;
-			state->right_position = 0;
-			state->right_chunk_index++;
-			if (state->right_chunk_index >= gstate.right_chunks.ChunkCount()) {
+			if (!state->NextRightChunk(*this, gstate)) {
 				state->fetch_next_left = true;
 			}
 		} else {
@@ -265,14 +516,13 @@ void PhysicalPiecewiseMergeJoin::ResolveComplexJoin(ExecutionContext &context, D
 				}
 			}
 			if (gstate.right_found_match) {
-				idx_t base_index = state->right_chunk_index * STANDARD_VECTOR_SIZE;
 				for (idx_t i = 0; i < result_count; i++) {
-					gstate.right_found_match[base_index + right_info.result.get_index(i)] = true;
+					gstate.right_found_match[state->right_base + right_info.result.get_index(i)] = true;
 				}
 			}
 			// found matches: output them
 			chunk.Slice(state->child_chunk, left_info.result, result_count);
-			chunk.Slice(right_chunk, right_info.result, result_count, state->child_chunk.ColumnCount());
+			chunk.Slice(state->right_payload, right_info.result, result_count, state->child_chunk.ColumnCount());
 		}
 	} while (chunk.size() == 0);
 }
@@ -282,7 +532,7 @@ void PhysicalPiecewiseMergeJoin::GetChunkInternal(ExecutionContext &context, Dat
 	auto state = reinterpret_cast<PhysicalPiecewiseMergeJoinState *>(state_);
 	auto &gstate = (MergeJoinGlobalState &)*sink_state;
 
-	if (gstate.right_chunks.Count() == 0) {
+	if (gstate.count == 0) {
 		// empty RHS: construct empty result
 		if (join_type == JoinType::SEMI || join_type == JoinType::INNER) {
 			return;
@@ -315,142 +565,64 @@ void PhysicalPiecewiseMergeJoin::GetChunkInternal(ExecutionContext &context, Dat
 }
 
 unique_ptr<PhysicalOperatorState> PhysicalPiecewiseMergeJoin::GetOperatorState() {
-	return make_unique<PhysicalPiecewiseMergeJoinState>(*this, children[0].get(), conditions);
+	return make_unique<PhysicalPiecewiseMergeJoinState>(*this, children[0].get());
 }
 
 //===--------------------------------------------------------------------===//
 // OrderVector
 //===--------------------------------------------------------------------===//
-template <class T, class OP>
-static sel_t templated_quicksort_initial(T *data, const SelectionVector &sel, const SelectionVector &not_null_sel,
-                                         idx_t count, SelectionVector &result) {
-	// select pivot
-	auto pivot_idx = not_null_sel.get_index(0);
-	auto dpivot_idx = sel.get_index(pivot_idx);
-	sel_t low = 0, high = count - 1;
-	// now insert elements
-	for (idx_t i = 1; i < count; i++) {
-		auto idx = not_null_sel.get_index(i);
-		auto didx = sel.get_index(idx);
-		if (OP::Operation(data[didx], data[dpivot_idx])) {
-			result.set_index(low++, idx);
-		} else {
-			result.set_index(high--, idx);
-		}
-	}
-	D_ASSERT(low == high);
-	result.set_index(low, pivot_idx);
-	return low;
-}
-
-template <class T, class OP>
-static void templated_quicksort_inplace(T *data, const SelectionVector &sel, idx_t count, SelectionVector &result,
-                                        sel_t left, sel_t right) {
-	if (left >= right) {
-		return;
-	}
-
-	sel_t middle = left + (right - left) / 2;
-	sel_t dpivot_idx = sel.get_index(result.get_index(middle));
-
-	// move the mid point value to the front.
-	sel_t i = left + 1;
-	sel_t j = right;
-
-	result.swap(middle, left);
-	while (i <= j) {
-		while (i <= j && (OP::Operation(data[sel.get_index(result.get_index(i))], data[dpivot_idx]))) {
-			i++;
-		}
-
-		while (i <= j && !OP::Operation(data[sel.get_index(result.get_index(j))], data[dpivot_idx])) {
-			j--;
-		}
-
-		if (i < j) {
-			result.swap(i, j);
-		}
-	}
-	result.swap(i - 1, left);
-	sel_t part = i - 1;
-
-	if (part > 0) {
-		templated_quicksort_inplace<T, OP>(data, sel, count, result, left, part - 1);
-	}
-	templated_quicksort_inplace<T, OP>(data, sel, count, result, part + 1, right);
-}
-
-template <class T, class OP>
-void templated_quicksort(T *__restrict data, const SelectionVector &sel, const SelectionVector &not_null_sel,
-                         idx_t count, SelectionVector &result) {
-	auto part = templated_quicksort_initial<T, OP>(data, sel, not_null_sel, count, result);
-	if (part > count) {
-		return;
-	}
-	templated_quicksort_inplace<T, OP>(data, sel, count, result, 0, part);
-	templated_quicksort_inplace<T, OP>(data, sel, count, result, part + 1, count - 1);
-}
-
-template <class T>
-static void templated_quicksort(VectorData &vdata, const SelectionVector &not_null_sel, idx_t not_null_count,
-                                SelectionVector &result) {
-	if (not_null_count == 0) {
-		return;
-	}
-	templated_quicksort<T, duckdb::LessThanEquals>((T *)vdata.data, *vdata.sel, not_null_sel, not_null_count, result);
-}
-
-void OrderVector(Vector &vector, idx_t count, MergeOrder &order) {
+void OrderVector(Vector &input, idx_t count, MergeOrder &order) {
 	if (count == 0) {
 		order.count = 0;
 		return;
 	}
-	vector.Orrify(count, order.vdata);
+	input.Orrify(count, order.vdata);
 	auto &vdata = order.vdata;
 
 	// first filter out all the non-null values
-	SelectionVector not_null(STANDARD_VECTOR_SIZE);
+	order.order.Initialize(STANDARD_VECTOR_SIZE);
 	idx_t not_null_count = 0;
 	for (idx_t i = 0; i < count; i++) {
 		auto idx = vdata.sel->get_index(i);
 		if (!(*vdata.nullmask)[idx]) {
-			not_null.set_index(not_null_count++, i);
+			order.order.set_index(not_null_count++, i);
 		}
 	}
-
 	order.count = not_null_count;
-	order.order.Initialize(STANDARD_VECTOR_SIZE);
-	switch (vector.type.InternalType()) {
-	case PhysicalType::BOOL:
-	case PhysicalType::INT8:
-		templated_quicksort<int8_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::INT16:
-		templated_quicksort<int16_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::INT32:
-		templated_quicksort<int32_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::INT64:
-		templated_quicksort<int64_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::INT128:
-		templated_quicksort<hugeint_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::FLOAT:
-		templated_quicksort<float>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::DOUBLE:
-		templated_quicksort<double>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::INTERVAL:
-		templated_quicksort<interval_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	case PhysicalType::VARCHAR:
-		templated_quicksort<string_t>(vdata, not_null, not_null_count, order.order);
-		break;
-	default:
-		throw NotImplementedException("Unimplemented type for sort");
+	if (not_null_count == 0) {
+		return;
+	}
+
+	// encode the values into memcmp-comparable keys
+	SortKeyEncoder encoder({input.type}, {OrderType::ASCENDING}, {OrderByNullType::NULLS_LAST});
+	auto key_width = encoder.key_width;
+	auto keys = unique_ptr<data_t[]>(new data_t[count * key_width]);
+	auto key_data = keys.get();
+	encoder.EncodeColumn(input, count, 0, key_data, key_width);
+
+	// now sort the non-null entries by their keys
+	auto sel_data = order.order.data();
+	if (!encoder.HasTieBreaker()) {
+		idx_t sorted[STANDARD_VECTOR_SIZE];
+		for (idx_t i = 0; i < not_null_count; i++) {
+			sorted[i] = sel_data[i];
+		}
+		encoder.SortKeys(key_data, sorted, not_null_count);
+		for (idx_t i = 0; i < not_null_count; i++) {
+			sel_data[i] = sorted[i];
+		}
+	} else {
+		vector<LogicalType> types {input.type};
+		DataChunk chunk;
+		chunk.InitializeEmpty(types);
+		chunk.data[0].Reference(input);
+		chunk.SetCardinality(count);
+		vector<VectorData> chunk_data;
+		encoder.OrrifyTieColumns(chunk, chunk_data);
+		std::sort(sel_data, sel_data + not_null_count, [&](const sel_t &left, const sel_t &right) {
+			return encoder.Compare(key_data + left * key_width, key_data + right * key_width, chunk_data, left,
+			                       chunk_data, right) < 0;
+		});
 	}
 }
 
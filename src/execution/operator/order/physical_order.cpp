@@ -3,7 +3,13 @@
 #include "duckdb/common/assert.hpp"
 #include "duckdb/common/value_operations/value_operations.hpp"
 #include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/executor.hpp"
 #include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/sorted_run.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/parallel/pipeline.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
 #include "duckdb/storage/data_table.hpp"
 
 namespace duckdb {
@@ -11,10 +17,15 @@ namespace duckdb {
 class PhysicalOrderOperatorState : public PhysicalOperatorState {
 public:
 	PhysicalOrderOperatorState(PhysicalOperator &op, PhysicalOperator *child)
-	    : PhysicalOperatorState(op, child), position(0) {
+	    : PhysicalOperatorState(op, child), run_idx(0) {
 	}
 
-	idx_t position;
+	//! The index of the final sorted run that is scanned
+	idx_t run_idx;
+	//! The scanner over the current final sorted run
+	unique_ptr<SortedRunScanner> scanner;
+	//! The chunk holding the sort keys and payload of the sorted run
+	DataChunk scan_chunk;
 };
 
 //===--------------------------------------------------------------------===//
@@ -22,63 +33,337 @@ public:
 //===--------------------------------------------------------------------===//
 class OrderByGlobalOperatorState : public GlobalOperatorState {
 public:
-	//! The lock for updating the global aggregate state
+	OrderByGlobalOperatorState(BufferManager &buffer_manager)
+	    : buffer_manager(buffer_manager), active_tasks(0), final_merge(false) {
+	}
+
+	BufferManager &buffer_manager;
+	//! The lock for updating the global state
 	mutex lock;
-	//! The sorted data
-	ChunkCollection sorted_data;
-	//! The sorted vector
-	unique_ptr<idx_t[]> sorted_vector;
+	//! The sort order of the runs
+	SortDescription desc;
+	//! The sorted runs that are produced by the threads. After finalizing this holds the final runs, which together
+	//! form the sorted result when they are scanned in order.
+	vector<unique_ptr<SortedRun>> runs;
+	//! The runs that are produced by the current merge round
+	vector<unique_ptr<SortedRun>> merged_runs;
+	//! The amount of merge tasks of the current round that are still running
+	idx_t active_tasks;
+	//! Whether or not the current merge round is the final one. The final round merges disjoint key ranges of the
+	//! remaining runs in parallel, each range into a final run.
+	bool final_merge;
+	//! The input runs of the final merge round
+	vector<unique_ptr<SortedRun>> final_merge_runs;
+};
+
+class OrderByLocalSinkState : public LocalSinkState {
+public:
+	OrderByLocalSinkState(PhysicalOrder &op) {
+		vector<LogicalType> key_types;
+		for (auto &order : op.orders) {
+			key_types.push_back(order.expression->return_type);
+			executor.AddExpression(*order.expression);
+		}
+		key_chunk.Initialize(key_types);
+		run_types = key_types;
+		for (auto &type : op.types) {
+			run_types.push_back(type);
+		}
+		run_chunk.InitializeEmpty(run_types);
+	}
+
+	//! Executor for the sort keys
+	ExpressionExecutor executor;
+	//! The computed sort keys
+	DataChunk key_chunk;
+	//! The types of the sorted runs: the sort keys followed by the payload
+	vector<LogicalType> run_types;
+	//! The chunk combining the sort keys and the payload
+	DataChunk run_chunk;
+	//! The data that has not been sorted into a run yet
+	ChunkCollection unsorted;
 };
 
 unique_ptr<GlobalOperatorState> PhysicalOrder::GetGlobalState(ClientContext &context) {
-	return make_unique<OrderByGlobalOperatorState>();
+	auto state = make_unique<OrderByGlobalOperatorState>(BufferManager::GetBufferManager(context));
+	for (auto &order : orders) {
+		state->desc.order_types.push_back(order.type);
+		state->desc.null_orders.push_back(order.null_order);
+	}
+	return move(state);
 }
 
-void PhysicalOrder::Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate,
+unique_ptr<LocalSinkState> PhysicalOrder::GetLocalSinkState(ExecutionContext &context) {
+	return make_unique<OrderByLocalSinkState>(*this);
+}
+
+static void SortLocalData(OrderByGlobalOperatorState &gstate, OrderByLocalSinkState &lstate) {
+	if (lstate.unsorted.Count() == 0) {
+		return;
+	}
+	// sort the thread-local data into a run, the run is written to buffer-managed blocks that can be offloaded
+	auto run = SortedRun::CreateFromCollection(gstate.buffer_manager, lstate.unsorted, gstate.desc);
+	lstate.unsorted.Reset();
+
+	lock_guard<mutex> glock(gstate.lock);
+	gstate.runs.push_back(move(run));
+}
+
+void PhysicalOrder::Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate_p,
                          DataChunk &input) {
-	// concatenate all the data of the child chunks
 	auto &gstate = (OrderByGlobalOperatorState &)state;
-	lock_guard<mutex> glock(gstate.lock);
-	gstate.sorted_data.Append(input);
+	auto &lstate = (OrderByLocalSinkState &)lstate_p;
+
+	// compute the sort keys and append them together with the payload to the thread-local data
+	lstate.key_chunk.Reset();
+	lstate.executor.Execute(input, lstate.key_chunk);
+	idx_t key_count = lstate.key_chunk.ColumnCount();
+	for (idx_t i = 0; i < key_count; i++) {
+		lstate.run_chunk.data[i].Reference(lstate.key_chunk.data[i]);
+	}
+	for (idx_t i = 0; i < input.ColumnCount(); i++) {
+		lstate.run_chunk.data[key_count + i].Reference(input.data[i]);
+	}
+	lstate.run_chunk.SetCardinality(input);
+	lstate.unsorted.Append(lstate.run_chunk);
+
+	if (lstate.unsorted.Count() >= SORTED_RUN_SIZE) {
+		SortLocalData(gstate, lstate);
+	}
+}
+
+void PhysicalOrder::Combine(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate) {
+	SortLocalData((OrderByGlobalOperatorState &)state, (OrderByLocalSinkState &)lstate);
 }
 
 //===--------------------------------------------------------------------===//
 // Finalize
 //===--------------------------------------------------------------------===//
-void PhysicalOrder::Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> state) {
-	// finalize: perform the actual sorting
-	auto &sink = (OrderByGlobalOperatorState &)*state;
-	ChunkCollection &big_data = sink.sorted_data;
+static void ScheduleMergeTasks(Pipeline &pipeline, ClientContext &context, OrderByGlobalOperatorState &state);
 
-	// compute the sorting columns from the input data
-	ExpressionExecutor executor;
-	vector<LogicalType> sort_types;
-	vector<OrderType> order_types;
-	vector<OrderByNullType> null_order_types;
-	for (idx_t i = 0; i < orders.size(); i++) {
-		auto &expr = orders[i].expression;
-		sort_types.push_back(expr->return_type);
-		order_types.push_back(orders[i].type);
-		null_order_types.push_back(orders[i].null_order);
-		executor.AddExpression(*expr);
+//! Stores the run produced by a merge task. The last task of a merge round schedules the next round, and the pipeline
+//! is finished when the last task of the final round completes.
+static void FinishMergeTask(Pipeline &parent, ClientContext &context, OrderByGlobalOperatorState &state,
+                            unique_ptr<SortedRun> merged, idx_t partition_idx) {
+	lock_guard<mutex> glock(state.lock);
+	if (merged) {
+		if (state.final_merge) {
+			state.merged_runs[partition_idx] = move(merged);
+		} else {
+			state.merged_runs.push_back(move(merged));
+		}
+	}
+	D_ASSERT(state.active_tasks > 0);
+	state.active_tasks--;
+	if (state.active_tasks == 0) {
+		// this was the last task of the merge round
+		state.runs = move(state.merged_runs);
+		state.merged_runs.clear();
+		state.final_merge_runs.clear();
+		if (state.runs.size() > 1 && !state.final_merge && !context.interrupted) {
+			ScheduleMergeTasks(parent, context, state);
+		}
+	}
+	parent.finished_tasks++;
+	// finish the whole pipeline
+	if (parent.total_tasks == parent.finished_tasks) {
+		parent.Finish();
+	}
+}
+
+class PhysicalOrderMergeTask : public Task {
+public:
+	PhysicalOrderMergeTask(Pipeline &parent_, ClientContext &context_, OrderByGlobalOperatorState &state_,
+	                       vector<unique_ptr<SortedRun>> runs_)
+	    : parent(parent_), context(context_), state(state_), runs(move(runs_)) {
+	}
+
+	void Execute() override {
+		unique_ptr<SortedRun> merged;
+		try {
+			merged = SortedRun::Merge(state.buffer_manager, move(runs), state.desc);
+		} catch (std::exception &ex) {
+			parent.executor.PushError(ex.what());
+		} catch (...) {
+			parent.executor.PushError("Unknown exception in ORDER BY merge!");
+		}
+		FinishMergeTask(parent, context, state, move(merged), 0);
 	}
 
-	ChunkCollection sort_collection;
-	for (idx_t i = 0; i < big_data.ChunkCount(); i++) {
-		DataChunk sort_chunk;
-		sort_chunk.Initialize(sort_types);
+private:
+	Pipeline &parent;
+	ClientContext &context;
+	OrderByGlobalOperatorState &state;
+	vector<unique_ptr<SortedRun>> runs;
+};
 
-		executor.Execute(big_data.GetChunk(i), sort_chunk);
-		sort_collection.Append(sort_chunk);
+//! Merges a key range of the input runs of the final merge round into a final run
+class PhysicalOrderRangeMergeTask : public Task {
+public:
+	PhysicalOrderRangeMergeTask(Pipeline &parent_, ClientContext &context_, OrderByGlobalOperatorState &state_,
+	                            idx_t partition_idx_, vector<SortedRunPosition> begins_,
+	                            vector<SortedRunPosition> ends_)
+	    : parent(parent_), context(context_), state(state_), partition_idx(partition_idx_), begins(move(begins_)),
+	      ends(move(ends_)) {
 	}
 
-	D_ASSERT(sort_collection.Count() == big_data.Count());
+	void Execute() override {
+		unique_ptr<SortedRun> merged;
+		try {
+			vector<SortedRun *> runs;
+			for (auto &run : state.final_merge_runs) {
+				runs.push_back(run.get());
+			}
+			merged = SortedRun::MergeRanges(state.buffer_manager, runs, begins, ends, state.desc);
+		} catch (std::exception &ex) {
+			parent.executor.PushError(ex.what());
+		} catch (...) {
+			parent.executor.PushError("Unknown exception in ORDER BY merge!");
+		}
+		FinishMergeTask(parent, context, state, move(merged), partition_idx);
+	}
 
-	// now perform the actual sort
-	sink.sorted_vector = unique_ptr<idx_t[]>(new idx_t[sort_collection.Count()]);
-	sort_collection.Sort(order_types, null_order_types, sink.sorted_vector.get());
+private:
+	Pipeline &parent;
+	ClientContext &context;
+	OrderByGlobalOperatorState &state;
+	idx_t partition_idx;
+	vector<SortedRunPosition> begins;
+	vector<SortedRunPosition> ends;
+};
+
+//! Copies row row_idx of the given chunk to the end of the target chunk
+static void AppendRow(DataChunk &source, idx_t row_idx, DataChunk &target) {
+	for (idx_t col_idx = 0; col_idx < source.ColumnCount(); col_idx++) {
+		VectorOperations::Copy(source.data[col_idx], target.data[col_idx], row_idx + 1, row_idx, target.size());
+	}
+	target.SetCardinality(target.size() + 1);
+}
+
+//! Picks partition_count - 1 splitters, in sort order, that divide the rows of the runs into ranges of similar size.
+//! The splitters are quantiles of a sample of evenly spaced rows of every run.
+static void PickSplitters(OrderByGlobalOperatorState &state, idx_t total_count, idx_t partition_count,
+                          DataChunk &splitters) {
+	auto &types = state.runs[0]->types;
+	ChunkCollection samples;
+	DataChunk sample_chunk;
+	sample_chunk.Initialize(types);
+	DataChunk chunk;
+	chunk.Initialize(types);
+	for (auto &run : state.runs) {
+		auto chunk_count = run->ChunkCount();
+		if (chunk_count == 0) {
+			continue;
+		}
+		// sample the first row of evenly spaced chunks, weighted by the size of the run
+		idx_t sample_count = partition_count * PhysicalOrder::FINAL_MERGE_SAMPLES * run->count / total_count;
+		sample_count = MinValue<idx_t>(MaxValue<idx_t>(sample_count, 1), chunk_count);
+		SortedRunScanner scanner(*run);
+		for (idx_t sample_idx = 0; sample_idx < sample_count; sample_idx++) {
+			scanner.Seek(sample_idx * chunk_count / sample_count);
+			scanner.Scan(chunk);
+			if (sample_chunk.size() == STANDARD_VECTOR_SIZE) {
+				samples.Append(sample_chunk);
+				sample_chunk.Reset();
+			}
+			AppendRow(chunk, 0, sample_chunk);
+		}
+	}
+	samples.Append(sample_chunk);
+
+	// sort the samples, and take the quantiles as splitters
+	auto sorted_samples = unique_ptr<idx_t[]>(new idx_t[samples.Count()]);
+	samples.Sort(state.desc.order_types, state.desc.null_orders, sorted_samples.get());
+	for (idx_t partition_idx = 1; partition_idx < partition_count; partition_idx++) {
+		auto sample_idx = sorted_samples[partition_idx * samples.Count() / partition_count];
+		auto &sample = samples.GetChunkForRow(sample_idx);
+		AppendRow(sample, sample_idx % STANDARD_VECTOR_SIZE, splitters);
+	}
+}
+
+//! Schedules the final merge round, which splits the key domain into ranges that are merged in parallel. Returns false
+//! if the runs are too small to be worth splitting, in which case the final merge is done by a single task.
+static bool ScheduleFinalMergeTasks(Pipeline &pipeline, ClientContext &context, OrderByGlobalOperatorState &state) {
+	idx_t total_count = 0;
+	for (auto &run : state.runs) {
+		total_count += run->count;
+	}
+	auto threads = (idx_t)TaskScheduler::GetScheduler(context).NumberOfThreads();
+	auto partition_count = MinValue<idx_t>(threads, total_count / PhysicalOrder::FINAL_MERGE_PARTITION_SIZE);
+	partition_count = MinValue<idx_t>(partition_count, STANDARD_VECTOR_SIZE);
+	if (partition_count < 2 || !SortedRun::CanSpill(state.runs[0]->types)) {
+		// runs that are kept in memory hold nested types, of which copying single rows copies their entire children
+		return false;
+	}
+	DataChunk splitters;
+	splitters.Initialize(state.runs[0]->types);
+	PickSplitters(state, total_count, partition_count, splitters);
+
+	// the splitters divide every run into partition_count ranges
+	vector<vector<SortedRunPosition>> bounds;
+	for (auto &run : state.runs) {
+		bounds.push_back(run->LowerBounds(splitters, state.desc));
+	}
+	state.final_merge = true;
+	state.final_merge_runs = move(state.runs);
+	state.runs.clear();
+	state.merged_runs.resize(partition_count);
 
+	state.active_tasks = partition_count;
+	pipeline.total_tasks += partition_count;
+	for (idx_t partition_idx = 0; partition_idx < partition_count; partition_idx++) {
+		vector<SortedRunPosition> begins;
+		vector<SortedRunPosition> ends;
+		for (idx_t run_idx = 0; run_idx < state.final_merge_runs.size(); run_idx++) {
+			auto &run = *state.final_merge_runs[run_idx];
+			begins.push_back(partition_idx == 0 ? SortedRunPosition {0, 0} : bounds[run_idx][partition_idx - 1]);
+			ends.push_back(partition_idx + 1 == partition_count ? SortedRunPosition {run.ChunkCount(), 0}
+			                                                    : bounds[run_idx][partition_idx]);
+		}
+		auto new_task = make_unique<PhysicalOrderRangeMergeTask>(pipeline, context, state, partition_idx, move(begins),
+		                                                         move(ends));
+		TaskScheduler::GetScheduler(context).ScheduleTask(pipeline.token, move(new_task));
+	}
+	return true;
+}
+
+//! Schedules a round of merge tasks, each task merges up to SORTED_RUN_MERGE_FAN_IN runs. If this is the last round,
+//! the runs are instead merged by key range in parallel. Must be called with the lock held (or from the
+//! single-threaded Finalize).
+static void ScheduleMergeTasks(Pipeline &pipeline, ClientContext &context, OrderByGlobalOperatorState &state) {
+	D_ASSERT(state.runs.size() > 1);
+	D_ASSERT(state.active_tasks == 0);
+	if (state.runs.size() <= PhysicalOrder::SORTED_RUN_MERGE_FAN_IN &&
+	    ScheduleFinalMergeTasks(pipeline, context, state)) {
+		return;
+	}
+	vector<vector<unique_ptr<SortedRun>>> task_runs;
+	for (idx_t i = 0; i < state.runs.size(); i += PhysicalOrder::SORTED_RUN_MERGE_FAN_IN) {
+		vector<unique_ptr<SortedRun>> runs;
+		idx_t end = MinValue<idx_t>(i + PhysicalOrder::SORTED_RUN_MERGE_FAN_IN, state.runs.size());
+		for (idx_t j = i; j < end; j++) {
+			runs.push_back(move(state.runs[j]));
+		}
+		task_runs.push_back(move(runs));
+	}
+	state.runs.clear();
+
+	state.active_tasks = task_runs.size();
+	pipeline.total_tasks += task_runs.size();
+	for (auto &runs : task_runs) {
+		auto new_task = make_unique<PhysicalOrderMergeTask>(pipeline, context, state, move(runs));
+		TaskScheduler::GetScheduler(context).ScheduleTask(pipeline.token, move(new_task));
+	}
+}
+
+void PhysicalOrder::Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> state) {
+	auto &sink = (OrderByGlobalOperatorState &)*state;
 	PhysicalSink::Finalize(pipeline, context, move(state));
+	if (sink.runs.size() > 1) {
+		// merge the sorted runs in parallel, the pipeline is finished when the final merge task completes
+		lock_guard<mutex> glock(sink.lock);
+		ScheduleMergeTasks(pipeline, context, sink);
+	}
 }
 
 //===--------------------------------------------------------------------===//
@@ -87,13 +372,31 @@ void PhysicalOrder::Finalize(Pipeline &pipeline, ClientContext &context, unique_
 void PhysicalOrder::GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
 	auto state = reinterpret_cast<PhysicalOrderOperatorState *>(state_);
 	auto &sink = (OrderByGlobalOperatorState &)*this->sink_state;
-	ChunkCollection &big_data = sink.sorted_data;
-	if (state->position >= big_data.Count()) {
+	// scan the final runs in order
+	while (state->run_idx < sink.runs.size()) {
+		auto &run = *sink.runs[state->run_idx];
+		if (!state->scanner) {
+			state->scanner = make_unique<SortedRunScanner>(run);
+			if (state->scan_chunk.ColumnCount() == 0) {
+				state->scan_chunk.Initialize(run.types);
+			}
+		}
+		state->scanner->Scan(state->scan_chunk);
+		if (state->scan_chunk.size() > 0) {
+			break;
+		}
+		state->scanner.reset();
+		state->run_idx++;
+	}
+	if (state->run_idx >= sink.runs.size()) {
 		return;
 	}
-
-	big_data.MaterializeSortedChunk(chunk, sink.sorted_vector.get(), state->position);
-	state->position += STANDARD_VECTOR_SIZE;
+	// strip the sort keys from the result
+	idx_t key_count = orders.size();
+	for (idx_t i = 0; i < chunk.ColumnCount(); i++) {
+		chunk.data[i].Reference(state->scan_chunk.data[key_count + i]);
+	}
+	chunk.SetCardinality(state->scan_chunk);
 }
 
 unique_ptr<PhysicalOperatorState> PhysicalOrder::GetOperatorState() {
@@ -1,12 +1,15 @@
 #include "duckdb/execution/operator/order/physical_top_n.hpp"
 
 #include "duckdb/common/assert.hpp"
+#include "duckdb/common/types/sort_key.hpp"
 #include "duckdb/common/value_operations/value_operations.hpp"
 #include "duckdb/common/vector_operations/vector_operations.hpp"
 #include "duckdb/execution/expression_executor.hpp"
 #include "duckdb/storage/data_table.hpp"
 #include "duckdb/common/to_string.hpp"
 
+#include <atomic>
+
 namespace duckdb {
 
 //===--------------------------------------------------------------------===//
@@ -14,30 +17,150 @@ namespace duckdb {
 //===--------------------------------------------------------------------===//
 class TopNGlobalState : public GlobalOperatorState {
 public:
+	TopNGlobalState() : heap_size(0), boundary_version(0) {
+	}
+
 	mutex lock;
 	ChunkCollection big_data;
 	unique_ptr<idx_t[]> heap;
 	idx_t heap_size;
+	//! The encoded sort key of the last row of the smallest local top N, rows that sort after it can be skipped
+	vector<data_t> boundary;
+	//! Incremented whenever the boundary is tightened
+	std::atomic<idx_t> boundary_version;
 };
 
 class TopNLocalState : public LocalSinkState {
 public:
+	TopNLocalState(PhysicalTopN &op, SortKeyEncoder encoder_p) : encoder(move(encoder_p)), boundary_version(0) {
+		vector<LogicalType> sort_types;
+		for (auto &order : op.orders) {
+			sort_types.push_back(order.expression->return_type);
+			executor.AddExpression(*order.expression);
+		}
+		sort_chunk.Initialize(sort_types);
+		slice_chunk.InitializeEmpty(op.types);
+		keys = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * encoder.key_width]);
+	}
+
+	//! The rows that can still be part of the top N
 	ChunkCollection big_data;
+	//! Computes the sort columns of the input
+	ExpressionExecutor executor;
+	DataChunk sort_chunk;
+	//! The encoded sort keys of the current input chunk
+	SortKeyEncoder encoder;
+	unique_ptr<data_t[]> keys;
+	//! The local copy of the boundary
+	vector<data_t> boundary;
+	idx_t boundary_version;
+	//! The chunk holding the rows of the input that sort before the boundary
+	DataChunk slice_chunk;
 };
 
 unique_ptr<LocalSinkState> PhysicalTopN::GetLocalSinkState(ExecutionContext &context) {
-	return make_unique<TopNLocalState>();
+	return make_unique<TopNLocalState>(*this, CreateSortKeyEncoder());
 }
 
 unique_ptr<GlobalOperatorState> PhysicalTopN::GetGlobalState(ClientContext &context) {
 	return make_unique<TopNGlobalState>();
 }
 
+SortKeyEncoder PhysicalTopN::CreateSortKeyEncoder() {
+	vector<LogicalType> sort_types;
+	vector<OrderType> order_types;
+	vector<OrderByNullType> null_order_types;
+	for (auto &order : orders) {
+		sort_types.push_back(order.expression->return_type);
+		order_types.push_back(order.type);
+		null_order_types.push_back(order.null_order);
+	}
+	return SortKeyEncoder(move(sort_types), move(order_types), move(null_order_types));
+}
+
+//! Reduces the local data to its top N, and shares the key of the last row of the top N as boundary
+static void CompactLocalState(PhysicalTopN &op, TopNGlobalState &gstate, TopNLocalState &lstate) {
+	idx_t heap_size;
+	auto heap = op.ComputeTopN(lstate.big_data, heap_size);
+
+	ChunkCollection top_n;
+	DataChunk chunk;
+	chunk.Initialize(lstate.big_data.Types());
+	idx_t position = 0;
+	while (position < heap_size) {
+		position = lstate.big_data.MaterializeHeapChunk(chunk, heap.get(), position, heap_size);
+		top_n.Append(chunk);
+	}
+	lstate.big_data.Reset();
+	lstate.big_data.Append(top_n);
+	if (heap_size < op.limit + op.offset) {
+		return;
+	}
+
+	// the last row of the top N is the boundary: rows that sort after it are never part of the result
+	auto &encoder = lstate.encoder;
+	auto key_width = encoder.key_width;
+	auto &last_chunk = lstate.big_data.GetChunk(lstate.big_data.ChunkCount() - 1);
+	lstate.sort_chunk.Reset();
+	lstate.executor.Execute(last_chunk, lstate.sort_chunk);
+	encoder.Encode(lstate.sort_chunk, lstate.keys.get(), key_width);
+	auto last_key = lstate.keys.get() + (last_chunk.size() - 1) * key_width;
+
+	lock_guard<mutex> glock(gstate.lock);
+	if (gstate.boundary.empty() || memcmp(last_key, gstate.boundary.data(), key_width) < 0) {
+		gstate.boundary.assign(last_key, last_key + key_width);
+		gstate.boundary_version++;
+	}
+	lstate.boundary = gstate.boundary;
+	lstate.boundary_version = gstate.boundary_version;
+}
+
 void PhysicalTopN::Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate,
                         DataChunk &input) {
-	// append to the local sink state
+	auto &gstate = (TopNGlobalState &)state;
 	auto &sink = (TopNLocalState &)lstate;
-	sink.big_data.Append(input);
+	if (sink.boundary_version != gstate.boundary_version) {
+		// another thread tightened the boundary
+		lock_guard<mutex> glock(gstate.lock);
+		sink.boundary = gstate.boundary;
+		sink.boundary_version = gstate.boundary_version;
+	}
+	auto chunk = &input;
+	if (!sink.boundary.empty()) {
+		// skip the rows that sort after the boundary
+		auto &encoder = sink.encoder;
+		auto key_width = encoder.key_width;
+		auto decisive_width = encoder.GetDecisiveWidth();
+		sink.sort_chunk.Reset();
+		sink.executor.Execute(input, sink.sort_chunk);
+		encoder.Encode(sink.sort_chunk, sink.keys.get(), key_width);
+
+		SelectionVector sel(STANDARD_VECTOR_SIZE);
+		idx_t result_count = 0;
+		for (idx_t i = 0; i < input.size(); i++) {
+			if (memcmp(sink.keys.get() + i * key_width, sink.boundary.data(), decisive_width) <= 0) {
+				sel.set_index(result_count++, i);
+			}
+		}
+		if (result_count == 0) {
+			// the entire chunk sorts after the boundary
+			return;
+		}
+		if (result_count < input.size()) {
+			sink.slice_chunk.Reference(input);
+			sink.slice_chunk.Slice(sel, result_count);
+			chunk = &sink.slice_chunk;
+		}
+	}
+	// append to the local sink state
+	sink.big_data.Append(*chunk);
+
+	// once the local data exceeds the top N by enough rows, reduce it to the top N
+	auto heap_limit = limit + offset;
+	auto count = sink.big_data.Count();
+	if (count > heap_limit && count - heap_limit >= MaxValue<idx_t>(heap_limit, TOP_N_COMPACT_THRESHOLD)) {
+		CompactLocalState(*this, gstate, sink);
+	}
 }
 
 unique_ptr<idx_t[]> PhysicalTopN::ComputeTopN(ChunkCollection &big_data, idx_t &heap_size) {
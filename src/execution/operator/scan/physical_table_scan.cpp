@@ -3,6 +3,7 @@
 #include <utility>
 
 #include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
+#include "duckdb/execution/join_filter.hpp"
 #include "duckdb/transaction/transaction.hpp"
 #include "duckdb/planner/expression/bound_conjunction_expression.hpp"
 
@@ -18,6 +19,8 @@ public:
 
 	ParallelState *parallel_state;
 	unique_ptr<FunctionOperatorData> operator_data;
+	//! The table filters combined with the published join filters, if there are any
+	unique_ptr<TableFilterSet> table_filters;
 	//! Whether or not the scan has been initialized
 	bool initialized;
 };
@@ -30,6 +33,22 @@ PhysicalTableScan::PhysicalTableScan(vector<LogicalType> types, TableFunction fu
       table_filters(move(table_filters_p)) {
 }
 
+//! Returns the filters the scan is initialized with: the join filters are only known after the builds of their joins
+//! have finished, which is before the scan is initialized
+static TableFilterSet *GetTableFilters(PhysicalTableScan &op, PhysicalTableScanOperatorState &state) {
+	if (op.join_filters.empty()) {
+		return op.table_filters.get();
+	}
+	state.table_filters = make_unique<TableFilterSet>();
+	if (op.table_filters) {
+		*state.table_filters = *op.table_filters;
+	}
+	for (auto &join_filter : op.join_filters) {
+		join_filter->Apply(*state.table_filters);
+	}
+	return state.table_filters->filters.empty() ? nullptr : state.table_filters.get();
+}
+
 void PhysicalTableScan::GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_) {
 	auto &state = (PhysicalTableScanOperatorState &)*state_;
 	if (column_ids.empty()) {
@@ -38,6 +57,7 @@ void PhysicalTableScan::GetChunkInternal(ExecutionContext &context, DataChunk &c
 	if (!state.initialized) {
 		state.parallel_state = nullptr;
 		if (function.init) {
+			auto table_filters = GetTableFilters(*this, state);
 			auto &task = context.task;
 			// check if there is any parallel state to fetch
 			state.parallel_state = nullptr;
@@ -46,10 +66,10 @@ void PhysicalTableScan::GetChunkInternal(ExecutionContext &context, DataChunk &c
 				// parallel scan init
 				state.parallel_state = task_info->second;
 				state.operator_data = function.parallel_init(context.client, bind_data.get(), state.parallel_state,
-				                                             column_ids, table_filters.get());
+				                                             column_ids, table_filters);
 			} else {
 				// sequential scan init
-				state.operator_data = function.init(context.client, bind_data.get(), column_ids, table_filters.get());
+				state.operator_data = function.init(context.client, bind_data.get(), column_ids, table_filters);
 			}
 			if (!state.operator_data) {
 				// no operator data returned: nothing to scan
@@ -120,6 +140,13 @@ string PhysicalTableScan::ParamsToString() const {
 			}
 		}
 	}
+	if (!join_filters.empty()) {
+		result += "\n[INFOSEPARATOR]\n";
+		result += "Join Filters: ";
+		for (auto &join_filter : join_filters) {
+			result += "\n" + names[column_ids[join_filter->column_index]];
+		}
+	}
 	return result;
 }
 
@@ -109,31 +109,22 @@ void PhysicalRecursiveCTE::ExecuteRecursivePipelines(ExecutionContext &context)
 		return;
 	}
 
+	// the pipelines are ordered by their dependencies: a pipeline can only be scheduled once the pipelines it depends
+	// on have finished, as scheduling it might inspect their results (e.g. the HTs of a hash aggregate it scans)
+	auto &scheduler = TaskScheduler::GetScheduler(context.client);
+	auto &token = pipelines[0]->token;
 	for (auto &pipeline : pipelines) {
 		pipeline->Reset(context.client);
 		pipeline->Schedule();
-	}
 
-	// now execute tasks until all pipelines are completed again
-	auto &scheduler = TaskScheduler::GetScheduler(context.client);
-	auto &token = pipelines[0]->token;
-	while (true) {
-		unique_ptr<Task> task;
-		while (scheduler.GetTaskFromProducer(token, task)) {
-			task->Execute();
-			task.reset();
-		}
-		bool finished = true;
-		for (auto &pipeline : pipelines) {
-			if (!pipeline->IsFinished()) {
-				finished = false;
-				break;
+		// now execute tasks until the pipeline is completed again
+		while (!pipeline->IsFinished()) {
+			unique_ptr<Task> task;
+			while (scheduler.GetTaskFromProducer(token, task)) {
+				task->Execute();
+				task.reset();
 			}
 		}
-		if (finished) {
-			// all pipelines finished: done!
-			break;
-		}
 	}
 }
 
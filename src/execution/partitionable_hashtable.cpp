@@ -32,9 +32,16 @@ RadixPartitionInfo::RadixPartitionInfo(idx_t _n_partitions_upper_bound)
 
 PartitionableHashTable::PartitionableHashTable(BufferManager &_buffer_manager, RadixPartitionInfo &_partition_info,
                                                vector<LogicalType> _group_types, vector<LogicalType> _payload_types,
-                                               vector<BoundAggregateExpression *> _bindings)
+                                               vector<BoundAggregateExpression *> _bindings, idx_t _max_ht_groups)
     : buffer_manager(_buffer_manager), group_types(_group_types), payload_types(_payload_types), bindings(_bindings),
-      is_partitioned(false), partition_info(_partition_info) {
+      is_partitioned(false), partition_info(_partition_info), max_ht_groups(_max_ht_groups),
+      can_skip_pre_aggregation(true), skip_pre_aggregation(false), sampled_rows(0), sampled_groups(0) {
+	for (auto &aggr : bindings) {
+		if (aggr->distinct) {
+			// the distinct values have to be deduplicated per group
+			can_skip_pre_aggregation = false;
+		}
+	}
 
 	sel_vectors.resize(partition_info.n_partitions);
 	sel_vector_sizes.resize(partition_info.n_partitions);
@@ -52,17 +59,35 @@ PartitionableHashTable::PartitionableHashTable(BufferManager &_buffer_manager, R
 
 idx_t PartitionableHashTable::ListAddChunk(HashTableList &list, DataChunk &groups, Vector &group_hashes,
                                            DataChunk &payload) {
-	if (list.empty() || list.back()->Size() + groups.size() > list.back()->MaxCapacity()) {
+	if (list.empty() || list.back()->IsFinalized() ||
+	    list.back()->Size() + groups.size() > MinValue<idx_t>(list.back()->MaxCapacity(), max_ht_groups)) {
 		if (!list.empty()) {
 			// early release first part of ht and prevent adding of more data
-			list.back()->Finalize();
+			FinalizeHT(*list.back());
 		}
 		list.push_back(make_unique<GroupedAggregateHashTable>(buffer_manager, group_types, payload_types, bindings,
 		                                                      HtEntryType::HT_WIDTH_32));
 	}
+	if (skip_pre_aggregation) {
+		return list.back()->AppendRows(groups, group_hashes, payload);
+	}
 	return list.back()->AddChunk(groups, group_hashes, payload);
 }
 
+void PartitionableHashTable::UpdatePreAggregation(idx_t rows, idx_t groups) {
+	if (!can_skip_pre_aggregation || sampled_rows >= PRE_AGGREGATION_SAMPLE_SIZE) {
+		return;
+	}
+	sampled_rows += rows;
+	sampled_groups += groups;
+	if (sampled_rows < PRE_AGGREGATION_SAMPLE_SIZE || !IsPartitioned()) {
+		return;
+	}
+	// (almost) every row is a new group: the thread-local HTs do not reduce the amount of data that has to be combined,
+	// so from now on the rows are only radix partitioned, and are aggregated when the partitions are combined
+	skip_pre_aggregation = sampled_groups >= sampled_rows * PRE_AGGREGATION_SKIP_RATIO;
+}
+
 idx_t PartitionableHashTable::AddChunk(DataChunk &groups, DataChunk &payload, bool do_partition) {
 	groups.Hash(hashes);
 
@@ -72,7 +97,9 @@ idx_t PartitionableHashTable::AddChunk(DataChunk &groups, DataChunk &payload, bo
 	}
 
 	if (!IsPartitioned()) {
-		return ListAddChunk(unpartitioned_hts, groups, hashes, payload);
+		auto group_count = ListAddChunk(unpartitioned_hts, groups, hashes, payload);
+		UpdatePreAggregation(groups.size(), group_count);
+		return group_count;
 	}
 
 	// makes no sense to do this with 1 partition
@@ -107,6 +134,7 @@ idx_t PartitionableHashTable::AddChunk(DataChunk &groups, DataChunk &payload, bo
 
 		group_count += ListAddChunk(radix_partitioned_hts[r], group_subset, hashes_subset, payload_subset);
 	}
+	UpdatePreAggregation(groups.size(), group_count);
 	return group_count;
 }
 
@@ -116,14 +144,23 @@ void PartitionableHashTable::Partition() {
 	D_ASSERT(partition_info.n_partitions > 1);
 
 	vector<GroupedAggregateHashTable *> partition_hts;
-	for (auto &unpartitioned_ht : unpartitioned_hts) {
+	for (idx_t ht_idx = 0; ht_idx < unpartitioned_hts.size(); ht_idx++) {
+		auto &unpartitioned_ht = unpartitioned_hts[ht_idx];
+		partition_hts.clear();
 		for (idx_t r = 0; r < partition_info.n_partitions; r++) {
 			radix_partitioned_hts[r].push_back(make_unique<GroupedAggregateHashTable>(
 			    buffer_manager, group_types, payload_types, bindings, HtEntryType::HT_WIDTH_32));
 			partition_hts.push_back(radix_partitioned_hts[r].back().get());
 		}
+		unpartitioned_ht->Pin();
 		unpartitioned_ht->Partition(partition_hts, partition_info.radix_mask, partition_info.RADIX_SHIFT);
 		unpartitioned_ht.reset();
+		if (ht_idx + 1 < unpartitioned_hts.size()) {
+			// only the partitions of the last HT can receive more data
+			for (auto &partition_ht : partition_hts) {
+				FinalizeHT(*partition_ht);
+			}
+		}
 	}
 	unpartitioned_hts.clear();
 	is_partitioned = true;
@@ -133,6 +170,11 @@ bool PartitionableHashTable::IsPartitioned() {
 	return is_partitioned;
 }
 
+void PartitionableHashTable::AddHT(unique_ptr<GroupedAggregateHashTable> ht) {
+	D_ASSERT(!IsPartitioned());
+	unpartitioned_hts.push_back(move(ht));
+}
+
 HashTableList PartitionableHashTable::GetPartition(idx_t partition) {
 	D_ASSERT(IsPartitioned());
 	D_ASSERT(partition < partition_info.n_partitions);
@@ -144,18 +186,45 @@ HashTableList PartitionableHashTable::GetUnpartitioned() {
 	return move(unpartitioned_hts);
 }
 
+void PartitionableHashTable::FinalizeHT(GroupedAggregateHashTable &ht) {
+	ht.Finalize();
+	if (IsExternal()) {
+		// no more data will be added to this HT until it is combined: allow it to be spilled to disk
+		ht.Unpin();
+	}
+}
+
+void PartitionableHashTable::SetMaxGroups(idx_t max_groups) {
+	max_ht_groups = max_groups;
+	// new groups are added to new HTs from now on
+	Finalize();
+}
+
+idx_t PartitionableHashTable::SizeInBytes() {
+	idx_t size = 0;
+	for (auto &ht : unpartitioned_hts) {
+		size += ht->SizeInBytes();
+	}
+	for (auto &ht_list : radix_partitioned_hts) {
+		for (auto &ht : ht_list.second) {
+			size += ht->SizeInBytes();
+		}
+	}
+	return size;
+}
+
 void PartitionableHashTable::Finalize() {
 	if (IsPartitioned()) {
 		for (auto &ht_list : radix_partitioned_hts) {
 			for (auto &ht : ht_list.second) {
 				D_ASSERT(ht);
-				ht->Finalize();
+				FinalizeHT(*ht);
 			}
 		}
 	} else {
 		for (auto &ht : unpartitioned_hts) {
 			D_ASSERT(ht);
-			ht->Finalize();
+			FinalizeHT(*ht);
 		}
 	}
 }
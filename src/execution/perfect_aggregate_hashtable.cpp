@@ -217,8 +217,8 @@ static void ReconstructGroupVector(uint32_t group_values[], Value &min, idx_t re
 	}
 }
 
-void PerfectAggregateHashTable::Scan(idx_t &scan_position, DataChunk &result) {
-	auto data_pointers = FlatVector::GetData<data_ptr_t>(addresses);
+idx_t PerfectAggregateHashTable::ScanGroups(idx_t &scan_position, DataChunk &result, Vector &state_addresses) {
+	auto data_pointers = FlatVector::GetData<data_ptr_t>(state_addresses);
 	uint32_t group_values[STANDARD_VECTOR_SIZE];
 
 	// iterate over the HT until we either have exhausted the entire HT, or
@@ -237,15 +237,23 @@ void PerfectAggregateHashTable::Scan(idx_t &scan_position, DataChunk &result) {
 	}
 	if (entry_count == 0) {
 		// no entries found
-		return;
+		return 0;
 	}
-	// first reconstruct the groups from the group index
+	// reconstruct the groups from the group index
 	idx_t shift = total_required_bits;
 	for (idx_t i = 0; i < group_types.size(); i++) {
 		shift -= required_bits[i];
 		ReconstructGroupVector(group_values, group_minima[i], required_bits[i], shift, entry_count, result.data[i]);
 	}
-	// then construct the payloads
+	return entry_count;
+}
+
+void PerfectAggregateHashTable::Scan(idx_t &scan_position, DataChunk &result) {
+	auto entry_count = ScanGroups(scan_position, result, addresses);
+	if (entry_count == 0) {
+		return;
+	}
+	// construct the payloads
 	for (idx_t i = 0; i < aggregates.size(); i++) {
 		auto &target = result.data[group_types.size() + i];
 		auto &aggr = aggregates[i];
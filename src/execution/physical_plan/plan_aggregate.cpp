@@ -7,6 +7,7 @@
 #include "duckdb/execution/operator/projection/physical_projection.hpp"
 #include "duckdb/execution/operator/aggregate/physical_perfecthash_aggregate.hpp"
 #include "duckdb/storage/statistics/numeric_statistics.hpp"
+#include "duckdb/storage/statistics/string_statistics.hpp"
 #include "duckdb/common/operator/subtract.hpp"
 #include "duckdb/main/client_context.hpp"
 
@@ -21,8 +22,36 @@ static uint32_t RequiredBitsForValue(uint32_t n) {
 	return required_bits;
 }
 
-static bool CanUsePerfectHashAggregate(ClientContext &context, LogicalAggregate &op, vector<idx_t> &bits_per_group) {
+//! The minimum amount of bits for the dictionary of a string group (i.e. the dictionary holds at least 3 strings)
+static constexpr idx_t MINIMUM_DICTIONARY_BITS = 2;
+//! The maximum amount of bits for the dictionary of a string group: we only dictionary encode low-cardinality strings
+static constexpr idx_t MAXIMUM_DICTIONARY_BITS = 10;
+
+//! Returns whether the statistics of a string group or the estimated amount of input rows show that the group has at
+//! most the given amount of distinct values
+static bool IsLowCardinalityString(BaseStatistics *stats, idx_t estimated_cardinality, idx_t max_distinct) {
+	if (estimated_cardinality <= max_distinct) {
+		return true;
+	}
+	if (!stats) {
+		return false;
+	}
+	auto &sstats = (StringStatistics &)*stats;
+	if (sstats.HasAtMostDistinct(max_distinct)) {
+		// the strings of a stored column (e.g. status codes or country names) are counted by its statistics
+		return true;
+	}
+	if (sstats.max_string_length > 1 || sstats.min[0] > sstats.max[0]) {
+		return false;
+	}
+	// all strings are empty or have a single character in the range [min, max]
+	return idx_t(sstats.max[0] - sstats.min[0]) + 2 <= max_distinct;
+}
+
+static bool CanUsePerfectHashAggregate(ClientContext &context, LogicalAggregate &op, idx_t estimated_cardinality,
+                                       vector<idx_t> &bits_per_group) {
 	idx_t perfect_hash_bits = 0;
+	idx_t dictionary_groups = 0;
 	if (op.group_stats.size() == 0) {
 		op.group_stats.resize(op.groups.size());
 	}
@@ -30,6 +59,12 @@ static bool CanUsePerfectHashAggregate(ClientContext &context, LogicalAggregate
 		auto &group = op.groups[group_idx];
 		auto &stats = op.group_stats[group_idx];
 
+		if (group->return_type.id() == LogicalTypeId::VARCHAR) {
+			// strings are dictionary encoded, the dictionaries get the bits that the other groups leave unused
+			bits_per_group.push_back(0);
+			dictionary_groups++;
+			continue;
+		}
 		switch (group->return_type.InternalType()) {
 		case PhysicalType::INT8:
 		case PhysicalType::INT16:
@@ -37,7 +72,7 @@ static bool CanUsePerfectHashAggregate(ClientContext &context, LogicalAggregate
 		case PhysicalType::INT64:
 			break;
 		default:
-			// we only support simple integer types for perfect hashing
+			// we only support simple integer types and strings for perfect hashing
 			return false;
 		}
 		// check if the group has stats available
@@ -104,6 +139,26 @@ static bool CanUsePerfectHashAggregate(ClientContext &context, LogicalAggregate
 			return false;
 		}
 	}
+	if (dictionary_groups > 0) {
+		// divide the remaining bits evenly over the dictionaries
+		idx_t dictionary_bits = (context.perfect_ht_threshold - perfect_hash_bits) / dictionary_groups;
+		dictionary_bits = MinValue<idx_t>(dictionary_bits, MAXIMUM_DICTIONARY_BITS);
+		if (dictionary_bits < MINIMUM_DICTIONARY_BITS) {
+			return false;
+		}
+		for (idx_t group_idx = 0; group_idx < op.groups.size(); group_idx++) {
+			if (op.groups[group_idx]->return_type.id() != LogicalTypeId::VARCHAR) {
+				continue;
+			}
+			// only dictionary encode strings that are known to fit the dictionary (the id 0 is reserved for NULL):
+			// high-cardinality strings are grouped faster by a regular hash aggregate
+			if (!IsLowCardinalityString(op.group_stats[group_idx].get(), estimated_cardinality,
+			                            (idx_t(1) << dictionary_bits) - 1)) {
+				return false;
+			}
+			bits_per_group[group_idx] = dictionary_bits;
+		}
+	}
 	for (idx_t i = 0; i < op.expressions.size(); i++) {
 		auto &aggregate = (BoundAggregateExpression &)*op.expressions[i];
 		if (aggregate.distinct || !aggregate.function.combine) {
@@ -128,6 +183,8 @@ unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalAggregate
 		}
 	}
 
+	// estimate the cardinality before planning the child, as planning consumes the logical operators
+	auto estimated_cardinality = op.EstimateCardinality(context);
 	auto plan = CreatePlan(*op.children[0]);
 
 	plan = ExtractAggregateExpressions(move(plan), op.expressions, op.groups);
@@ -155,12 +212,18 @@ unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalAggregate
 		// groups! create a GROUP BY aggregator
 		// use a perfect hash aggregate if possible
 		vector<idx_t> required_bits;
-		if (CanUsePerfectHashAggregate(context, op, required_bits)) {
-			groupby = make_unique_base<PhysicalOperator, PhysicalPerfectHashAggregate>(
+		if (CanUsePerfectHashAggregate(context, op, estimated_cardinality, required_bits)) {
+			auto perfect_aggregate = make_unique<PhysicalPerfectHashAggregate>(
 			    context, op.types, move(op.expressions), move(op.groups), move(op.group_stats), move(required_bits));
+			if (perfect_aggregate->overflow_aggregate) {
+				perfect_aggregate->overflow_aggregate->estimated_cardinality = estimated_cardinality;
+			}
+			groupby = move(perfect_aggregate);
 		} else {
-			groupby = make_unique_base<PhysicalOperator, PhysicalHashAggregate>(context, op.types, move(op.expressions),
-			                                                                    move(op.groups));
+			auto hash_aggregate =
+			    make_unique<PhysicalHashAggregate>(context, op.types, move(op.expressions), move(op.groups));
+			hash_aggregate->estimated_cardinality = estimated_cardinality;
+			groupby = move(hash_aggregate);
 		}
 	}
 	groupby->children.push_back(move(plan));
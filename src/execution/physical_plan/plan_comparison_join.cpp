@@ -1,13 +1,17 @@
 #include "duckdb/execution/operator/join/physical_cross_product.hpp"
 #include "duckdb/execution/operator/join/physical_hash_join.hpp"
+#include "duckdb/execution/operator/join/physical_iejoin.hpp"
 #include "duckdb/execution/operator/join/physical_index_join.hpp"
 #include "duckdb/execution/operator/join/physical_nested_loop_join.hpp"
 #include "duckdb/execution/operator/join/physical_piecewise_merge_join.hpp"
+#include "duckdb/execution/operator/projection/physical_projection.hpp"
 #include "duckdb/execution/operator/scan/physical_table_scan.hpp"
 #include "duckdb/execution/physical_plan_generator.hpp"
 #include "duckdb/function/table/table_scan.hpp"
 #include "duckdb/main/client_context.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
 #include "duckdb/planner/operator/logical_comparison_join.hpp"
+#include "duckdb/storage/statistics/numeric_statistics.hpp"
 #include "duckdb/transaction/transaction.hpp"
 
 namespace duckdb {
@@ -63,6 +67,112 @@ void TransformIndexJoin(ClientContext &context, LogicalComparisonJoin &op, Index
 	}
 }
 
+//! Returns the table scan that produces the given output column of op unmodified, or nullptr if there is none. On
+//! success column_index is set to the index of the column in the column_ids of the scan.
+static PhysicalTableScan *FindScanColumn(PhysicalOperator &op, idx_t &column_index) {
+	switch (op.type) {
+	case PhysicalOperatorType::TABLE_SCAN: {
+		auto &scan = (PhysicalTableScan &)op;
+		if (!scan.function.filter_pushdown || !scan.function.projection_pushdown ||
+		    !dynamic_cast<TableScanBindData *>(scan.bind_data.get())) {
+			// only the storage of base tables evaluates pushed down filters
+			return nullptr;
+		}
+		if (column_index >= scan.column_ids.size() || scan.column_ids[column_index] == COLUMN_IDENTIFIER_ROW_ID) {
+			return nullptr;
+		}
+		return &scan;
+	}
+	case PhysicalOperatorType::FILTER:
+		// filters do not modify the columns of their input
+		return FindScanColumn(*op.children[0], column_index);
+	case PhysicalOperatorType::PROJECTION: {
+		auto &projection = (PhysicalProjection &)op;
+		auto &expr = *projection.select_list[column_index];
+		if (expr.type != ExpressionType::BOUND_REF) {
+			return nullptr;
+		}
+		column_index = ((BoundReferenceExpression &)expr).index;
+		return FindScanColumn(*op.children[0], column_index);
+	}
+	default:
+		return nullptr;
+	}
+}
+
+//! Creates the join filters of a hash join: a join filter is published into a table scan on the probe side once the
+//! build has finished, so that the scan can skip the rows of which the key cannot be found in the HT
+static void PlanJoinFilters(PhysicalHashJoin &join) {
+	switch (join.join_type) {
+	case JoinType::INNER:
+	case JoinType::SEMI:
+		break;
+	default:
+		// the probe side rows without a match are part of the result, or (for right joins) the HT holds the NULL keys
+		// of the build side, which cannot be told apart from the minimum value of the key type
+		return;
+	}
+	for (idx_t key_idx = 0; key_idx < join.conditions.size(); key_idx++) {
+		auto &cond = join.conditions[key_idx];
+		if (cond.comparison != ExpressionType::COMPARE_EQUAL || cond.null_values_are_equal ||
+		    cond.left->type != ExpressionType::BOUND_REF || !JoinFilter::SupportsType(cond.left->return_type)) {
+			continue;
+		}
+		idx_t column_index = ((BoundReferenceExpression &)*cond.left).index;
+		auto scan = FindScanColumn(*join.children[0], column_index);
+		if (!scan) {
+			continue;
+		}
+		auto join_filter = make_unique<JoinFilter>(key_idx, column_index, cond.left->return_type);
+		scan->join_filters.push_back(join_filter.get());
+		join.join_filters.push_back(move(join_filter));
+	}
+}
+
+//! Checks whether the HT of a hash join can be constructed as a perfect hash table: this is the case if the statistics
+//! of the build side show that its key is an integer in a small range
+static void PlanPerfectHashJoin(LogicalComparisonJoin &op, PhysicalHashJoin &join) {
+	switch (join.join_type) {
+	case JoinType::INNER:
+	case JoinType::SEMI:
+	case JoinType::ANTI:
+	case JoinType::LEFT:
+	case JoinType::SINGLE:
+		break;
+	default:
+		// the found flags of right/full outer joins require NULL keys to be stored in the HT, and the correlated mark
+		// join counts the NULL values of the build side
+		return;
+	}
+	if (join.conditions.size() != 1 || op.join_stats.size() != 2 || !op.join_stats[1]) {
+		return;
+	}
+	auto &cond = join.conditions[0];
+	if (cond.comparison != ExpressionType::COMPARE_EQUAL || cond.null_values_are_equal) {
+		return;
+	}
+	switch (cond.right->return_type.id()) {
+	case LogicalTypeId::TINYINT:
+	case LogicalTypeId::SMALLINT:
+	case LogicalTypeId::INTEGER:
+	case LogicalTypeId::BIGINT:
+		break;
+	default:
+		return;
+	}
+	auto &stats = (NumericStatistics &)*op.join_stats[1];
+	if (stats.min.is_null || stats.max.is_null) {
+		return;
+	}
+	auto min = stats.min.GetValue<int64_t>();
+	auto max = stats.max.GetValue<int64_t>();
+	if (max < min || idx_t(max) - idx_t(min) >= PhysicalHashJoin::MAX_PERFECT_HASH_RANGE) {
+		return;
+	}
+	join.perfect_min = min;
+	join.perfect_range = idx_t(max) - idx_t(min) + 1;
+}
+
 unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalComparisonJoin &op) {
 	// now visit the children
 	D_ASSERT(op.children.size() == 2);
@@ -112,14 +222,21 @@ unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalComparison
 			                                      right_index, true);
 		}
 		// equality join: use hash join
-		plan = make_unique<PhysicalHashJoin>(op, move(left), move(right), move(op.conditions), op.join_type,
-		                                     op.left_projection_map, op.right_projection_map);
+		auto join = make_unique<PhysicalHashJoin>(op, move(left), move(right), move(op.conditions), op.join_type,
+		                                          op.left_projection_map, op.right_projection_map);
+		PlanJoinFilters(*join);
+		PlanPerfectHashJoin(op, *join);
+		join->probe_cardinality = lhs_cardinality;
+		plan = move(join);
 	} else {
 		D_ASSERT(!has_null_equal_conditions); // don't support this for anything but hash joins for now
 		if (op.conditions.size() == 1 && !has_inequality) {
 			// range join: use piecewise merge join
 			plan =
 			    make_unique<PhysicalPiecewiseMergeJoin>(op, move(left), move(right), move(op.conditions), op.join_type);
+		} else if (PhysicalIEJoin::IsSupported(op.conditions, op.join_type)) {
+			// two range conditions: use IEJoin
+			plan = make_unique<PhysicalIEJoin>(op, move(left), move(right), move(op.conditions), op.join_type);
 		} else {
 			// inequality join: use nested loop
 			plan = make_unique<PhysicalNestedLoopJoin>(op, move(left), move(right), move(op.conditions), op.join_type);
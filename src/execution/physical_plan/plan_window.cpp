@@ -1,9 +1,105 @@
+#include "duckdb/common/unordered_set.hpp"
+#include "duckdb/execution/operator/aggregate/physical_streaming_window.hpp"
 #include "duckdb/execution/operator/aggregate/physical_window.hpp"
+#include "duckdb/execution/operator/order/physical_order.hpp"
+#include "duckdb/execution/operator/order/physical_top_n.hpp"
+#include "duckdb/execution/operator/projection/physical_projection.hpp"
 #include "duckdb/execution/physical_plan_generator.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/planner/expression/bound_window_expression.hpp"
 #include "duckdb/planner/operator/logical_window.hpp"
 
 namespace duckdb {
 
+//! The sort order of a single column of the output of a physical operator
+struct ColumnOrder {
+	idx_t column_index;
+	OrderType type;
+	OrderByNullType null_order;
+};
+
+static vector<ColumnOrder> GetSortOrder(vector<BoundOrderByNode> &orders) {
+	vector<ColumnOrder> result;
+	for (auto &order : orders) {
+		if (order.expression->type != ExpressionType::BOUND_REF) {
+			// only the orders up to the first computed expression are known to hold for the output columns
+			break;
+		}
+		auto &ref = (BoundReferenceExpression &)*order.expression;
+		result.push_back(ColumnOrder {ref.index, order.type, order.null_order});
+	}
+	return result;
+}
+
+//! Returns the columns that the output of the physical operator is known to be sorted on (if any)
+static vector<ColumnOrder> GetOutputOrder(PhysicalOperator &op) {
+	switch (op.type) {
+	case PhysicalOperatorType::ORDER_BY:
+		return GetSortOrder(((PhysicalOrder &)op).orders);
+	case PhysicalOperatorType::TOP_N:
+		return GetSortOrder(((PhysicalTopN &)op).orders);
+	case PhysicalOperatorType::FILTER:
+	case PhysicalOperatorType::LIMIT:
+		// these operators preserve the order of their input
+		return GetOutputOrder(*op.children[0]);
+	case PhysicalOperatorType::PROJECTION: {
+		// the order is preserved for the input columns that are projected
+		auto &projection = (PhysicalProjection &)op;
+		vector<ColumnOrder> result;
+		for (auto &order : GetOutputOrder(*op.children[0])) {
+			idx_t projected_index = INVALID_INDEX;
+			for (idx_t i = 0; i < projection.select_list.size(); i++) {
+				auto &expr = *projection.select_list[i];
+				if (expr.type == ExpressionType::BOUND_REF &&
+				    ((BoundReferenceExpression &)expr).index == order.column_index) {
+					projected_index = i;
+					break;
+				}
+			}
+			if (projected_index == INVALID_INDEX) {
+				break;
+			}
+			result.push_back(ColumnOrder {projected_index, order.type, order.null_order});
+		}
+		return result;
+	}
+	default:
+		return vector<ColumnOrder>();
+	}
+}
+
+//! Returns whether or not the input of the window expression is grouped on its PARTITION BY keys, and sorted on its
+//! ORDER BY keys within every partition
+static bool WindowInputIsSorted(BoundWindowExpression &wexpr, vector<ColumnOrder> &input_order) {
+	// the partitions are contiguous if the input is sorted on the partition keys first, in any direction
+	unordered_set<idx_t> partition_columns;
+	for (auto &pexpr : wexpr.partitions) {
+		if (pexpr->type != ExpressionType::BOUND_REF) {
+			return false;
+		}
+		partition_columns.insert(((BoundReferenceExpression &)*pexpr).index);
+	}
+	idx_t order_idx = partition_columns.size();
+	if (order_idx + wexpr.orders.size() > input_order.size()) {
+		return false;
+	}
+	for (idx_t i = 0; i < order_idx; i++) {
+		if (partition_columns.find(input_order[i].column_index) == partition_columns.end()) {
+			return false;
+		}
+	}
+	// the ORDER BY keys then have to follow in the same order
+	for (auto &order : wexpr.orders) {
+		auto &column_order = input_order[order_idx++];
+		if (order.expression->type != ExpressionType::BOUND_REF ||
+		    ((BoundReferenceExpression &)*order.expression).index != column_order.column_index ||
+		    order.type != column_order.type || order.null_order != column_order.null_order) {
+			return false;
+		}
+	}
+	return true;
+}
+
 unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalWindow &op) {
 	D_ASSERT(op.children.size() == 1);
 
@@ -14,9 +110,24 @@ unique_ptr<PhysicalOperator> PhysicalPlanGenerator::CreatePlan(LogicalWindow &op
 	}
 #endif
 
-	auto window = make_unique<PhysicalWindow>(op.types, move(op.expressions));
+	// if the input is already sorted on the keys of all window expressions, they can be computed while streaming
+	auto input_order = GetOutputOrder(*plan);
+	bool streaming = true;
+	for (auto &expr : op.expressions) {
+		auto &wexpr = (BoundWindowExpression &)*expr;
+		if (!PhysicalStreamingWindow::IsStreamable(wexpr) || !WindowInputIsSorted(wexpr, input_order)) {
+			streaming = false;
+			break;
+		}
+	}
+	unique_ptr<PhysicalOperator> window;
+	if (streaming) {
+		window = make_unique<PhysicalStreamingWindow>(op.types, move(op.expressions));
+	} else {
+		window = make_unique<PhysicalWindow>(op.types, move(op.expressions));
+	}
 	window->children.push_back(move(plan));
-	return move(window);
+	return window;
 }
 
 } // namespace duckdb
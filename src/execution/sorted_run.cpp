@@ -0,0 +1,420 @@
+#include "duckdb/execution/sorted_run.hpp"
+
+#include "duckdb/common/types/sort_key.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+
+namespace duckdb {
+
+SortedRun::SortedRun(BufferManager &buffer_manager, vector<LogicalType> types_p)
+    : types(move(types_p)), count(0), buffer_manager(buffer_manager), write_capacity(0) {
+	spillable = CanSpill(types);
+}
+
+bool SortedRun::CanSpill(vector<LogicalType> &types) {
+	for (auto &type : types) {
+		auto internal_type = type.InternalType();
+		if (!TypeIsConstantSize(internal_type) && internal_type != PhysicalType::VARCHAR) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//===--------------------------------------------------------------------===//
+// Chunk Serialization
+//===--------------------------------------------------------------------===//
+// chunks are stored as [count] followed by [nullmask][data] for every column. Strings are stored as [length][data].
+// in contrast to DataChunk::Serialize this does not use NullValue<T>, so the full domain of every type is preserved.
+idx_t SortedRun::GetSerializedSize(DataChunk &chunk) {
+	idx_t size = sizeof(idx_t);
+	for (idx_t col_idx = 0; col_idx < chunk.ColumnCount(); col_idx++) {
+		auto &vec = chunk.data[col_idx];
+		size += sizeof(nullmask_t);
+		if (vec.type.InternalType() == PhysicalType::VARCHAR) {
+			auto strings = FlatVector::GetData<string_t>(vec);
+			auto &nullmask = FlatVector::Nullmask(vec);
+			for (idx_t i = 0; i < chunk.size(); i++) {
+				size += sizeof(uint32_t) + (nullmask[i] ? 0 : strings[i].GetSize());
+			}
+		} else {
+			size += GetTypeIdSize(vec.type.InternalType()) * chunk.size();
+		}
+	}
+	return size;
+}
+
+void SortedRun::SerializeChunk(DataChunk &chunk, data_ptr_t target) {
+	Store<idx_t>(chunk.size(), target);
+	target += sizeof(idx_t);
+	for (idx_t col_idx = 0; col_idx < chunk.ColumnCount(); col_idx++) {
+		auto &vec = chunk.data[col_idx];
+		auto &nullmask = FlatVector::Nullmask(vec);
+		memcpy(target, &nullmask, sizeof(nullmask_t));
+		target += sizeof(nullmask_t);
+		if (vec.type.InternalType() == PhysicalType::VARCHAR) {
+			auto strings = FlatVector::GetData<string_t>(vec);
+			for (idx_t i = 0; i < chunk.size(); i++) {
+				uint32_t length = nullmask[i] ? 0 : strings[i].GetSize();
+				Store<uint32_t>(length, target);
+				target += sizeof(uint32_t);
+				memcpy(target, strings[i].GetDataUnsafe(), length);
+				target += length;
+			}
+		} else {
+			auto data_size = GetTypeIdSize(vec.type.InternalType()) * chunk.size();
+			memcpy(target, FlatVector::GetData(vec), data_size);
+			target += data_size;
+		}
+	}
+}
+
+void SortedRunScanner::DeserializeChunk(DataChunk &result) {
+	auto source = read_handle->Ptr() + offset;
+	result.Reset();
+	result.SetCardinality(Load<idx_t>(source));
+	source += sizeof(idx_t);
+	for (idx_t col_idx = 0; col_idx < result.ColumnCount(); col_idx++) {
+		auto &vec = result.data[col_idx];
+		auto &nullmask = FlatVector::Nullmask(vec);
+		memcpy(&nullmask, source, sizeof(nullmask_t));
+		source += sizeof(nullmask_t);
+		if (vec.type.InternalType() == PhysicalType::VARCHAR) {
+			// the strings point directly into the pinned block
+			auto strings = FlatVector::GetData<string_t>(vec);
+			for (idx_t i = 0; i < result.size(); i++) {
+				auto length = Load<uint32_t>(source);
+				source += sizeof(uint32_t);
+				strings[i] = string_t((const char *)source, length);
+				source += length;
+			}
+		} else {
+			auto data_size = GetTypeIdSize(vec.type.InternalType()) * result.size();
+			memcpy(FlatVector::GetData(vec), source, data_size);
+			source += data_size;
+		}
+	}
+	offset = source - read_handle->Ptr();
+}
+
+//===--------------------------------------------------------------------===//
+// Append
+//===--------------------------------------------------------------------===//
+void SortedRun::Append(DataChunk &chunk) {
+	if (chunk.size() == 0) {
+		return;
+	}
+	count += chunk.size();
+	if (!spillable) {
+		chunks.Append(chunk);
+		return;
+	}
+	chunk.Normalify();
+	auto size = GetSerializedSize(chunk);
+	if (!write_handle || blocks.back().size + size > write_capacity) {
+		// the chunk does not fit in the current block: unpin it and start a new one
+		write_handle.reset();
+		auto alloc_size = MaxValue<idx_t>(size + Storage::BLOCK_HEADER_SIZE, Storage::BLOCK_ALLOC_SIZE);
+		SortedRunBlock new_block;
+		new_block.block = buffer_manager.RegisterMemory(alloc_size, false);
+		new_block.size = 0;
+		new_block.chunk_count = 0;
+		write_handle = buffer_manager.Pin(new_block.block);
+		write_capacity = alloc_size - Storage::BLOCK_HEADER_SIZE;
+		blocks.push_back(move(new_block));
+	}
+	auto &block = blocks.back();
+	block.chunk_offsets.push_back(block.size);
+	SerializeChunk(chunk, write_handle->Ptr() + block.size);
+	block.size += size;
+	block.chunk_count++;
+}
+
+void SortedRun::Finalize() {
+	// unpin the last block so it can be offloaded
+	write_handle.reset();
+}
+
+//===--------------------------------------------------------------------===//
+// Scan
+//===--------------------------------------------------------------------===//
+SortedRunScanner::SortedRunScanner(SortedRun &run) : run(run), block_idx(0), chunk_idx(0), offset(0) {
+}
+
+void SortedRunScanner::Scan(DataChunk &result) {
+	if (!run.spillable) {
+		if (block_idx >= run.chunks.ChunkCount()) {
+			result.SetCardinality(0);
+			return;
+		}
+		result.Reference(run.chunks.GetChunk(block_idx++));
+		return;
+	}
+	while (block_idx < run.blocks.size() && chunk_idx >= run.blocks[block_idx].chunk_count) {
+		// exhausted the current block: move to the next one
+		read_handle.reset();
+		block_idx++;
+		chunk_idx = 0;
+		offset = 0;
+	}
+	if (block_idx >= run.blocks.size()) {
+		result.SetCardinality(0);
+		return;
+	}
+	if (!read_handle) {
+		read_handle = run.buffer_manager.Pin(run.blocks[block_idx].block);
+	}
+	DeserializeChunk(result);
+	chunk_idx++;
+}
+
+void SortedRunScanner::Seek(idx_t chunk_index) {
+	if (!run.spillable) {
+		block_idx = chunk_index;
+		return;
+	}
+	idx_t new_block_idx = 0;
+	while (new_block_idx < run.blocks.size() && chunk_index >= run.blocks[new_block_idx].chunk_count) {
+		chunk_index -= run.blocks[new_block_idx].chunk_count;
+		new_block_idx++;
+	}
+	if (new_block_idx != block_idx) {
+		read_handle.reset();
+		block_idx = new_block_idx;
+	}
+	chunk_idx = chunk_index;
+	offset = block_idx < run.blocks.size() ? run.blocks[block_idx].chunk_offsets[chunk_idx] : 0;
+}
+
+//===--------------------------------------------------------------------===//
+// Sort & Merge
+//===--------------------------------------------------------------------===//
+unique_ptr<SortedRun> SortedRun::CreateFromCollection(BufferManager &buffer_manager, ChunkCollection &collection,
+                                                      SortDescription &desc) {
+	auto result = make_unique<SortedRun>(buffer_manager, collection.Types());
+	if (collection.Count() == 0) {
+		return result;
+	}
+	auto sorted_vector = unique_ptr<idx_t[]>(new idx_t[collection.Count()]);
+	collection.Sort(desc.order_types, desc.null_orders, sorted_vector.get());
+
+	DataChunk sorted_chunk;
+	sorted_chunk.Initialize(collection.Types());
+	for (idx_t position = 0; position < collection.Count(); position += STANDARD_VECTOR_SIZE) {
+		sorted_chunk.Reset();
+		collection.MaterializeSortedChunk(sorted_chunk, sorted_vector.get(), position);
+		result->Append(sorted_chunk);
+	}
+	result->Finalize();
+	return result;
+}
+
+struct SortedRunMergeSource {
+	SortedRunMergeSource(SortedRun &run, SortedRunPosition begin, SortedRunPosition end_p, SortKeyEncoder &encoder)
+	    : scanner(run), encoder(encoder), chunk_idx(begin.chunk_idx), end(end_p) {
+		chunk.Initialize(run.types);
+		keys = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * encoder.key_width]);
+		scanner.Seek(chunk_idx);
+		Load();
+		position = MinValue<idx_t>(begin.row_idx, limit);
+	}
+
+	SortedRunScanner scanner;
+	SortKeyEncoder &encoder;
+	DataChunk chunk;
+	//! The encoded sort keys of the current chunk
+	unique_ptr<data_t[]> keys;
+	//! The orrified sort columns of the current chunk, for keys that are not decisive
+	vector<VectorData> chunk_data;
+	//! The index of the current chunk within the run
+	idx_t chunk_idx;
+	//! The next row of the current chunk
+	idx_t position;
+	//! The end of the rows of the current chunk that are merged
+	idx_t limit;
+	//! The end of the range of the run that is merged
+	SortedRunPosition end;
+
+	bool Exhausted() {
+		return position >= limit;
+	}
+	void Next() {
+		chunk_idx++;
+		Load();
+		position = 0;
+	}
+	data_ptr_t GetKey(idx_t idx) {
+		return keys.get() + idx * encoder.key_width;
+	}
+
+private:
+	void Load() {
+		if (chunk_idx > end.chunk_idx || (chunk_idx == end.chunk_idx && end.row_idx == 0)) {
+			// the range is exhausted
+			limit = 0;
+			return;
+		}
+		scanner.Scan(chunk);
+		encoder.Encode(chunk, keys.get(), encoder.key_width);
+		encoder.OrrifyTieColumns(chunk, chunk_data);
+		limit = chunk_idx == end.chunk_idx ? MinValue<idx_t>(end.row_idx, chunk.size()) : chunk.size();
+	}
+};
+
+//! Compares the sort keys of two rows, returns a negative number if the left row sorts first
+static int CompareRows(SortedRunMergeSource &left, idx_t left_idx, SortedRunMergeSource &right, idx_t right_idx) {
+	return left.encoder.Compare(left.GetKey(left_idx), right.GetKey(right_idx), left.chunk_data, left_idx,
+	                            right.chunk_data, right_idx);
+}
+
+unique_ptr<SortedRun> SortedRun::Merge(BufferManager &buffer_manager, vector<unique_ptr<SortedRun>> runs,
+                                       SortDescription &desc) {
+	D_ASSERT(runs.size() > 0);
+	vector<SortedRun *> run_pointers;
+	vector<SortedRunPosition> begins;
+	vector<SortedRunPosition> ends;
+	for (auto &run : runs) {
+		run_pointers.push_back(run.get());
+		begins.push_back(SortedRunPosition {0, 0});
+		ends.push_back(SortedRunPosition {run->ChunkCount(), 0});
+	}
+	// the input runs are destroyed when they go out of scope
+	return MergeRanges(buffer_manager, run_pointers, begins, ends, desc);
+}
+
+unique_ptr<SortedRun> SortedRun::MergeRanges(BufferManager &buffer_manager, vector<SortedRun *> &runs,
+                                             vector<SortedRunPosition> &begins, vector<SortedRunPosition> &ends,
+                                             SortDescription &desc) {
+	D_ASSERT(runs.size() > 0);
+	D_ASSERT(runs.size() == begins.size() && runs.size() == ends.size());
+	auto result = make_unique<SortedRun>(buffer_manager, runs[0]->types);
+	vector<LogicalType> key_types(result->types.begin(), result->types.begin() + desc.KeyCount());
+	SortKeyEncoder encoder(move(key_types), desc.order_types, desc.null_orders);
+	vector<unique_ptr<SortedRunMergeSource>> sources;
+	for (idx_t run_idx = 0; run_idx < runs.size(); run_idx++) {
+		sources.push_back(make_unique<SortedRunMergeSource>(*runs[run_idx], begins[run_idx], ends[run_idx], encoder));
+	}
+
+	DataChunk merged;
+	merged.Initialize(result->types);
+	while (true) {
+		// find the source with the smallest head, and the runner-up
+		SortedRunMergeSource *min_source = nullptr;
+		SortedRunMergeSource *second_source = nullptr;
+		for (auto &source : sources) {
+			if (source->Exhausted()) {
+				continue;
+			}
+			if (!min_source || CompareRows(*source, source->position, *min_source, min_source->position) < 0) {
+				second_source = min_source;
+				min_source = source.get();
+			} else if (!second_source ||
+			           CompareRows(*source, source->position, *second_source, second_source->position) < 0) {
+				second_source = source.get();
+			}
+		}
+		if (!min_source) {
+			break;
+		}
+		// take rows from the smallest source for as long as they sort before the head of the runner-up
+		idx_t end = min_source->position + 1;
+		idx_t limit = MinValue<idx_t>(min_source->limit, min_source->position + STANDARD_VECTOR_SIZE - merged.size());
+		while (end < limit &&
+		       (!second_source || CompareRows(*min_source, end, *second_source, second_source->position) <= 0)) {
+			end++;
+		}
+		for (idx_t col_idx = 0; col_idx < merged.ColumnCount(); col_idx++) {
+			VectorOperations::Copy(min_source->chunk.data[col_idx], merged.data[col_idx], end, min_source->position,
+			                       merged.size());
+		}
+		merged.SetCardinality(merged.size() + end - min_source->position);
+		min_source->position = end;
+		if (min_source->position >= min_source->limit) {
+			min_source->Next();
+		}
+		if (merged.size() == STANDARD_VECTOR_SIZE) {
+			result->Append(merged);
+			merged.Reset();
+		}
+	}
+	result->Append(merged);
+	result->Finalize();
+	return result;
+}
+
+//===--------------------------------------------------------------------===//
+// Range Partitioning
+//===--------------------------------------------------------------------===//
+idx_t SortedRun::ChunkCount() {
+	if (!spillable) {
+		return chunks.ChunkCount();
+	}
+	idx_t chunk_count = 0;
+	for (auto &block : blocks) {
+		chunk_count += block.chunk_count;
+	}
+	return chunk_count;
+}
+
+vector<SortedRunPosition> SortedRun::LowerBounds(DataChunk &splitters, SortDescription &desc) {
+	vector<LogicalType> key_types(types.begin(), types.begin() + desc.KeyCount());
+	SortKeyEncoder encoder(move(key_types), desc.order_types, desc.null_orders);
+	auto splitter_keys = unique_ptr<data_t[]>(new data_t[splitters.size() * encoder.key_width]);
+	encoder.Encode(splitters, splitter_keys.get(), encoder.key_width);
+	vector<VectorData> splitter_data;
+	encoder.OrrifyTieColumns(splitters, splitter_data);
+
+	SortedRunScanner scanner(*this);
+	DataChunk chunk;
+	chunk.Initialize(types);
+	auto keys = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * encoder.key_width]);
+	vector<VectorData> chunk_data;
+	auto load_chunk = [&](idx_t chunk_idx) {
+		scanner.Seek(chunk_idx);
+		scanner.Scan(chunk);
+		encoder.Encode(chunk, keys.get(), encoder.key_width);
+		encoder.OrrifyTieColumns(chunk, chunk_data);
+	};
+	auto sorts_before = [&](idx_t row_idx, idx_t splitter_idx) {
+		return encoder.Compare(keys.get() + row_idx * encoder.key_width,
+		                       splitter_keys.get() + splitter_idx * encoder.key_width, chunk_data, row_idx,
+		                       splitter_data, splitter_idx) < 0;
+	};
+
+	vector<SortedRunPosition> result;
+	auto chunk_count = ChunkCount();
+	// the splitters are sorted, so the search for the next splitter can start at the chunk of the previous one
+	idx_t lower = 0;
+	for (idx_t splitter_idx = 0; splitter_idx < splitters.size(); splitter_idx++) {
+		// binary search for the first chunk of which the last row does not sort before the splitter
+		idx_t upper = chunk_count;
+		while (lower < upper) {
+			idx_t middle = (lower + upper) / 2;
+			load_chunk(middle);
+			if (sorts_before(chunk.size() - 1, splitter_idx)) {
+				lower = middle + 1;
+			} else {
+				upper = middle;
+			}
+		}
+		if (lower == chunk_count) {
+			result.push_back(SortedRunPosition {chunk_count, 0});
+			continue;
+		}
+		// binary search for the first row of that chunk that does not sort before the splitter
+		load_chunk(lower);
+		idx_t row_lower = 0;
+		idx_t row_upper = chunk.size() - 1;
+		while (row_lower < row_upper) {
+			idx_t middle = (row_lower + row_upper) / 2;
+			if (sorts_before(middle, splitter_idx)) {
+				row_lower = middle + 1;
+			} else {
+				row_upper = middle;
+			}
+		}
+		result.push_back(SortedRunPosition {lower, row_lower});
+	}
+	return result;
+}
+
+} // namespace duckdb
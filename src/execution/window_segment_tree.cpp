@@ -10,13 +10,16 @@ namespace duckdb {
 WindowSegmentTree::WindowSegmentTree(AggregateFunction &aggregate, FunctionData *bind_info, LogicalType result_type,
                                      ChunkCollection *input)
     : aggregate(aggregate), bind_info(bind_info), result_type(result_type), state(aggregate.state_size()),
-      internal_nodes(0), input_ref(input) {
+      statep(LogicalType::POINTER), frame_statep(LogicalType::POINTER), combine_sources(LogicalType::POINTER),
+      combine_targets(LogicalType::POINTER), combine_count(0), internal_nodes(0), input_ref(input) {
 #if STANDARD_VECTOR_SIZE < 512
 	throw NotImplementedException("Window functions are not supported for vector sizes < 512");
 #endif
-	Value ptr_val = Value::POINTER((idx_t)state.data());
-	statep.Reference(ptr_val);
-	statep.Normalify(STANDARD_VECTOR_SIZE);
+	frame_states = unique_ptr<data_t[]>(new data_t[STANDARD_VECTOR_SIZE * state.size()]);
+	auto frame_pointers = FlatVector::GetData<data_ptr_t>(frame_statep);
+	for (idx_t i = 0; i < STANDARD_VECTOR_SIZE; i++) {
+		frame_pointers[i] = frame_states.get() + i * state.size();
+	}
 
 	if (input_ref && input_ref->ColumnCount() > 0) {
 		inputs.Initialize(input_ref->Types());
@@ -47,24 +50,7 @@ WindowSegmentTree::~WindowSegmentTree() {
 	}
 }
 
-void WindowSegmentTree::AggregateInit() {
-	aggregate.initialize(state.data());
-}
-
-Value WindowSegmentTree::AggegateFinal() {
-	Vector statev(Value::POINTER((idx_t)state.data()));
-	Vector result(result_type);
-	result.vector_type = VectorType::CONSTANT_VECTOR;
-	ConstantVector::SetNull(result, false);
-	aggregate.finalize(statev, bind_info, result, 1);
-
-	if (aggregate.destructor) {
-		aggregate.destructor(statev, 1);
-	}
-	return result.GetValue(0);
-}
-
-void WindowSegmentTree::WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end) {
+void WindowSegmentTree::WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end, data_ptr_t target) {
 	D_ASSERT(begin <= end);
 	if (begin == end) {
 		return;
@@ -72,8 +58,11 @@ void WindowSegmentTree::WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end)
 	inputs.Reset();
 	inputs.SetCardinality(end - begin);
 
-	Vector s;
-	s.Slice(statep, 0);
+	// point the state vector to the target state
+	auto state_pointers = FlatVector::GetData<data_ptr_t>(statep);
+	for (idx_t i = 0; i < inputs.size(); i++) {
+		state_pointers[i] = target;
+	}
 	idx_t start_in_vector = begin % STANDARD_VECTOR_SIZE;
 	if (l_idx == 0) {
 		const auto input_count = input_ref->ColumnCount();
@@ -97,7 +86,11 @@ void WindowSegmentTree::WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end)
 				VectorOperations::Copy(chunk_b.data[i], v, chunk_b_count, 0, chunk_a_count);
 			}
 		}
-		aggregate.update(&inputs.data[0], input_count, s, inputs.size());
+		if (aggregate.simple_update) {
+			aggregate.simple_update(&inputs.data[0], input_count, target, inputs.size());
+		} else {
+			aggregate.update(&inputs.data[0], input_count, statep, inputs.size());
+		}
 	} else {
 		D_ASSERT(end - begin <= STANDARD_VECTOR_SIZE);
 		// find out where the states begin
@@ -109,7 +102,7 @@ void WindowSegmentTree::WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end)
 			pdata[i] = begin_ptr + i * state.size();
 		}
 		v.Verify(inputs.size());
-		aggregate.combine(v, s, inputs.size());
+		aggregate.combine(v, statep, inputs.size());
 	}
 }
 
@@ -136,8 +129,8 @@ void WindowSegmentTree::ConstructTree() {
 	                                         : levels_flat_offset - levels_flat_start[level_current - 1])) > 1) {
 		for (idx_t pos = 0; pos < level_size; pos += TREE_FANOUT) {
 			// compute the aggregate for this entry in the segment tree
-			AggregateInit();
-			WindowSegmentValue(level_current, pos, MinValue<idx_t>(level_size, pos + TREE_FANOUT));
+			aggregate.initialize(state.data());
+			WindowSegmentValue(level_current, pos, MinValue<idx_t>(level_size, pos + TREE_FANOUT), state.data());
 
 			memcpy(levels_flat_native.get() + (levels_flat_offset * state.size()), state.data(), state.size());
 
@@ -149,47 +142,116 @@ void WindowSegmentTree::ConstructTree() {
 	}
 }
 
-Value WindowSegmentTree::Compute(idx_t begin, idx_t end) {
-	D_ASSERT(input_ref);
-
-	// No arguments, so just count
-	if (inputs.ColumnCount() == 0) {
-		return Value::Numeric(result_type, end - begin);
+void WindowSegmentTree::QueueCombines(idx_t l_idx, idx_t begin, idx_t end, data_ptr_t target) {
+	D_ASSERT(l_idx > 0);
+	auto sources = FlatVector::GetData<data_ptr_t>(combine_sources);
+	auto targets = FlatVector::GetData<data_ptr_t>(combine_targets);
+	data_ptr_t begin_ptr = levels_flat_native.get() + state.size() * (begin + levels_flat_start[l_idx - 1]);
+	for (idx_t i = 0; i < end - begin; i++) {
+		if (combine_count == STANDARD_VECTOR_SIZE) {
+			FlushCombines();
+		}
+		sources[combine_count] = begin_ptr + i * state.size();
+		targets[combine_count] = target;
+		combine_count++;
 	}
+}
 
-	AggregateInit();
-
-	// Aggregate everything at once if we can't combine states
-	if (!aggregate.combine) {
-		WindowSegmentValue(0, begin, end);
-		if (end - begin >= STANDARD_VECTOR_SIZE) {
-			throw InternalException(
-			    "Cannot compute window aggregation: bounds are too large for non-combinable aggregate");
-		}
-		return AggegateFinal();
+void WindowSegmentTree::FlushCombines() {
+	if (combine_count == 0) {
+		return;
 	}
+	aggregate.combine(combine_sources, combine_targets, combine_count);
+	combine_count = 0;
+}
 
+void WindowSegmentTree::ComputeFrame(idx_t begin, idx_t end, data_ptr_t target) {
+	// the updates of the leaves are performed immediately, the combines of the internal nodes are queued and
+	// performed for many frames at once
 	for (idx_t l_idx = 0; l_idx < levels_flat_start.size() + 1; l_idx++) {
 		idx_t parent_begin = begin / TREE_FANOUT;
 		idx_t parent_end = end / TREE_FANOUT;
 		if (parent_begin == parent_end) {
-			WindowSegmentValue(l_idx, begin, end);
-			return AggegateFinal();
+			if (l_idx == 0) {
+				WindowSegmentValue(l_idx, begin, end, target);
+			} else {
+				QueueCombines(l_idx, begin, end, target);
+			}
+			return;
 		}
 		idx_t group_begin = parent_begin * TREE_FANOUT;
 		if (begin != group_begin) {
-			WindowSegmentValue(l_idx, begin, group_begin + TREE_FANOUT);
+			if (l_idx == 0) {
+				WindowSegmentValue(l_idx, begin, group_begin + TREE_FANOUT, target);
+			} else {
+				QueueCombines(l_idx, begin, group_begin + TREE_FANOUT, target);
+			}
 			parent_begin++;
 		}
 		idx_t group_end = parent_end * TREE_FANOUT;
 		if (end != group_end) {
-			WindowSegmentValue(l_idx, group_end, end);
+			if (l_idx == 0) {
+				WindowSegmentValue(l_idx, group_end, end, target);
+			} else {
+				QueueCombines(l_idx, group_end, end, target);
+			}
 		}
 		begin = parent_begin;
 		end = parent_end;
 	}
+}
+
+void WindowSegmentTree::Compute(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result) {
+	D_ASSERT(input_ref);
+	D_ASSERT(count <= STANDARD_VECTOR_SIZE);
+	D_ASSERT(result.vector_type == VectorType::FLAT_VECTOR);
+
+	// No arguments, so just count
+	if (inputs.ColumnCount() == 0) {
+		D_ASSERT(result_type.InternalType() == PhysicalType::INT64);
+		auto result_data = FlatVector::GetData<int64_t>(result);
+		for (idx_t i = 0; i < count; i++) {
+			if (begins[i] >= ends[i]) {
+				// if no values are read for a window, the result is NULL
+				FlatVector::SetNull(result, i, true);
+				continue;
+			}
+			result_data[i] = ends[i] - begins[i];
+		}
+		return;
+	}
 
-	return AggegateFinal();
+	auto frame_pointers = FlatVector::GetData<data_ptr_t>(frame_statep);
+	for (idx_t i = 0; i < count; i++) {
+		aggregate.initialize(frame_pointers[i]);
+	}
+	for (idx_t i = 0; i < count; i++) {
+		if (begins[i] >= ends[i]) {
+			continue;
+		}
+		if (!aggregate.combine) {
+			// aggregate everything at once if we can't combine states
+			if (ends[i] - begins[i] >= STANDARD_VECTOR_SIZE) {
+				throw InternalException(
+				    "Cannot compute window aggregation: bounds are too large for non-combinable aggregate");
+			}
+			WindowSegmentValue(0, begins[i], ends[i], frame_pointers[i]);
+		} else {
+			ComputeFrame(begins[i], ends[i], frame_pointers[i]);
+		}
+	}
+	FlushCombines();
+
+	aggregate.finalize(frame_statep, bind_info, result, count);
+	if (aggregate.destructor) {
+		aggregate.destructor(frame_statep, count);
+	}
+	// if no values are read for a window, the result is NULL
+	for (idx_t i = 0; i < count; i++) {
+		if (begins[i] >= ends[i]) {
+			FlatVector::SetNull(result, i, true);
+		}
+	}
 }
 
 } // namespace duckdb
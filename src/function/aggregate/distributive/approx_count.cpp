@@ -0,0 +1,112 @@
+#include "duckdb/function/aggregate/distributive_functions.hpp"
+#include "duckdb/common/types/hyperloglog.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+
+namespace duckdb {
+
+struct approx_distinct_count_state_t {
+	//! The sketch is only allocated once the first non-NULL value is added
+	HyperLogLog *log;
+};
+
+struct ApproxCountDistinctFunction {
+	template <class STATE> static void Initialize(STATE *state) {
+		state->log = nullptr;
+	}
+
+	template <class STATE, class OP> static void Combine(STATE source, STATE *target) {
+		if (!source.log) {
+			return;
+		}
+		if (!target->log) {
+			target->log = new HyperLogLog(*source.log);
+		} else {
+			target->log->Merge(*source.log);
+		}
+	}
+
+	template <class T, class STATE>
+	static void Finalize(Vector &result, FunctionData *, STATE *state, T *target, nullmask_t &nullmask, idx_t idx) {
+		target[idx] = state->log ? state->log->Count() : 0;
+	}
+
+	template <class STATE> static void Destroy(STATE *state) {
+		if (state->log) {
+			delete state->log;
+		}
+	}
+
+	static bool IgnoreNull() {
+		return true;
+	}
+};
+
+static inline void ApproxCountDistinctAdd(approx_distinct_count_state_t *state, hash_t hash) {
+	if (!state->log) {
+		state->log = new HyperLogLog();
+	}
+	state->log->Add(hash);
+}
+
+static void ApproxCountDistinctSimpleUpdate(Vector inputs[], idx_t input_count, data_ptr_t state_p, idx_t count) {
+	D_ASSERT(input_count == 1);
+	auto state = (approx_distinct_count_state_t *)state_p;
+
+	// hash the entire vector at once
+	Vector hashes(LogicalType::HASH);
+	VectorOperations::Hash(inputs[0], hashes, count);
+
+	VectorData idata, hdata;
+	inputs[0].Orrify(count, idata);
+	hashes.Orrify(count, hdata);
+	auto hash_data = (hash_t *)hdata.data;
+	for (idx_t i = 0; i < count; i++) {
+		auto idx = idata.sel->get_index(i);
+		if ((*idata.nullmask)[idx]) {
+			continue;
+		}
+		ApproxCountDistinctAdd(state, hash_data[hdata.sel->get_index(i)]);
+	}
+}
+
+static void ApproxCountDistinctUpdate(Vector inputs[], idx_t input_count, Vector &state_vector, idx_t count) {
+	D_ASSERT(input_count == 1);
+
+	// hash the entire vector at once
+	Vector hashes(LogicalType::HASH);
+	VectorOperations::Hash(inputs[0], hashes, count);
+
+	VectorData idata, hdata, sdata;
+	inputs[0].Orrify(count, idata);
+	hashes.Orrify(count, hdata);
+	state_vector.Orrify(count, sdata);
+	auto hash_data = (hash_t *)hdata.data;
+	auto states = (approx_distinct_count_state_t **)sdata.data;
+	for (idx_t i = 0; i < count; i++) {
+		auto idx = idata.sel->get_index(i);
+		if ((*idata.nullmask)[idx]) {
+			continue;
+		}
+		ApproxCountDistinctAdd(states[sdata.sel->get_index(i)], hash_data[hdata.sel->get_index(i)]);
+	}
+}
+
+AggregateFunction ApproxCountDistinctFun::GetFunction() {
+	return AggregateFunction(
+	    {LogicalType(LogicalTypeId::ANY)}, LogicalType::BIGINT,
+	    AggregateFunction::StateSize<approx_distinct_count_state_t>,
+	    AggregateFunction::StateInitialize<approx_distinct_count_state_t, ApproxCountDistinctFunction>,
+	    ApproxCountDistinctUpdate,
+	    AggregateFunction::StateCombine<approx_distinct_count_state_t, ApproxCountDistinctFunction>,
+	    AggregateFunction::StateFinalize<approx_distinct_count_state_t, int64_t, ApproxCountDistinctFunction>,
+	    ApproxCountDistinctSimpleUpdate, nullptr,
+	    AggregateFunction::StateDestroy<approx_distinct_count_state_t, ApproxCountDistinctFunction>);
+}
+
+void ApproxCountDistinctFun::RegisterFunction(BuiltinFunctions &set) {
+	AggregateFunctionSet approx_count("approx_count_distinct");
+	approx_count.AddFunction(ApproxCountDistinctFun::GetFunction());
+	set.AddFunction(approx_count);
+}
+
+} // namespace duckdb
@@ -9,6 +9,8 @@ namespace duckdb {
 struct string_agg_state_t {
 	idx_t size;
 	idx_t alloc_size;
+	//! The size of the separator in front of the first string; it is kept so the state can be appended to another one
+	idx_t offset;
 	char *dataptr;
 };
 
@@ -17,6 +19,7 @@ struct StringAggBaseFunction {
 		state->dataptr = nullptr;
 		state->alloc_size = 0;
 		state->size = 0;
+		state->offset = 0;
 	}
 
 	template <class T, class STATE>
@@ -24,7 +27,7 @@ struct StringAggBaseFunction {
 		if (!state->dataptr) {
 			nullmask[idx] = true;
 		} else {
-			target[idx] = StringVector::AddString(result, state->dataptr, state->size);
+			target[idx] = StringVector::AddString(result, state->dataptr + state->offset, state->size - state->offset);
 		}
 	}
 
@@ -38,36 +41,51 @@ struct StringAggBaseFunction {
 		return true;
 	}
 
-	static inline void PerformOperation(string_agg_state_t *state, const char *str, const char *sep, idx_t str_size,
-	                                    idx_t sep_size) {
+	static inline void Reserve(string_agg_state_t *state, idx_t required_size) {
 		if (state->dataptr == nullptr) {
-			// first iteration: allocate space for the string and copy it into the state
-			state->alloc_size = MaxValue<idx_t>(8, NextPowerOfTwo(str_size));
+			state->alloc_size = MaxValue<idx_t>(8, NextPowerOfTwo(required_size));
 			state->dataptr = new char[state->alloc_size];
-			state->size = str_size;
-			memcpy(state->dataptr, str, str_size);
-		} else {
-			// subsequent iteration: first check if we have space to place the string and separator
-			idx_t required_size = state->size + str_size + sep_size;
-			if (required_size > state->alloc_size) {
-				// no space! allocate extra space
-				while (state->alloc_size < required_size) {
-					state->alloc_size *= 2;
-				}
-				auto new_data = new char[state->alloc_size];
-				memcpy(new_data, state->dataptr, state->size);
-				delete[] state->dataptr;
-				state->dataptr = new_data;
+		} else if (required_size > state->alloc_size) {
+			// no space! allocate extra space
+			while (state->alloc_size < required_size) {
+				state->alloc_size *= 2;
 			}
-			// copy the separator
-			memcpy(state->dataptr + state->size, sep, sep_size);
-			state->size += sep_size;
-			// copy the string
-			memcpy(state->dataptr + state->size, str, str_size);
-			state->size += str_size;
+			auto new_data = new char[state->alloc_size];
+			memcpy(new_data, state->dataptr, state->size);
+			delete[] state->dataptr;
+			state->dataptr = new_data;
 		}
 	}
 
+	static inline void PerformOperation(string_agg_state_t *state, const char *str, const char *sep, idx_t str_size,
+	                                    idx_t sep_size) {
+		if (state->dataptr == nullptr) {
+			// first iteration: the separator is placed in front of the string, but skipped when finalizing
+			state->offset = sep_size;
+		}
+		Reserve(state, state->size + str_size + sep_size);
+		// copy the separator
+		memcpy(state->dataptr + state->size, sep, sep_size);
+		state->size += sep_size;
+		// copy the string
+		memcpy(state->dataptr + state->size, str, str_size);
+		state->size += str_size;
+	}
+
+	template <class STATE, class OP> static void Combine(STATE source, STATE *target) {
+		if (source.dataptr == nullptr) {
+			// source is not set: skip combining
+			return;
+		}
+		// append the source, including its first separator, so the strings of the target stay in front
+		if (target->dataptr == nullptr) {
+			target->offset = source.offset;
+		}
+		Reserve(target, target->size + source.size);
+		memcpy(target->dataptr + target->size, source.dataptr, source.size);
+		target->size += source.size;
+	}
+
 	static inline void PerformOperation(string_agg_state_t *state, string_t str, string_t sep) {
 		PerformOperation(state, str.GetDataUnsafe(), sep.GetDataUnsafe(), str.GetSize(), sep.GetSize());
 	}
@@ -97,14 +115,6 @@ struct StringAggSingleFunction : public StringAggBaseFunction {
 			Operation<INPUT_TYPE, STATE, OP>(state, input, nullmask, 0);
 		}
 	}
-
-	template <class STATE, class OP> static void Combine(STATE source, STATE *target) {
-		if (source.dataptr == nullptr) {
-			// source is not set: skip combining
-			return;
-		}
-		PerformOperation(target, string_t(source.dataptr, source.size));
-	}
 };
 
 void StringAggFun::RegisterFunction(BuiltinFunctions &set) {
@@ -113,7 +123,8 @@ void StringAggFun::RegisterFunction(BuiltinFunctions &set) {
 	    {LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::VARCHAR,
 	    AggregateFunction::StateSize<string_agg_state_t>,
 	    AggregateFunction::StateInitialize<string_agg_state_t, StringAggFunction>,
-	    AggregateFunction::BinaryScatterUpdate<string_agg_state_t, string_t, string_t, StringAggFunction>, nullptr,
+	    AggregateFunction::BinaryScatterUpdate<string_agg_state_t, string_t, string_t, StringAggFunction>,
+	    AggregateFunction::StateCombine<string_agg_state_t, StringAggFunction>,
 	    AggregateFunction::StateFinalize<string_agg_state_t, string_t, StringAggFunction>,
 	    AggregateFunction::BinaryUpdate<string_agg_state_t, string_t, string_t, StringAggFunction>, nullptr,
 	    AggregateFunction::StateDestroy<string_agg_state_t, StringAggFunction>));
@@ -7,6 +7,7 @@
 namespace duckdb {
 
 void BuiltinFunctions::RegisterDistributiveAggregates() {
+	Register<ApproxCountDistinctFun>();
 	Register<BitAndFun>();
 	Register<BitOrFun>();
 	Register<BitXorFun>();
@@ -60,7 +60,10 @@ static void list_combine(Vector &state, Vector &combined, idx_t count) {
 
 	for (idx_t i = 0; i < count; i++) {
 		auto state = states_ptr[sdata.sel->get_index(i)];
-		D_ASSERT(state->cc);
+		if (!state->cc) {
+			// nothing to append
+			continue;
+		}
 		if (!combined_ptr[i]->cc) {
 			combined_ptr[i]->cc = new ChunkCollection();
 		}
@@ -23,6 +23,7 @@ enum class PhysicalOperatorType : uint8_t {
 	TOP_N,
 	AGGREGATE,
 	WINDOW,
+	STREAMING_WINDOW,
 	UNNEST,
 	SIMPLE_AGGREGATE,
 	HASH_GROUP_BY,
@@ -52,6 +53,7 @@ enum class PhysicalOperatorType : uint8_t {
 	HASH_JOIN,
 	CROSS_PRODUCT,
 	PIECEWISE_MERGE_JOIN,
+	IE_JOIN,
 	DELIM_JOIN,
 	INDEX_JOIN,
 	// -----------------------------
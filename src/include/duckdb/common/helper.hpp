@@ -49,4 +49,28 @@ template <typename T> void Store(const T val, data_ptr_t ptr) {
 	memcpy(ptr, (void *)&val, sizeof(val));
 }
 
+//! Hints the CPU to load the cache line that holds the given address, so that the memory access latency of a later
+//! access to it can overlap with other work
+inline void Prefetch(const void *ptr) {
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(ptr);
+#else
+	(void)ptr;
+#endif
+}
+
+//! Returns the index of the lowest set bit of a non-zero value
+inline idx_t CountTrailingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(value);
+#else
+	idx_t result = 0;
+	while (!(value & 1)) {
+		value >>= 1;
+		result++;
+	}
+	return result;
+#endif
+}
+
 } // namespace duckdb
@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// duckdb/common/types/hyperloglog.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "duckdb/common/common.hpp"
+
+namespace duckdb {
+class Serializer;
+class Deserializer;
+
+//! A HyperLogLog sketch that estimates the amount of distinct hashes that were added to it. The sketch starts out
+//! sparse, only keeping the registers that were set, and switches to an array of all registers once that takes up
+//! less space.
+class HyperLogLog {
+public:
+	HyperLogLog();
+
+	//! The amount of bits of the hash that select the register
+	static constexpr idx_t PRECISION = 12;
+	//! The amount of registers (the standard error of the estimate is 1.04 / sqrt(REGISTER_COUNT), i.e. 1.6%)
+	static constexpr idx_t REGISTER_COUNT = idx_t(1) << PRECISION;
+	//! The maximum amount of registers in the sparse representation
+	static constexpr idx_t MAX_SPARSE_ENTRIES = REGISTER_COUNT / 8;
+
+public:
+	//! Add a hash to the sketch
+	void Add(hash_t hash);
+	//! Merge another sketch into this one
+	void Merge(const HyperLogLog &other);
+	//! Estimate the amount of distinct hashes that were added to the sketch
+	idx_t Count() const;
+
+	void Serialize(Serializer &serializer) const;
+	static unique_ptr<HyperLogLog> Deserialize(Deserializer &source);
+
+	bool IsSparse() const {
+		return registers.empty();
+	}
+	//! Switch to the array of all registers, to which hashes are added faster than to the sparse entries
+	void ToDense();
+
+private:
+	//! The registers that were set while the sketch is sparse, each entry is (register index << 8 | register value).
+	//! New entries are appended, and the entries are only sorted and deduplicated once the buffer is full.
+	vector<uint32_t> sparse_entries;
+	//! All registers (empty while the sketch is sparse)
+	vector<uint8_t> registers;
+
+private:
+	void AddToRegister(uint32_t index, uint8_t value);
+	//! Sort the sparse entries, keeping only the maximum value of each register, and switch to the dense
+	//! representation if there are too many registers
+	void CompactSparse();
+};
+
+} // namespace duckdb
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// duckdb/common/types/sort_key.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "duckdb/common/enums/order_type.hpp"
+#include "duckdb/common/types/data_chunk.hpp"
+
+namespace duckdb {
+
+//! The SortKeyEncoder encodes a set of sort columns into fixed-width keys that can be compared with memcmp. Every
+//! column is encoded as a NULL byte followed by the big-endian, sign-flipped value, and the bytes of a column are
+//! inverted for descending orders. Strings are encoded as a fixed-length prefix: when the prefixes of two keys are
+//! equal the full strings have to be compared as a tie-breaker.
+class SortKeyEncoder {
+public:
+	SortKeyEncoder(vector<LogicalType> types, vector<OrderType> order_types, vector<OrderByNullType> null_orders);
+
+	//! The amount of bytes of the string prefix that is stored in the key
+	static constexpr idx_t STRING_PREFIX_LENGTH = 12;
+	//! The maximum key width for which keys are radix sorted
+	static constexpr idx_t RADIX_SORT_MAX_KEY_WIDTH = 16;
+	//! The minimum amount of keys for which keys are radix sorted
+	static constexpr idx_t RADIX_SORT_THRESHOLD = 64;
+
+	//! The types of the sort columns
+	vector<LogicalType> types;
+	vector<OrderType> order_types;
+	vector<OrderByNullType> null_orders;
+	//! The width of a single encoded key in bytes
+	idx_t key_width;
+
+public:
+	//! Encode the first types.size() columns of the chunk, key i is written to target + i * stride
+	void Encode(DataChunk &chunk, data_ptr_t target, idx_t stride);
+	//! Encode a single vector as the sort column col_idx
+	void EncodeColumn(Vector &vector, idx_t count, idx_t col_idx, data_ptr_t target, idx_t stride);
+
+	//! Whether or not equal key prefixes have to be resolved by comparing the original values
+	bool HasTieBreaker() const {
+		return !tie_columns.empty();
+	}
+
+	//! Returns the amount of leading key bytes that are decisive: if they compare unequal with memcmp, the rows they
+	//! were encoded from compare the same way
+	idx_t GetDecisiveWidth() const {
+		if (tie_columns.empty()) {
+			return key_width;
+		}
+		// the key up to and including the encoding of the first column that needs a tie-breaker
+		auto next_column = tie_columns[0] + 1;
+		return next_column < offsets.size() ? offsets[next_column] : key_width;
+	}
+
+	//! Sorts the row indices in result by their keys, the key of row i is stored at keys + i * key_width. Keys that
+	//! are at most RADIX_SORT_MAX_KEY_WIDTH bytes wide are radix sorted. Can only be used if there is no tie-breaker.
+	void SortKeys(const_data_ptr_t keys, idx_t result[], idx_t count);
+
+	//! Orrify the sort columns of the chunk that are compared if the keys are not decisive. The result can be passed
+	//! to Compare for any row of the chunk, as long as the chunk is not modified.
+	void OrrifyTieColumns(DataChunk &chunk, vector<VectorData> &result);
+
+	//! Compares two encoded keys. If the keys are not decided by their encoding, the original values of the sort
+	//! columns (i.e. row left_idx of left_data and row right_idx of right_data, see OrrifyTieColumns) are compared.
+	inline int Compare(const_data_ptr_t left, const_data_ptr_t right, vector<VectorData> &left_data, idx_t left_idx,
+	                   vector<VectorData> &right_data, idx_t right_idx) {
+		if (tie_columns.empty()) {
+			return memcmp(left, right, key_width);
+		}
+		return CompareWithTieBreaker(left, right, left_data, left_idx, right_data, right_idx);
+	}
+
+private:
+	int CompareWithTieBreaker(const_data_ptr_t left, const_data_ptr_t right, vector<VectorData> &left_data,
+	                          idx_t left_idx, vector<VectorData> &right_data, idx_t right_idx);
+
+private:
+	//! The byte offset of each column within the key
+	vector<idx_t> offsets;
+	//! The columns whose encoding is not decisive, in key order
+	vector<idx_t> tie_columns;
+};
+
+} // namespace duckdb
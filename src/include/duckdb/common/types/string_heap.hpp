@@ -22,13 +22,16 @@ public:
 	void Destroy() {
 		tail = nullptr;
 		chunk = nullptr;
+		allocated_size = 0;
 	}
 
 	void Move(StringHeap &other) {
 		D_ASSERT(!other.chunk);
 		other.tail = tail;
 		other.chunk = move(chunk);
+		other.allocated_size = allocated_size;
 		tail = nullptr;
+		allocated_size = 0;
 	}
 
 	//! Add a string to the string heap, returns a pointer to the string
@@ -45,6 +48,10 @@ public:
 	string_t EmptyString(idx_t len);
 	//! Add all strings from a different string heap to this string heap
 	void MergeHeap(StringHeap &heap);
+	//! The amount of memory allocated by the string heap
+	idx_t SizeInBytes() const {
+		return allocated_size;
+	}
 
 private:
 	struct StringChunk {
@@ -67,6 +74,8 @@ private:
 	};
 	StringChunk *tail;
 	unique_ptr<StringChunk> chunk;
+	//! The total size of the chunks
+	idx_t allocated_size;
 };
 
 } // namespace duckdb
@@ -68,11 +68,20 @@ public:
 	//! computed but instead just assigned.
 	idx_t AddChunk(DataChunk &groups, DataChunk &payload);
 	idx_t AddChunk(DataChunk &groups, Vector &group_hashes, DataChunk &payload);
+	//! Add every row as a separate group, without looking up whether or not the group already exists. The groups are
+	//! only aggregated once this HT is combined into (or partitioned into) another HT: no more groups can be looked up
+	//! in this HT. Not supported for DISTINCT aggregates. Returns the amount of rows added.
+	idx_t AppendRows(DataChunk &groups, Vector &group_hashes, DataChunk &payload);
 
 	//! Scan the HT starting from the scan_position until the result and group
 	//! chunks are filled. scan_position will be updated by this function.
 	//! Returns the amount of elements found.
 	idx_t Scan(idx_t &scan_position, DataChunk &result);
+	//! Pin the block that holds the group at the given scan position, regardless of whether or not the HT is pinned
+	unique_ptr<BufferHandle> PinBlock(idx_t scan_position);
+	//! Scan the groups in [scan_position, scan_end) of a single block that was pinned with PinBlock. Unlike Scan, this
+	//! can be called by multiple threads at the same time.
+	idx_t ScanBlock(BufferHandle &block, idx_t &scan_position, idx_t scan_end, DataChunk &result);
 
 	//! Fetch the aggregates for specific groups from the HT and place them in the result
 	void FetchAggregates(DataChunk &groups, DataChunk &result);
@@ -86,6 +95,9 @@ public:
 	void FindOrCreateGroups(DataChunk &groups, Vector &addresses_out);
 
 	void Combine(GroupedAggregateHashTable &other);
+	//! Combines the given aggregate states into the states of the given groups, creating the groups if they do not
+	//! exist yet. The source states are not modified, but the source_addresses vector is.
+	void CombineStates(DataChunk &groups, Vector &source_addresses);
 
 	idx_t Size() {
 		return entries;
@@ -97,6 +109,24 @@ public:
 
 	void Finalize();
 
+	//! Unpin the payload of a finalized HT so the buffer manager can spill it to disk
+	void Unpin();
+	//! Pin the payload of the HT again; this is required before the HT can be combined, partitioned or scanned
+	void Pin();
+	//! The (approximate) size in bytes of a single group in the HT
+	idx_t TupleSize() {
+		return tuple_size;
+	}
+	//! The amount of groups that are stored in a single block of the HT
+	idx_t TuplesPerBlock() {
+		return tuples_per_block;
+	}
+	//! The amount of memory in bytes held by the HT: its pinned payload blocks, its hashes and its string heap
+	idx_t SizeInBytes();
+	bool IsFinalized() {
+		return is_finalized;
+	}
+
 	//! The stringheap of the AggregateHashTable
 	StringHeap string_heap;
 
@@ -117,6 +147,8 @@ private:
 	//! The amount of entries stored in the HT currently
 	idx_t entries;
 	//! The data of the HT
+	vector<shared_ptr<BlockHandle>> payload_blocks;
+	//! The pins of the payload blocks; empty while the HT is unpinned
 	vector<unique_ptr<BufferHandle>> payload_hds;
 	vector<data_ptr_t> payload_hds_ptrs;
 
@@ -137,6 +169,8 @@ private:
 	vector<unique_ptr<GroupedAggregateHashTable>> distinct_hashes;
 
 	bool is_finalized;
+	//! Whether or not rows were appended with AppendRows, i.e. the same group might occur multiple times
+	bool has_duplicate_groups;
 
 	// some stuff from FindOrCreateGroupsInternal() to avoid allocation there
 	Vector ht_offsets;
@@ -156,8 +190,17 @@ private:
 
 	void Verify();
 
-	void FlushMove(Vector &source_addresses, Vector &source_hashes, idx_t count);
+	//! Move the groups at the source addresses into this HT, combining their states. The states of distinct aggregates
+	//! are left untouched if skip_distinct is set
+	void FlushMove(Vector &source_addresses, Vector &source_hashes, idx_t count, bool skip_distinct = false);
+	//! Update the distinct aggregate with the values that the other HT has seen, but this HT has not
+	void CombineDistinct(GroupedAggregateHashTable &other, idx_t aggr_idx, idx_t payload_idx, idx_t state_offset);
+	//! Move the distinct values of the aggregate into the partition HTs of their groups
+	void PartitionDistinct(vector<GroupedAggregateHashTable *> &partition_hts, idx_t aggr_idx, hash_t mask,
+	                       idx_t shift);
 	void NewBlock();
+	//! Gather the groups at the given addresses and finalize their aggregates into the result
+	void FetchScanResult(Vector &group_addresses, DataChunk &result);
 
 	template <class T> void VerifyInternal();
 	template <class T> void Resize(idx_t size);
@@ -99,8 +99,10 @@ public:
 	bool Insert(IndexLock &lock, DataChunk &data, Vector &row_ids) override;
 
 	bool SearchEqual(ARTIndexScanState *state, idx_t max_count, vector<row_t> &result_ids);
-	//! Search Equal used for Joins that do not need to fetch data
-	void SearchEqualJoinNoFetch(Value &equal_value, idx_t &result_size);
+	//! Search Equal used for Joins: looks up all keys of the input at once and sets result[i] to the leaf of the i-th
+	//! key, or to nullptr if the key is NULL or not found. The keys are looked up in sorted order, so every lookup only
+	//! descends from the deepest node on the path of the previous key that shares its prefix.
+	void SearchEqualJoin(DataChunk &input, Leaf *result[]);
 
 private:
 	DataChunk expression_result;
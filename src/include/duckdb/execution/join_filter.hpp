@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// duckdb/execution/join_filter.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "duckdb/common/common.hpp"
+#include "duckdb/common/types/selection_vector.hpp"
+#include "duckdb/common/types/value.hpp"
+
+namespace duckdb {
+struct TableFilterSet;
+class Vector;
+
+//! A JoinFilter is a filter on a column of a table scan on the probe side of a hash join, that only becomes known once
+//! the build side of the join has been finalized. It consists of the range of the build keys, with which the scan
+//! skips segments using their zonemaps, and of a blocked Bloom filter over the build keys, with which the scan prunes
+//! the rows that cannot find a match in the HT before it fetches the other columns.
+class JoinFilter {
+public:
+	JoinFilter(idx_t key_index, idx_t column_index, LogicalType type);
+
+	//! The index of the join condition the filter is computed for
+	idx_t key_index;
+	//! The index of the filtered column in the column_ids of the scan
+	idx_t column_index;
+	//! The type of the keys
+	LogicalType type;
+	//! Whether or not the filter has been computed in the current execution of the join
+	bool published;
+	//! The smallest build key
+	Value min;
+	//! The largest build key
+	Value max;
+
+	//! The amount of bits in the Bloom filter per build key
+	static constexpr idx_t BLOOM_BITS_PER_KEY = 16;
+
+public:
+	//! Whether or not join filters can be computed for keys of the given type
+	static bool SupportsType(const LogicalType &type);
+
+	//! Resets the filter, it is not applied until it is published again
+	void Reset();
+	//! Allocates an empty Bloom filter for the given amount of keys
+	void InitializeBloomFilter(idx_t count);
+	//! Inserts the hashes of a set of build keys into the Bloom filter
+	void InsertHashes(hash_t hashes[], idx_t count);
+	//! Publishes the filter with the range of the build keys
+	void Publish(Value min, Value max);
+
+	//! Adds the filter to a set of table filters, if it has been published
+	void Apply(TableFilterSet &table_filters);
+	//! Removes the rows of which the key cannot be found in the Bloom filter from the selection and returns the
+	//! remaining amount of rows. The keys are read from the flat input vector at the positions in the selection.
+	idx_t Select(Vector &input, SelectionVector &sel, idx_t count);
+
+private:
+	//! The blocks of the Bloom filter, every key sets BLOOM_HASH_COUNT bits in a single block
+	vector<uint64_t> bloom_blocks;
+	//! Bitmask to get the block of a key from its hash
+	hash_t bloom_mask;
+
+	//! The amount of bits a key sets in its block
+	static constexpr idx_t BLOOM_HASH_COUNT = 4;
+
+	//! Scrambles a hash, the blocks and the bits within the blocks are taken from independent bits of the result
+	static inline hash_t BloomHash(hash_t hash) {
+		hash ^= hash >> 33;
+		hash *= UINT64_C(0xff51afd7ed558ccd);
+		hash ^= hash >> 33;
+		hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+		hash ^= hash >> 33;
+		return hash;
+	}
+	//! The bits a key with the given (scrambled) hash sets in its block
+	static inline uint64_t BloomBits(hash_t hash) {
+		uint64_t bits = 0;
+		for (idx_t i = 0; i < BLOOM_HASH_COUNT; i++) {
+			bits |= uint64_t(1) << ((hash >> (40 + i * 6)) & 63);
+		}
+		return bits;
+	}
+
+	template <class T> idx_t TemplatedSelect(Vector &input, SelectionVector &sel, idx_t count);
+};
+
+} // namespace duckdb
@@ -10,6 +10,7 @@
 
 #include "duckdb/common/common.hpp"
 #include "duckdb/common/types/data_chunk.hpp"
+#include "duckdb/common/types/hash.hpp"
 #include "duckdb/common/types/vector.hpp"
 #include "duckdb/execution/aggregate_hashtable.hpp"
 #include "duckdb/planner/operator/logical_comparison_join.hpp"
@@ -18,13 +19,16 @@
 namespace duckdb {
 class BufferManager;
 class BufferHandle;
+class JoinFilter;
 
 struct JoinHTScanState {
-	JoinHTScanState() : position(0), block_position(0) {
+	JoinHTScanState() : position(0), block_position(0), block_end(INVALID_INDEX) {
 	}
 
 	idx_t position;
 	idx_t block_position;
+	//! The scan stops at this block (the scan covers all blocks if this is INVALID_INDEX)
+	idx_t block_end;
 };
 
 //! JoinHashTable is a linear probing HT that is used for computing joins
@@ -39,6 +43,9 @@ struct JoinHTScanState {
    [POINTER]
    [POINTER]
    The pointers are either NULL
+   On 64-bit platforms, the unused upper 16 bits of the pointers in the hash map and of the next pointers hold a tag:
+   a tiny Bloom filter of the hashes of the entries in the chain that the pointer starts. A probe whose hash is not in
+   the tag can skip the (rest of the) chain without touching the entries.
 */
 class JoinHashTable {
 public:
@@ -53,6 +60,9 @@ public:
 		SelectionVector sel_vector;
 		// whether or not the given tuple has found a match
 		unique_ptr<bool[]> found_match;
+		// the tag of the hash of every tuple, chains of which the tag does not contain it are skipped. nullptr if the
+		// pointers of the HT are not tagged
+		unique_ptr<uintptr_t[]> tags;
 		JoinHashTable &ht;
 		bool finished;
 
@@ -60,6 +70,9 @@ public:
 		//! Get the next batch of data from the scan structure
 		void Next(DataChunk &keys, DataChunk &left, DataChunk &result);
 
+		//! Prefetches the entries that the pointers currently point to
+		void PrefetchEntries();
+
 	private:
 		void AdvancePointers();
 		void AdvancePointers(const SelectionVector &sel, idx_t sel_count);
@@ -126,13 +139,48 @@ public:
 
 	//! Add the given data to the HT
 	void Build(DataChunk &keys, DataChunk &input);
+	//! Merge the blocks of a thread-local HT into this HT, after this the other HT is empty
+	void Merge(JoinHashTable &other);
 	//! Finalize the build of the HT, constructing the actual hash table and making the HT ready for probing. Finalize
 	//! must be called before any call to Probe, and after Finalize is called Build should no longer be ever called.
 	void Finalize();
+	//! Finalize the build of the HT as a perfect hash table over the keys in the range [min, min + range): the hash map
+	//! is then indexed directly by the key, so that probing does not require hashing or comparing the keys. This is only
+	//! possible for a single integer equality condition with unique keys, if this is not the case (or the hash map is
+	//! too large) the HT is left untouched and false is returned. The hash map is complete once this returns true.
+	bool TryFinalizePerfect(int64_t min, idx_t range);
+	//! Finalize the build of the HT in parallel. PrepareFinalize pins the blocks and allocates the hash map, after
+	//! which InsertPinnedBlocks has to be called for every pinned block. The blocks can be divided over threads.
+	void PrepareFinalize();
+	void InsertPinnedBlocks(idx_t begin, idx_t end, bool parallel);
+	//! The amount of blocks that are currently pinned
+	idx_t PinnedBlockCount() {
+		return pinned_handles.size();
+	}
 	//! Probe the HT with the given input chunk, resulting in the given result
 	unique_ptr<ScanStructure> Probe(DataChunk &keys);
 	//! Scan the HT to construct the final full outer join result after
 	void ScanFullOuter(DataChunk &result, JoinHTScanState &state);
+	//! The amount of blocks holding the entries of the HT
+	idx_t BlockCount() {
+		return blocks.size();
+	}
+	//! Scans the entries of the HT starting from the current position, gathering the condition keys of the entries into
+	//! keys and the build columns into payload. This does not require the HT to be finalized.
+	void ScanEntries(JoinHTScanState &state, DataChunk &keys, DataChunk &payload);
+	//! Computes the given join filter from the keys stored in the HT and publishes it. The filter is not published if
+	//! the HT is empty.
+	void BuildJoinFilter(JoinFilter &filter);
+
+	//! Computes the partition group of every row of the given keys (external HT only)
+	void ComputeGroups(DataChunk &keys, idx_t groups[]);
+	//! Unpins the current partition group and pins the next one, returns false if there are no groups left (external
+	//! HT only)
+	bool LoadNextGroup();
+	//! The amount of partition groups of an external HT
+	idx_t GroupCount() {
+		return group_partitions.size() - 1;
+	}
 
 	idx_t size() {
 		return count;
@@ -168,6 +216,24 @@ public:
 	bool finalized;
 	//! Whether or not any of the key elements contain NULL
 	bool has_null;
+	//! Whether or not the HT did not fit in memory when it was finalized. The entries of an external HT are radix
+	//! partitioned on their hashes, and the partitions are divided into groups that each fit in memory. Only a single
+	//! group is pinned at a time, and only keys of that group can be probed.
+	bool external;
+	//! Whether or not the probe prefetches the buckets and entries it accesses, this is only done if the pinned part of
+	//! the HT is too large to be cached
+	bool prefetch;
+	//! Whether or not the pointers in the hash map and the next pointers are tagged, this is only done if the addresses
+	//! of all pinned blocks fit in the bits of POINTER_MASK
+	bool tag_pointers;
+	//! Whether or not the HT has been finalized as a perfect hash table
+	bool perfect;
+	//! The smallest key of a perfect HT, the hash map holds the entry of key k at position (k - perfect_min)
+	int64_t perfect_min;
+	//! The amount of positions in the hash map of a perfect HT
+	idx_t perfect_range;
+	//! The partition group that is currently pinned (external HT only)
+	idx_t current_group;
 	//! Bitmask for getting relevant bits from the hashes to determine the position
 	uint64_t bitmask;
 	//! The amount of entries stored per block
@@ -191,12 +257,11 @@ public:
 	} correlated_mark_join_info;
 
 private:
-	//! Apply a bitmask to the hashes
-	void ApplyBitmask(Vector &hashes, idx_t count);
-	void ApplyBitmask(Vector &hashes, const SelectionVector &sel, idx_t count, Vector &pointers);
+	//! Apply a bitmask to the hashes to get the positions in the hash map, and compute the tags of the hashes
+	void ApplyBitmask(Vector &hashes, const SelectionVector &sel, idx_t count, Vector &pointers, uintptr_t tags[]);
 	//! Insert the given set of locations into the HT with the given set of
-	//! hashes. Caller should hold lock in parallel HT.
-	void InsertHashes(Vector &hashes, idx_t count, data_ptr_t key_locations[]);
+	//! hashes. If parallel is set the hash map is updated with atomic operations.
+	void InsertHashes(Vector &hashes, idx_t count, data_ptr_t key_locations[], bool parallel);
 
 	idx_t PrepareKeys(DataChunk &keys, unique_ptr<VectorData[]> &key_data, const SelectionVector *&current_sel,
 	                  SelectionVector &sel, bool build_side);
@@ -204,12 +269,84 @@ private:
 	                         data_ptr_t key_locations[]);
 	void SerializeVector(Vector &v, idx_t vcount, const SelectionVector &sel, idx_t count, data_ptr_t key_locations[]);
 
+	//! Returns the capacity of the hash map for the given amount of entries
+	static idx_t HashMapCapacity(idx_t count);
+	//! Returns the amount of memory the pinned blocks and the hash map may use together
+	idx_t MemoryBudget();
+	//! Pins the blocks in the range [block_begin, block_end) and allocates an empty hash map with the given capacity.
+	//! Any previously pinned blocks are unpinned.
+	void InitializeHashMap(idx_t block_begin, idx_t block_end, idx_t capacity);
+	//! Inserts the entries of the pinned blocks into the hash map of a perfect HT, returns false if a key is out of
+	//! range or not unique
+	template <class T> bool TemplatedInsertPerfect();
+	//! Looks up the entries of the given keys in the hash map of a perfect HT, the rows that have an entry are written
+	//! to result_sel and their amount is returned
+	template <class T>
+	idx_t TemplatedProbePerfect(VectorData &key_data, const SelectionVector &sel, idx_t count, data_ptr_t pointers[],
+	                            SelectionVector &result_sel);
+	//! Radix partitions the entries of the HT on the upper radix_bits of their hashes
+	void PartitionBlocks();
+	//! Appends a set of entries to the blocks of a partition
+	void AppendEntries(vector<HTDataBlock> &partition, data_ptr_t entries[], idx_t count);
+	//! Pins the given partition group and allocates its hash map
+	void LoadGroup(idx_t group);
+	template <class T> void TemplatedBuildJoinFilter(JoinFilter &filter, idx_t key_offset);
+
+	//! Whether or not the pointers in the hash map and the next pointers can be tagged on this platform
+	static constexpr bool POINTER_TAGGING = sizeof(uintptr_t) == 8;
+	//! The bits of a tagged pointer that hold the address
+	static constexpr uintptr_t POINTER_MASK = ~uintptr_t(0) >> 16;
+
+public:
+	//! Returns the tag of a hash: every hash sets one of the upper 16 bits of a pointer
+	static inline uintptr_t HashTag(hash_t hash) {
+		// the upper bits of some hash functions (e.g. of short strings) are hardly used: scramble them first
+		return POINTER_TAGGING ? uintptr_t(1) << (48 + (murmurhash64(hash) >> 60)) : 0;
+	}
+	//! Returns the pointer that a tagged pointer points to if the hash with the given tag can be found in the chain it
+	//! starts, and nullptr otherwise
+	static inline data_ptr_t FollowPointer(uintptr_t tagged_pointer, uintptr_t tag) {
+		return (tagged_pointer & tag) ? (data_ptr_t)(tagged_pointer & POINTER_MASK) : nullptr;
+	}
+
+private:
+	//! Returns the pointer to a new chain head: if the pointers are tagged, the tag of the chain is that of the head and
+	//! the rest of it
+	inline uintptr_t TagPointer(data_ptr_t head, uintptr_t next, hash_t hash) {
+		if (!tag_pointers) {
+			return (uintptr_t)head;
+		}
+		D_ASSERT(((uintptr_t)head & ~POINTER_MASK) == 0);
+		return (uintptr_t)head | (next & ~POINTER_MASK) | HashTag(hash);
+	}
+
+	inline idx_t GetPartition(hash_t hash) {
+		// the upper bits of some hash functions (e.g. of short strings) are hardly used: scramble them first
+		return murmurhash64(hash) >> (sizeof(hash_t) * 8 - radix_bits);
+	}
+
 	//! The amount of entries stored in the HT currently
 	idx_t count;
 	//! The blocks holding the main data of the hash table
 	vector<HTDataBlock> blocks;
-	//! Pinned handles, these are pinned during finalization only
+	//! The pinned blocks that the hash map points into
 	vector<unique_ptr<BufferHandle>> pinned_handles;
+	//! The index of the block that pinned_handles[0] belongs to
+	idx_t pinned_block_begin;
+	//! The size of the pinned blocks and the hash map above which the probe prefetches
+	static constexpr idx_t PREFETCH_THRESHOLD = 32 * 1024 * 1024;
+	//! The maximum amount of radix bits the entries of an external HT are partitioned on
+	static constexpr idx_t MAX_RADIX_BITS = 8;
+	//! The amount of radix bits the entries of an external HT are partitioned on
+	idx_t radix_bits;
+	//! The blocks of partition p are blocks[partition_blocks[p]] up to blocks[partition_blocks[p + 1]]
+	vector<idx_t> partition_blocks;
+	//! The amount of entries in every partition
+	vector<idx_t> partition_counts;
+	//! The group every partition belongs to
+	vector<idx_t> partition_groups;
+	//! The partitions of group g are group_partitions[g] up to group_partitions[g + 1]
+	vector<idx_t> group_partitions;
 	//! The hash map of the HT, created after finalization
 	unique_ptr<BufferHandle> hash_map;
 	//! Whether or not NULL values are considered equal in each of the comparisons
@@ -15,6 +15,9 @@ namespace duckdb {
 
 class ClientContext;
 class BufferManager;
+class GroupedAggregateHashTable;
+class PhysicalHashAggregateState;
+struct ParallelState;
 
 //! PhysicalHashAggregate is an group-by and aggregate implementation that uses
 //! a hash table to perform the grouping
@@ -48,12 +51,19 @@ public:
 	//! Pointers to the aggregates
 	vector<BoundAggregateExpression *> bindings;
 
+	//! The estimated amount of input tuples, which is an upper bound for the amount of groups. If the groups are not
+	//! expected to fit in memory, the HTs are partitioned so they can be spilled and finalized one partition at a time
+	idx_t estimated_cardinality;
+
 public:
 	void Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input) override;
 	void Combine(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate) override;
 	void Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> gstate) override;
 
 	void FinalizeImmediate(ClientContext &context, unique_ptr<GlobalOperatorState> gstate);
+	//! Add an HT with (partially) aggregated groups to the global state before it is finalized, as if it was built by
+	//! one of the threads
+	void CombineHT(ClientContext &context, GlobalOperatorState &gstate, unique_ptr<GroupedAggregateHashTable> ht);
 
 	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) override;
 	unique_ptr<GlobalOperatorState> GetGlobalState(ClientContext &context) override;
@@ -63,6 +73,14 @@ public:
 
 	string ParamsToString() const override;
 
+	//! The estimated size in bytes of a single group in the HTs
+	idx_t EstimatedTupleSize();
+
+	//! The state shared by the threads that scan the finalized HTs in parallel, one block of groups at a time
+	unique_ptr<ParallelState> GetParallelState();
+	//! The amount of threads that can scan the finalized HTs in parallel
+	idx_t MaxThreads(ClientContext &context);
+
 private:
 	//! how many groups can we have in the operator before we switch to radix partitioning
 	idx_t radix_limit;
@@ -71,6 +89,8 @@ private:
 	void FinalizeInternal(ClientContext &context, unique_ptr<GlobalOperatorState> gstate, bool immediate,
 	                      Pipeline *pipeline);
 	bool ForceSingleHT(GlobalOperatorState &state);
+	//! Scan the next groups of the block assigned to this thread, fetching a new block if it has been scanned
+	idx_t ScanParallel(PhysicalHashAggregateState &state, ParallelState &parallel_state);
 };
 
 } // namespace duckdb
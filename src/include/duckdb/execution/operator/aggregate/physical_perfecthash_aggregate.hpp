@@ -10,12 +10,16 @@
 
 #include "duckdb/execution/physical_sink.hpp"
 #include "duckdb/execution/base_aggregate_hashtable.hpp"
+#include "duckdb/execution/operator/aggregate/physical_hash_aggregate.hpp"
 
 namespace duckdb {
 class ClientContext;
 class PerfectAggregateHashTable;
 
-//! PhysicalPerfectHashAggregate performs a group-by and aggregation using a perfect hash table
+//! PhysicalPerfectHashAggregate performs a group-by and aggregation using a perfect hash table. Integer groups are
+//! placed by their offset from the minimum value, string groups by their id in a dictionary that is built while the
+//! query runs. Once the dictionary of a string group is full, rows with unseen strings are aggregated by a regular
+//! hash aggregate instead.
 class PhysicalPerfectHashAggregate : public PhysicalSink {
 public:
 	PhysicalPerfectHashAggregate(ClientContext &context, vector<LogicalType> types,
@@ -34,6 +38,8 @@ public:
 	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) override;
 	unique_ptr<GlobalOperatorState> GetGlobalState(ClientContext &context) override;
 
+	void Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> gstate) override;
+
 	void GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
 	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
 
@@ -45,6 +51,12 @@ public:
 public:
 	//! The group types
 	vector<LogicalType> group_types;
+	//! The group types stored in the perfect HT: dictionary encoded groups are stored as their (INTEGER) id
+	vector<LogicalType> ht_group_types;
+	//! Whether or not each of the groups is a string that is dictionary encoded
+	vector<bool> dictionary_encoded;
+	//! Whether or not any of the groups is dictionary encoded
+	bool has_dictionary_groups;
 	//! The payload types
 	vector<LogicalType> payload_types;
 	//! The aggregates to be computed
@@ -53,6 +65,25 @@ public:
 	vector<Value> group_minima;
 	//! The number of bits we need to completely cover each of the groups
 	vector<idx_t> required_bits;
+	//! The hash aggregate that aggregates the rows with strings that do not fit in the dictionaries (if there are
+	//! dictionary encoded groups)
+	unique_ptr<PhysicalHashAggregate> overflow_aggregate;
+
+	//! The amount of rows after the first overflowing row after which the share of overflowing rows is evaluated
+	static constexpr idx_t OVERFLOW_SAMPLE_SIZE = STANDARD_VECTOR_SIZE * 16;
+	//! If at least this fraction of the sampled rows overflowed, the dictionaries are no longer used and all rows are
+	//! aggregated by the overflow aggregate
+	static constexpr double OVERFLOW_SKIP_RATIO = 0.5;
+
+private:
+	//! Replace the strings of a dictionary encoded group by their dictionary ids, adding the strings that are not in
+	//! the dictionary yet. Rows with a string that does not fit in the dictionary are marked in row_overflows.
+	void EncodeDictionaryGroup(GlobalOperatorState &state, LocalSinkState &lstate, idx_t group_idx, idx_t count,
+	                           bool row_overflows[]);
+	//! Aggregate the rows of the input chunk with the overflow aggregate
+	void SinkOverflow(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input);
+	//! Place the groups of the HT in the result, replacing the dictionary ids by their strings
+	void DecodeGroups(GlobalOperatorState &state, DataChunk &ht_groups, DataChunk &result, idx_t count);
 };
 
 } // namespace duckdb
@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// duckdb/execution/operator/aggregate/physical_streaming_window.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "duckdb/execution/physical_operator.hpp"
+
+namespace duckdb {
+class BoundWindowExpression;
+
+//! PhysicalStreamingWindow computes window functions over input that is already ordered on the PARTITION BY and ORDER
+//! BY keys of every window expression. The input is processed chunk by chunk in order, so unlike the PhysicalWindow
+//! the operator does not materialize its input. Only window functions that depend on the preceding rows of their
+//! partition can be computed this way.
+class PhysicalStreamingWindow : public PhysicalOperator {
+public:
+	PhysicalStreamingWindow(vector<LogicalType> types, vector<unique_ptr<Expression>> select_list);
+
+	//! The window expressions, the results are appended to the columns of the input
+	vector<unique_ptr<Expression>> select_list;
+
+public:
+	void GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
+	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
+
+	string ParamsToString() const override;
+
+	//! Whether or not the window expression only depends on the current and preceding rows of its partition, and can
+	//! therefore be computed by a PhysicalStreamingWindow
+	static bool IsStreamable(BoundWindowExpression &wexpr);
+};
+
+} // namespace duckdb
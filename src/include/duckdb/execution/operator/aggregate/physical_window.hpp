@@ -9,11 +9,13 @@
 #pragma once
 
 #include "duckdb/common/types/chunk_collection.hpp"
+#include "duckdb/common/types/hash.hpp"
 #include "duckdb/execution/physical_sink.hpp"
 
 namespace duckdb {
 
-//! PhysicalWindow implements window functions
+//! PhysicalWindow implements window functions. If all window expressions share the same PARTITION BY keys, the input
+//! is radix-partitioned on the hash of these keys and the partitions are computed in parallel.
 class PhysicalWindow : public PhysicalSink {
 public:
 	PhysicalWindow(vector<LogicalType> types, vector<unique_ptr<Expression>> select_list,
@@ -35,6 +37,17 @@ public:
 public:
 	//! The projection list of the WINDOW statement (may contain aggregates)
 	vector<unique_ptr<Expression>> select_list;
+	//! Whether or not the input is hash-partitioned on the PARTITION BY keys
+	bool is_partitioned;
+
+	//! The amount of radix bits used to partition the input
+	static constexpr idx_t WINDOW_RADIX_BITS = 4;
+
+	//! Returns the partition that a row with the given hash of its PARTITION BY keys belongs to
+	static inline idx_t GetPartition(hash_t hash) {
+		// the upper bits of some hash functions (e.g. of short strings) are hardly used: scramble them first
+		return murmurhash64(hash) >> (sizeof(hash_t) * 8 - WINDOW_RADIX_BITS);
+	}
 };
 
 } // namespace duckdb
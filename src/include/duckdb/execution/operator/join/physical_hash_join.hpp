@@ -9,9 +9,11 @@
 #pragma once
 
 #include "duckdb/common/types/chunk_collection.hpp"
+#include "duckdb/execution/join_filter.hpp"
 #include "duckdb/execution/join_hashtable.hpp"
 #include "duckdb/execution/operator/join/physical_comparison_join.hpp"
 #include "duckdb/execution/physical_operator.hpp"
+#include "duckdb/parallel/parallel_state.hpp"
 #include "duckdb/planner/operator/logical_join.hpp"
 
 namespace duckdb {
@@ -32,19 +34,68 @@ public:
 	vector<LogicalType> build_types;
 	//! Duplicate eliminated types; only used for delim_joins (i.e. correlated subqueries)
 	vector<LogicalType> delim_types;
+	//! The filters that are published to the table scans on the probe side once the build has finished
+	vector<unique_ptr<JoinFilter>> join_filters;
+	//! The range of the build keys [perfect_min, perfect_min + perfect_range) according to the statistics, if the HT
+	//! can be constructed as a perfect hash table (perfect_range is 0 otherwise)
+	int64_t perfect_min;
+	idx_t perfect_range;
+	//! The estimated cardinality of the probe side, used to detect at runtime that the build side was the larger input
+	idx_t probe_cardinality;
+
+	//! The minimum amount of HT blocks a finalize task inserts into the hash map
+	static constexpr idx_t MIN_FINALIZE_BLOCKS_PER_TASK = 4;
+	//! The maximum range of the build keys for which a perfect hash table is constructed
+	static constexpr idx_t MAX_PERFECT_HASH_RANGE = idx_t(1) << 24;
+	//! The build and probe sides of an inner join are swapped at runtime if the build side holds more than
+	//! SWAP_THRESHOLD times the estimated probe cardinality, and the actual probe side turns out to be that small too
+	static constexpr idx_t SWAP_THRESHOLD = 4;
+	//! The minimum size of the build side for which the sides are swapped
+	static constexpr idx_t MIN_SWAP_BUILD_COUNT = STANDARD_VECTOR_SIZE * 64;
 
 public:
+	string ParamsToString() const override;
+
 	unique_ptr<GlobalOperatorState> GetGlobalState(ClientContext &context) override;
 
 	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) override;
 	void Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input) override;
+	void Combine(ExecutionContext &context, GlobalOperatorState &gstate, LocalSinkState &lstate) override;
 	void Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> gstate) override;
 
 	void GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
 	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
 
+	//! Whether or not the HT can be probed by multiple threads. This is not the case if the build side turned out to be
+	//! much larger than estimated: the probe input is then collected first to decide which side to build the HT on.
+	bool ParallelProbe();
+	//! Whether or not the probe of the HT continues in phases after all threads have finished probing their input.
+	//! This is the case if the HT did not fit in memory (the buffered input of every other partition group is probed
+	//! once the group is pinned), and for RIGHT/FULL OUTER joins (the unmatched build rows are scanned at the end).
+	bool HasParallelPhases();
+	//! Returns the state shared by the threads that probe the HT in parallel
+	unique_ptr<ParallelState> GetParallelState();
+	//! Starts the next phase of the probe after all threads have finished the previous one, returns the amount of
+	//! threads the phase can be divided over, or 0 if there are no phases left
+	idx_t StartParallelPhase(ClientContext &context, ParallelState &state);
+
 private:
 	void ProbeHashTable(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_);
+	//! Fetches the next chunk of input that belongs to the currently pinned partition group of an external HT. If the
+	//! HT is probed in parallel, the input of the other groups is buffered in the parallel state.
+	void FetchExternalProbeChunk(ExecutionContext &context, PhysicalOperatorState *state_,
+	                             ParallelState *parallel_state);
+	//! Appends the buffered input chunk of the given partition group to the buffered input of the group
+	void AppendBufferedChunk(PhysicalOperatorState &state, ParallelState *parallel_state, idx_t group);
+	//! Fetches the next chunk of probe input: the input that was collected while deciding to swap comes first
+	void FetchProbeInput(ExecutionContext &context, PhysicalOperatorState *state_);
+	//! Collects the probe input of a join with a pending swap, and either builds a HT over it that the original build
+	//! side is probed with, or finalizes the original HT if the probe input is too large
+	void ResolveSwap(ExecutionContext &context, PhysicalOperatorState *state_);
+	//! Probes the swapped HT with the entries of the original HT
+	void ProbeSwappedHashTable(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state_);
+	//! Scans the unmatched build rows in the blocks of the HT that are assigned to this thread
+	void ScanParallelOuter(DataChunk &chunk, PhysicalOperatorState *state_, ParallelState &parallel_state);
 };
 
 } // namespace duckdb
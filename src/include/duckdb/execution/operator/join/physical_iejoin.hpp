@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// duckdb/execution/operator/join/physical_iejoin.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "duckdb/execution/operator/join/physical_comparison_join.hpp"
+
+namespace duckdb {
+
+//! PhysicalIEJoin represents a join on two inequality conditions (e.g. an interval overlap or a band join), evaluated
+//! with the IEJoin algorithm. The RHS is sorted on the first condition into blocks of STANDARD_VECTOR_SIZE rows that
+//! are stored in spillable sorted runs. Every LHS chunk is joined with the blocks one at a time: the rows of both sides
+//! are visited in the order of the second condition, and a bitmap over the first sort order of the block tracks the
+//! RHS rows that have been visited. The matches of an LHS row are then the bits set in the range of the block that
+//! satisfies the first condition.
+class PhysicalIEJoin : public PhysicalComparisonJoin {
+public:
+	PhysicalIEJoin(LogicalOperator &op, unique_ptr<PhysicalOperator> left, unique_ptr<PhysicalOperator> right,
+	               vector<JoinCondition> cond, JoinType join_type);
+
+	//! The types of the join keys
+	vector<LogicalType> join_key_types;
+	//! The types of the RHS columns that are part of the join result
+	vector<LogicalType> payload_types;
+
+	//! The amount of rows a thread collects before sorting them into a run
+	static constexpr idx_t IEJOIN_RUN_SIZE = STANDARD_VECTOR_SIZE * 64;
+
+public:
+	//! Whether or not a join with the given conditions can be evaluated by an IEJoin
+	static bool IsSupported(vector<JoinCondition> &conditions, JoinType join_type);
+
+	unique_ptr<GlobalOperatorState> GetGlobalState(ClientContext &context) override;
+	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) override;
+	void Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input) override;
+	void Combine(ExecutionContext &context, GlobalOperatorState &gstate, LocalSinkState &lstate) override;
+
+	void GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
+	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
+
+private:
+	// resolve joins that output max N elements (SEMI, ANTI)
+	void ResolveSimpleJoin(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state);
+	// resolve joins that can potentially output N*M elements (INNER, LEFT)
+	void ResolveComplexJoin(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state);
+};
+
+} // namespace duckdb
@@ -14,7 +14,8 @@
 namespace duckdb {
 
 //! PhysicalPiecewiseMergeJoin represents a piecewise merge loop join between
-//! two tables
+//! two tables. The threads of the RHS pipeline sort the RHS into runs that are offloaded when the memory limit is
+//! exceeded. Every chunk of a run is sorted, and every LHS chunk is merge joined with the chunks of the runs.
 class PhysicalPiecewiseMergeJoin : public PhysicalComparisonJoin {
 public:
 	PhysicalPiecewiseMergeJoin(LogicalOperator &op, unique_ptr<PhysicalOperator> left,
@@ -22,13 +23,20 @@ public:
 
 	vector<LogicalType> join_key_types;
 
+	//! The amount of rows a thread collects before sorting them into a run
+	static constexpr idx_t SORTED_RUN_SIZE = STANDARD_VECTOR_SIZE * 256;
+
 public:
 	unique_ptr<GlobalOperatorState> GetGlobalState(ClientContext &context) override;
 
 	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) override;
 	void Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input) override;
+	void Combine(ExecutionContext &context, GlobalOperatorState &gstate, LocalSinkState &lstate) override;
 	void Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> state) override;
 
+	//! Whether or not the LHS can be joined with the sorted RHS by multiple threads
+	bool ParallelProbe();
+
 	void GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
 	unique_ptr<PhysicalOperatorState> GetOperatorState() override;
 
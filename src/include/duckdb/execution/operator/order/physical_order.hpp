@@ -14,8 +14,9 @@
 
 namespace duckdb {
 
-//! Represents a physical ordering of the data. Note that this will not change
-//! the data but only add a selection vector.
+//! Represents a physical ordering of the data. Every thread sorts its input into sorted runs, which are stored in
+//! buffer-managed blocks (and can thus be offloaded to disk). The runs are then merged in parallel: in the final merge
+//! round, the key domain is split into ranges that are merged by separate tasks.
 class PhysicalOrder : public PhysicalSink {
 public:
 	PhysicalOrder(vector<LogicalType> types, vector<BoundOrderByNode> orders)
@@ -24,9 +25,20 @@ public:
 
 	vector<BoundOrderByNode> orders;
 
+	//! The amount of rows a thread collects before sorting them into a run
+	static constexpr idx_t SORTED_RUN_SIZE = STANDARD_VECTOR_SIZE * 256;
+	//! The maximum amount of runs that are merged by a single merge task
+	static constexpr idx_t SORTED_RUN_MERGE_FAN_IN = 8;
+	//! The minimum amount of rows per key range of the final merge round
+	static constexpr idx_t FINAL_MERGE_PARTITION_SIZE = STANDARD_VECTOR_SIZE * 64;
+	//! The amount of rows sampled per key range to pick the splitters of the final merge round
+	static constexpr idx_t FINAL_MERGE_SAMPLES = 16;
+
 public:
 	void Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input) override;
+	void Combine(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate) override;
 	void Finalize(Pipeline &pipeline, ClientContext &context, unique_ptr<GlobalOperatorState> state) override;
+	unique_ptr<LocalSinkState> GetLocalSinkState(ExecutionContext &context) override;
 	unique_ptr<GlobalOperatorState> GetGlobalState(ClientContext &context) override;
 
 	void GetChunkInternal(ExecutionContext &context, DataChunk &chunk, PhysicalOperatorState *state) override;
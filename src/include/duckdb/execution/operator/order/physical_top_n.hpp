@@ -9,13 +9,15 @@
 #pragma once
 
 #include "duckdb/common/types/chunk_collection.hpp"
+#include "duckdb/common/types/sort_key.hpp"
 #include "duckdb/execution/physical_sink.hpp"
 #include "duckdb/planner/bound_query_node.hpp"
 
 namespace duckdb {
 
 //! Represents a physical ordering of the data. Note that this will not change
-//! the data but only add a selection vector.
+//! the data but only add a selection vector. Every thread keeps the top N of its own input, and rows that sort after
+//! the last row of the top N of any thread are skipped.
 class PhysicalTopN : public PhysicalSink {
 public:
 	PhysicalTopN(vector<LogicalType> types, vector<BoundOrderByNode> orders, idx_t limit, idx_t offset)
@@ -26,6 +28,9 @@ public:
 	idx_t limit;
 	idx_t offset;
 
+	//! The minimum amount of rows the local data has to exceed the top N by before it is reduced to the top N
+	static constexpr idx_t TOP_N_COMPACT_THRESHOLD = STANDARD_VECTOR_SIZE * 8;
+
 public:
 	void Sink(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate, DataChunk &input) override;
 	void Combine(ExecutionContext &context, GlobalOperatorState &state, LocalSinkState &lstate) override;
@@ -38,8 +43,10 @@ public:
 
 	string ParamsToString() const override;
 
-private:
 	unique_ptr<idx_t[]> ComputeTopN(ChunkCollection &big_data, idx_t &heap_size);
+
+private:
+	SortKeyEncoder CreateSortKeyEncoder();
 };
 
 } // namespace duckdb
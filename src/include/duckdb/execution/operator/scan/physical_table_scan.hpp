@@ -14,6 +14,7 @@
 #include "duckdb/planner/table_filter.hpp"
 
 namespace duckdb {
+class JoinFilter;
 
 //! Represents a scan of a base table
 class PhysicalTableScan : public PhysicalOperator {
@@ -31,6 +32,8 @@ public:
 	vector<string> names;
 	//! The table filters
 	unique_ptr<TableFilterSet> table_filters;
+	//! The filters of hash joins on the scanned columns, these are owned by the joins and applied once published
+	vector<JoinFilter *> join_filters;
 
 public:
 	string GetName() const override;
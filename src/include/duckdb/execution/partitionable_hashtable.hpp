@@ -26,17 +26,35 @@ class PartitionableHashTable {
 public:
 	PartitionableHashTable(BufferManager &_buffer_manager, RadixPartitionInfo &_partition_info,
 	                       vector<LogicalType> _group_types, vector<LogicalType> _payload_types,
-	                       vector<BoundAggregateExpression *> _bindings);
+	                       vector<BoundAggregateExpression *> _bindings,
+	                       idx_t _max_ht_groups = NumericLimits<idx_t>::Maximum());
 
 	idx_t AddChunk(DataChunk &groups, DataChunk &payload, bool do_partition);
 	void Partition();
 	bool IsPartitioned();
+	//! Add an HT that was built elsewhere to the unpartitioned HTs
+	void AddHT(unique_ptr<GroupedAggregateHashTable> ht);
 
 	HashTableList GetPartition(idx_t partition);
 	HashTableList GetUnpartitioned();
 
+	//! Finalize all HTs; if the HT is external, also unpin them
 	void Finalize();
 
+	//! Whether or not full HTs are unpinned so they can be spilled to disk
+	bool IsExternal() {
+		return max_ht_groups != NumericLimits<idx_t>::Maximum();
+	}
+	//! Cap the amount of groups in a single HT, and finalize and unpin the current HTs so they can be spilled to disk
+	void SetMaxGroups(idx_t max_groups);
+	//! The amount of memory in bytes held by all HTs
+	idx_t SizeInBytes();
+
+	//! The amount of rows after which the reduction of the pre-aggregation is evaluated
+	static constexpr idx_t PRE_AGGREGATION_SAMPLE_SIZE = STANDARD_VECTOR_SIZE * 256;
+	//! If at least this fraction of the sampled rows created a new group, the pre-aggregation is skipped
+	static constexpr double PRE_AGGREGATION_SKIP_RATIO = 0.95;
+
 private:
 	BufferManager &buffer_manager;
 	vector<LogicalType> group_types;
@@ -45,6 +63,16 @@ private:
 
 	bool is_partitioned;
 	RadixPartitionInfo &partition_info;
+	//! The maximum amount of groups in a single HT before a new HT is started
+	idx_t max_ht_groups;
+	//! Whether or not the pre-aggregation can be skipped, i.e. there are no DISTINCT aggregates
+	bool can_skip_pre_aggregation;
+	//! Whether or not the rows are appended to the partitioned HTs as-is, because the pre-aggregation did not reduce
+	//! the amount of rows
+	bool skip_pre_aggregation;
+	//! The amount of rows that have been added, and the amount of groups they created
+	idx_t sampled_rows;
+	idx_t sampled_groups;
 	vector<SelectionVector> sel_vectors;
 	vector<idx_t> sel_vector_sizes;
 	DataChunk group_subset, payload_subset;
@@ -55,5 +83,9 @@ private:
 
 private:
 	idx_t ListAddChunk(HashTableList &list, DataChunk &groups, Vector &group_hashes, DataChunk &payload);
+	//! Decide whether or not to skip the pre-aggregation once enough rows have been sampled
+	void UpdatePreAggregation(idx_t rows, idx_t groups);
+	//! Finalize the HT and, if the HT is external, unpin it
+	void FinalizeHT(GroupedAggregateHashTable &ht);
 };
 } // namespace duckdb
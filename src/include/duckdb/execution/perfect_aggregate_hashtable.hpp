@@ -28,6 +28,10 @@ public:
 
 	//! Scan the HT starting from the scan_position
 	void Scan(idx_t &scan_position, DataChunk &result);
+	//! Scan the groups of the HT starting from the scan_position without finalizing their aggregates. The groups are
+	//! placed in the first columns of the result, and the state_addresses are set to their aggregate states. Returns
+	//! the amount of groups found.
+	idx_t ScanGroups(idx_t &scan_position, DataChunk &result, Vector &state_addresses);
 
 protected:
 	Vector addresses;
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//                         DuckDB
+//
+// duckdb/execution/sorted_run.hpp
+//
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "duckdb/common/common.hpp"
+#include "duckdb/common/enums/order_type.hpp"
+#include "duckdb/common/types/chunk_collection.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+namespace duckdb {
+class SortKeyEncoder;
+
+//! The sort order of a set of sorted runs. The sort keys are always the first columns of the chunks in a run.
+struct SortDescription {
+	vector<OrderType> order_types;
+	vector<OrderByNullType> null_orders;
+
+	idx_t KeyCount() const {
+		return order_types.size();
+	}
+};
+
+//! A position within a SortedRun: row row_idx of chunk chunk_idx
+struct SortedRunPosition {
+	idx_t chunk_idx;
+	idx_t row_idx;
+};
+
+//! A buffer-managed block holding a number of serialized chunks of a sorted run
+struct SortedRunBlock {
+	shared_ptr<BlockHandle> block;
+	//! The amount of bytes written to the block
+	idx_t size;
+	//! The amount of chunks stored in the block
+	idx_t chunk_count;
+	//! The offset of every chunk within the block
+	vector<idx_t> chunk_offsets;
+};
+
+//! A SortedRun is an ordered sequence of chunks. If all types of the run can be serialized the chunks are stored in
+//! buffer-managed blocks, which are offloaded to the temporary directory when the memory limit is exceeded. Otherwise
+//! the chunks are kept in memory.
+class SortedRun {
+	friend class SortedRunScanner;
+
+public:
+	SortedRun(BufferManager &buffer_manager, vector<LogicalType> types);
+
+	//! The types of the chunks in the run
+	vector<LogicalType> types;
+	//! The total amount of rows in the run
+	idx_t count;
+
+public:
+	//! Append a chunk to the end of the run. The chunk must follow the previously appended chunks in sort order.
+	void Append(DataChunk &chunk);
+	//! Finish writing the run, after this the run can only be scanned
+	void Finalize();
+
+	//! Sort the given collection on its first columns and write the result to a new run
+	static unique_ptr<SortedRun> CreateFromCollection(BufferManager &buffer_manager, ChunkCollection &collection,
+	                                                  SortDescription &desc);
+	//! Merge a set of runs into a single new run. The input runs are destroyed while merging.
+	static unique_ptr<SortedRun> Merge(BufferManager &buffer_manager, vector<unique_ptr<SortedRun>> runs,
+	                                   SortDescription &desc);
+	//! Merge the rows [begins[i], ends[i]) of every run i into a single new run. The input runs are not modified, so
+	//! disjoint ranges of the same runs can be merged in parallel.
+	static unique_ptr<SortedRun> MergeRanges(BufferManager &buffer_manager, vector<SortedRun *> &runs,
+	                                         vector<SortedRunPosition> &begins, vector<SortedRunPosition> &ends,
+	                                         SortDescription &desc);
+
+	//! The amount of chunks in the run
+	idx_t ChunkCount();
+	//! Returns, for every row of the splitters (which have the types of the run and are in sort order), the position of
+	//! the first row of the run that does not sort before it
+	vector<SortedRunPosition> LowerBounds(DataChunk &splitters, SortDescription &desc);
+
+	//! Whether or not chunks of the given types can be offloaded to disk
+	static bool CanSpill(vector<LogicalType> &types);
+
+private:
+	//! Returns the amount of bytes required to serialize the given chunk
+	idx_t GetSerializedSize(DataChunk &chunk);
+	void SerializeChunk(DataChunk &chunk, data_ptr_t target);
+
+private:
+	BufferManager &buffer_manager;
+	//! Whether or not the chunks are serialized into buffer-managed blocks
+	bool spillable;
+	//! The blocks of the run (if spillable)
+	vector<SortedRunBlock> blocks;
+	//! The block that is currently being written to
+	unique_ptr<BufferHandle> write_handle;
+	//! The capacity of the block that is currently being written to
+	idx_t write_capacity;
+	//! The chunks of the run (if not spillable)
+	ChunkCollection chunks;
+};
+
+//! The SortedRunScanner reads the chunks of a SortedRun in order
+class SortedRunScanner {
+public:
+	SortedRunScanner(SortedRun &run);
+
+	//! Scans the next chunk of the run into the result. The result is empty when the run is exhausted. The result stays
+	//! valid until the next call to Scan.
+	void Scan(DataChunk &result);
+	//! Positions the scanner so the next call to Scan returns the chunk with the given index in the run
+	void Seek(idx_t chunk_index);
+
+private:
+	void DeserializeChunk(DataChunk &result);
+
+private:
+	SortedRun &run;
+	//! The current block (or chunk if the run is not spillable)
+	idx_t block_idx;
+	//! The index of the next chunk within the current block
+	idx_t chunk_idx;
+	//! The read offset within the current block
+	idx_t offset;
+	//! The pin on the current block
+	unique_ptr<BufferHandle> read_handle;
+};
+
+} // namespace duckdb
@@ -20,13 +20,19 @@ public:
 	                  ChunkCollection *input);
 	~WindowSegmentTree();
 
-	Value Compute(idx_t start, idx_t end);
+	//! Computes the aggregate over the frames [begins[i], ends[i]) of count rows, and writes the results into the
+	//! (flat) result vector. Empty frames produce NULL.
+	void Compute(const idx_t begins[], const idx_t ends[], idx_t count, Vector &result);
 
 private:
 	void ConstructTree();
-	void WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end);
-	void AggregateInit();
-	Value AggegateFinal();
+	//! Aggregates the entries [begin, end) of level l_idx of the tree into the target state
+	void WindowSegmentValue(idx_t l_idx, idx_t begin, idx_t end, data_ptr_t target);
+	//! Aggregates the frame [begin, end) into the target state
+	void ComputeFrame(idx_t begin, idx_t end, data_ptr_t target);
+	//! Queues the combines of the nodes [begin, end) of level l_idx (> 0) of the tree into the target state
+	void QueueCombines(idx_t l_idx, idx_t begin, idx_t end, data_ptr_t target);
+	void FlushCombines();
 
 	//! The aggregate that the window function is computed over
 	AggregateFunction aggregate;
@@ -42,6 +48,15 @@ private:
 	//! A vector of pointers to "state", used for intermediate window segment aggregation
 	Vector statep;
 
+	//! The states of the frames computed by a call to Compute
+	unique_ptr<data_t[]> frame_states;
+	//! A vector of pointers to the frame states
+	Vector frame_statep;
+	//! The pending combines of tree nodes (sources) into frame states (targets)
+	Vector combine_sources;
+	Vector combine_targets;
+	idx_t combine_count;
+
 	//! The actual window segment tree: an array of aggregate states that represent all the intermediate nodes
 	unique_ptr<data_t[]> levels_flat_native;
 	//! For each level, the starting location in the levels_flat_native array
@@ -14,6 +14,12 @@
 
 namespace duckdb {
 
+struct ApproxCountDistinctFun {
+	static AggregateFunction GetFunction();
+
+	static void RegisterFunction(BuiltinFunctions &set);
+};
+
 struct BitAndFun {
 	static void RegisterFunction(BuiltinFunctions &set);
 };
@@ -17,6 +17,7 @@
 
 namespace duckdb {
 class Executor;
+class PhysicalHashJoin;
 class TaskContext;
 
 //! The Pipeline class represents an execution pipeline
@@ -94,6 +95,14 @@ private:
 	PhysicalOperator *parallel_node;
 	//! The parallel state (if any)
 	unique_ptr<ParallelState> parallel_state;
+	//! The hash joins that are probed in parallel and continue in phases once all threads have finished probing, from
+	//! the bottom of the pipeline up. Every phase of a join is executed by a new set of tasks once the previous tasks
+	//! have finished.
+	vector<PhysicalHashJoin *> phased_joins;
+	//! The parallel state of each of the phased joins
+	vector<unique_ptr<ParallelState>> phased_join_states;
+	//! The amount of phased joins of which all phases have been started
+	idx_t finished_phased_joins;
 
 	//! Whether or not the pipeline is finished executing
 	bool finished;
@@ -103,6 +112,8 @@ private:
 private:
 	void ScheduleSequentialTask();
 	bool ScheduleOperator(PhysicalOperator *op);
+	//! Schedules the tasks of the next phase of the phased joins, returns false if there are none
+	bool ScheduleJoinPhase();
 };
 
 } // namespace duckdb
@@ -12,6 +12,7 @@
 #include "duckdb/common/unordered_set.hpp"
 #include "duckdb/planner/joinside.hpp"
 #include "duckdb/planner/operator/logical_join.hpp"
+#include "duckdb/storage/statistics/base_statistics.hpp"
 
 namespace duckdb {
 
@@ -22,6 +23,9 @@ public:
 
 	//! The conditions of the join
 	vector<JoinCondition> conditions;
+	//! The statistics of the keys of the conditions, set by the StatisticsPropagator: the statistics of the left and
+	//! right key of condition i are join_stats[i * 2] and join_stats[i * 2 + 1] (nullptr if unknown)
+	vector<unique_ptr<BaseStatistics>> join_stats;
 
 public:
 	string ParamsToString() const override;
@@ -13,6 +13,7 @@
 #include "duckdb/common/unordered_map.hpp"
 
 namespace duckdb {
+class JoinFilter;
 
 //! TableFilter represents a filter pushed down into the table scan.
 struct TableFilter {
@@ -26,6 +27,8 @@ struct TableFilter {
 
 struct TableFilterSet {
 	unordered_map<idx_t, vector<TableFilter>> filters;
+	//! The Bloom filters of hash joins on the probe side keys, every filtered column also has regular filters
+	vector<JoinFilter *> join_filters;
 };
 
 } // namespace duckdb
@@ -53,6 +53,10 @@ public:
 	//! Set a new memory limit to the buffer manager, throws an exception if the new limit is too low and not enough
 	//! blocks can be evicted
 	void SetLimit(idx_t limit = (idx_t)-1);
+	//! Returns the maximum amount of memory that the buffer manager can keep (in bytes)
+	idx_t GetMaxMemory() {
+		return maximum_memory;
+	}
 
 	static BufferManager &GetBufferManager(ClientContext &context);
 
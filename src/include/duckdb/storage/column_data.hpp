@@ -69,6 +69,9 @@ public:
 	void Fetch(ColumnScanState &state, row_t row_id, Vector &result);
 	//! Fetch a specific row id and append it to the vector
 	void FetchRow(ColumnFetchState &state, Transaction &transaction, row_t row_id, Vector &result, idx_t result_idx);
+	//! Fetch a set of row ids and write them to the vector. Consecutive row ids that belong to the same segment are
+	//! fetched together, so sorting the row ids reduces the amount of segment lookups.
+	void FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count, Vector &result);
 
 private:
 	//! Append a transient segment
@@ -25,6 +25,9 @@ public:
 	//! Fetch a single value and append it to the vector
 	void FetchRow(ColumnFetchState &state, Transaction &transaction, row_t row_id, Vector &result,
 	              idx_t result_idx) override;
+	//! Fetch a set of values, pinning the block only once
+	void FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count, row_t row_offset,
+	               Vector &result, idx_t result_idx) override;
 
 	//! Append a part of a vector to the uncompressed segment with the given append state, updating the provided stats
 	//! in the process. Returns the amount of tuples appended. If this is less than `count`, the uncompressed segment is
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "duckdb/storage/statistics/base_statistics.hpp"
+#include "duckdb/common/types/hyperloglog.hpp"
 
 namespace duckdb {
 
@@ -29,6 +30,9 @@ public:
 	uint32_t max_string_length;
 	//! Whether or not the segment contains any big strings in overflow blocks
 	bool has_overflow_strings;
+	//! A sketch of the distinct strings that were added, nullptr if the amount of distinct strings is unknown. Only the
+	//! statistics of stored columns have a sketch; it includes strings that were since updated or deleted.
+	unique_ptr<HyperLogLog> distinct_sketch;
 
 public:
 	void Update(const string_t &value);
@@ -40,6 +44,8 @@ public:
 	void Verify(Vector &vector, idx_t count) override;
 
 	bool CheckZonemap(ExpressionType comparison_type, string value);
+	//! Returns whether the estimated amount of distinct strings is known and at most the given amount
+	bool HasAtMostDistinct(idx_t count) const;
 
 	string ToString() override;
 };
@@ -63,6 +63,10 @@ public:
 	//! Fetch a value of the specific row id and append it to the result
 	virtual void FetchRow(ColumnFetchState &state, Transaction &transaction, row_t row_id, Vector &result,
 	                      idx_t result_idx) = 0;
+	//! Fetch the values of a set of row ids that all belong to this segment, and write them to the result starting at
+	//! result_idx
+	virtual void FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+	                       Vector &result, idx_t result_idx) = 0;
 
 	//! Perform an update within the segment
 	virtual void Update(ColumnData &column_data, Transaction &transaction, Vector &updates, row_t *ids,
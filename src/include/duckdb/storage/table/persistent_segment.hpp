@@ -46,6 +46,9 @@ public:
 	//! Fetch a value of the specific row id and append it to the result
 	void FetchRow(ColumnFetchState &state, Transaction &transaction, row_t row_id, Vector &result,
 	              idx_t result_idx) override;
+	//! Fetch the values of a set of row ids within the segment
+	void FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count, Vector &result,
+	               idx_t result_idx) override;
 
 	//! Perform an update within the segment
 	void Update(ColumnData &column_data, Transaction &transaction, Vector &updates, row_t *ids, idx_t count) override;
@@ -69,6 +69,10 @@ public:
 	//! Fetch a single value and append it to the vector
 	virtual void FetchRow(ColumnFetchState &state, Transaction &transaction, row_t row_id, Vector &result,
 	                      idx_t result_idx) = 0;
+	//! Fetch the values of a set of rows (with the row ids offset by row_offset) and write them to the vector starting
+	//! at result_idx
+	virtual void FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+	                       row_t row_offset, Vector &result, idx_t result_idx);
 
 	//! Append a part of a vector to the uncompressed segment with the given append state, updating the provided stats
 	//! in the process. Returns the amount of tuples appended. If this is less than `count`, the uncompressed segment is
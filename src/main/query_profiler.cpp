@@ -6,6 +6,7 @@
 #include "duckdb/execution/physical_operator.hpp"
 #include "duckdb/execution/operator/join/physical_delim_join.hpp"
 #include "duckdb/execution/operator/helper/physical_execute.hpp"
+#include "duckdb/execution/operator/aggregate/physical_perfecthash_aggregate.hpp"
 #include "duckdb/common/tree_renderer.hpp"
 #include "duckdb/parser/sql_statement.hpp"
 #include "duckdb/common/printer.hpp"
@@ -41,6 +42,7 @@ bool QueryProfiler::OperatorRequiresProfiling(PhysicalOperatorType op_type) {
 	case PhysicalOperatorType::TOP_N:
 	case PhysicalOperatorType::AGGREGATE:
 	case PhysicalOperatorType::WINDOW:
+	case PhysicalOperatorType::STREAMING_WINDOW:
 	case PhysicalOperatorType::UNNEST:
 	case PhysicalOperatorType::SIMPLE_AGGREGATE:
 	case PhysicalOperatorType::HASH_GROUP_BY:
@@ -59,6 +61,7 @@ bool QueryProfiler::OperatorRequiresProfiling(PhysicalOperatorType op_type) {
 	case PhysicalOperatorType::HASH_JOIN:
 	case PhysicalOperatorType::CROSS_PRODUCT:
 	case PhysicalOperatorType::PIECEWISE_MERGE_JOIN:
+	case PhysicalOperatorType::IE_JOIN:
 	case PhysicalOperatorType::DELIM_JOIN:
 	case PhysicalOperatorType::UNION:
 	case PhysicalOperatorType::RECURSIVE_CTE:
@@ -420,6 +423,14 @@ unique_ptr<QueryProfiler::TreeNode> QueryProfiler::CreateTree(PhysicalOperator *
 		node->children.push_back(move(child_node));
 		break;
 	}
+	case PhysicalOperatorType::PERFECT_HASH_GROUP_BY: {
+		auto &perfect_aggregate = (PhysicalPerfectHashAggregate &)*root;
+		if (perfect_aggregate.overflow_aggregate) {
+			auto child_node = CreateTree((PhysicalOperator *)perfect_aggregate.overflow_aggregate.get(), depth + 1);
+			node->children.push_back(move(child_node));
+		}
+		break;
+	}
 	default:
 		break;
 	}
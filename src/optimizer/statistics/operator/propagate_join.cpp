@@ -8,10 +8,15 @@
 namespace duckdb {
 
 void StatisticsPropagator::PropagateStatistics(LogicalComparisonJoin &join, unique_ptr<LogicalOperator> *node_ptr) {
+	join.join_stats.clear();
 	for (idx_t i = 0; i < join.conditions.size(); i++) {
 		auto &condition = join.conditions[i];
 		auto stats_left = PropagateExpression(condition.left);
 		auto stats_right = PropagateExpression(condition.right);
+		// keep the statistics of the keys before they are narrowed down by the join, the physical planner uses them to
+		// select the join algorithm
+		join.join_stats.push_back(stats_left ? stats_left->Copy() : nullptr);
+		join.join_stats.push_back(stats_right ? stats_right->Copy() : nullptr);
 		if (stats_left && stats_right) {
 			if (condition.null_values_are_equal && stats_left->has_null && stats_right->has_null) {
 				// null values are equal in this join, and both sides can have null values
@@ -53,6 +58,7 @@ void StatisticsPropagator::PropagateStatistics(LogicalComparisonJoin &join, uniq
 				if (join.conditions.size() > 1) {
 					// there are multiple conditions: erase this condition
 					join.conditions.erase(join.conditions.begin() + i);
+					join.join_stats.erase(join.join_stats.begin() + i * 2, join.join_stats.begin() + i * 2 + 2);
 					i--;
 					continue;
 				} else {
@@ -11,6 +11,8 @@
 #include "duckdb/execution/operator/aggregate/physical_simple_aggregate.hpp"
 #include "duckdb/execution/operator/scan/physical_table_scan.hpp"
 #include "duckdb/execution/operator/aggregate/physical_hash_aggregate.hpp"
+#include "duckdb/execution/operator/join/physical_hash_join.hpp"
+#include "duckdb/execution/operator/join/physical_piecewise_merge_join.hpp"
 
 namespace duckdb {
 
@@ -30,8 +32,8 @@ public:
 };
 
 Pipeline::Pipeline(Executor &executor_, ProducerToken &token_)
-    : executor(executor_), token(token_), finished_tasks(0), total_tasks(0), finished_dependencies(0), finished(false),
-      recursive_cte(nullptr) {
+    : executor(executor_), token(token_), finished_tasks(0), total_tasks(0), finished_dependencies(0),
+      finished_phased_joins(0), finished(false), recursive_cte(nullptr) {
 }
 
 void Pipeline::Execute(TaskContext &task) {
@@ -42,6 +44,9 @@ void Pipeline::Execute(TaskContext &task) {
 	if (parallel_state) {
 		task.task_info[parallel_node] = parallel_state.get();
 	}
+	for (idx_t i = 0; i < phased_joins.size(); i++) {
+		task.task_info[phased_joins[i]] = phased_join_states[i].get();
+	}
 
 	ThreadContext thread(client);
 	ExecutionContext context(client, thread, task);
@@ -73,6 +78,10 @@ void Pipeline::FinishTask() {
 	D_ASSERT(finished_tasks < total_tasks);
 	idx_t current_finished = ++finished_tasks;
 	if (current_finished == total_tasks) {
+		if (ScheduleJoinPhase()) {
+			// the phases of the joins are executed before the sink is finalized
+			return;
+		}
 		try {
 			sink->Finalize(*this, executor.context, move(sink_state));
 		} catch (std::exception &ex) {
@@ -86,6 +95,29 @@ void Pipeline::FinishTask() {
 	}
 }
 
+bool Pipeline::ScheduleJoinPhase() {
+	if (executor.context.interrupted) {
+		return false;
+	}
+	while (finished_phased_joins < phased_joins.size()) {
+		auto &join = *phased_joins[finished_phased_joins];
+		auto &join_state = *phased_join_states[finished_phased_joins];
+		// all tasks have finished, so every thread has finished the previous phase
+		idx_t task_count = join.StartParallelPhase(executor.context, join_state);
+		if (task_count == 0) {
+			finished_phased_joins++;
+			continue;
+		}
+		auto &scheduler = TaskScheduler::GetScheduler(executor.context);
+		total_tasks += task_count;
+		for (idx_t i = 0; i < task_count; i++) {
+			scheduler.ScheduleTask(token, make_unique<PipelineTask>(this));
+		}
+		return true;
+	}
+	return false;
+}
+
 void Pipeline::ScheduleSequentialTask() {
 	auto &scheduler = TaskScheduler::GetScheduler(executor.context);
 	auto task = make_unique<PipelineTask>(this);
@@ -99,11 +131,36 @@ bool Pipeline::ScheduleOperator(PhysicalOperator *op) {
 	case PhysicalOperatorType::UNNEST:
 	case PhysicalOperatorType::FILTER:
 	case PhysicalOperatorType::PROJECTION:
-	case PhysicalOperatorType::HASH_JOIN:
 	case PhysicalOperatorType::CROSS_PRODUCT:
 	case PhysicalOperatorType::STREAMING_SAMPLE:
-		// filter, projection or hash probe: continue in children
+		// filter, projection or cross product: continue in children
+		return ScheduleOperator(op->children[0].get());
+	case PhysicalOperatorType::IE_JOIN:
+		// the sorted runs of the RHS are read-only: every thread joins its own LHS chunks with them
+		return ScheduleOperator(op->children[0].get());
+	case PhysicalOperatorType::PIECEWISE_MERGE_JOIN: {
+		auto &merge_join = (PhysicalPiecewiseMergeJoin &)*op;
+		if (!merge_join.ParallelProbe()) {
+			// the unmatched RHS rows are output at the end of the probe: it has to be performed by a single thread
+			return false;
+		}
 		return ScheduleOperator(op->children[0].get());
+	}
+	case PhysicalOperatorType::HASH_JOIN: {
+		auto &hash_join = (PhysicalHashJoin &)*op;
+		if (!hash_join.ParallelProbe()) {
+			// the probe input has to be collected to decide on the build side: it has to be performed by a single thread
+			return false;
+		}
+		if (hash_join.HasParallelPhases()) {
+			// the buffered input of an external HT and the unmatched build rows are probed and scanned once all threads
+			// have finished probing their input. The joins further down the pipeline are added in front, so that their
+			// phases come first: the output of these phases still has to pass through the joins above them.
+			phased_joins.insert(phased_joins.begin(), &hash_join);
+			phased_join_states.insert(phased_join_states.begin(), hash_join.GetParallelState());
+		}
+		return ScheduleOperator(op->children[0].get());
+	}
 	case PhysicalOperatorType::TABLE_SCAN: {
 		// we reached a scan: split it up into parts and schedule the parts
 		auto &scheduler = TaskScheduler::GetScheduler(executor.context);
@@ -134,8 +191,24 @@ bool Pipeline::ScheduleOperator(PhysicalOperator *op) {
 		return true;
 	}
 	case PhysicalOperatorType::HASH_GROUP_BY: {
-		// FIXME: parallelize scan of GROUP_BY HT
-		return false;
+		// the finalized HTs of the aggregate are scanned in parallel: every task fetches one block of groups at a time
+		auto &scheduler = TaskScheduler::GetScheduler(executor.context);
+		auto &hash_aggr = (PhysicalHashAggregate &)*op;
+		idx_t max_threads = hash_aggr.MaxThreads(executor.context);
+		if (max_threads <= 1) {
+			// too few groups to parallelize
+			return false;
+		}
+		this->parallel_state = hash_aggr.GetParallelState();
+		this->parallel_node = op;
+
+		// launch a task for every thread
+		this->total_tasks = max_threads;
+		for (idx_t i = 0; i < max_threads; i++) {
+			auto task = make_unique<PipelineTask>(this);
+			scheduler.ScheduleTask(*executor.producer, move(task));
+		}
+		return true;
 	}
 	default:
 		// unknown operator: skip parallel task scheduling
@@ -165,6 +238,9 @@ void Pipeline::Schedule() {
 	D_ASSERT(finished_tasks == 0);
 	D_ASSERT(total_tasks == 0);
 	D_ASSERT(finished_dependencies == dependencies.size());
+	phased_joins.clear();
+	phased_join_states.clear();
+	finished_phased_joins = 0;
 	// check if we can parallelize this task based on the sink
 	switch (sink->type) {
 	case PhysicalOperatorType::SIMPLE_AGGREGATE: {
@@ -204,7 +280,9 @@ void Pipeline::Schedule() {
 		break;
 	}
 	case PhysicalOperatorType::CROSS_PRODUCT:
-	case PhysicalOperatorType::HASH_JOIN: {
+	case PhysicalOperatorType::HASH_JOIN:
+	case PhysicalOperatorType::PIECEWISE_MERGE_JOIN:
+	case PhysicalOperatorType::IE_JOIN: {
 		// schedule build side of the join
 		if (ScheduleOperator(sink->children[1].get())) {
 			// all parallel tasks have been scheduled: return
@@ -224,6 +302,9 @@ void Pipeline::Schedule() {
 		break;
 	}
 	// could not parallelize this pipeline: push a sequential task instead
+	// the phased joins that were encountered are probed by the single task as well
+	phased_joins.clear();
+	phased_join_states.clear();
 	ScheduleSequentialTask();
 }
 
@@ -249,7 +330,10 @@ void Pipeline::Finish() {
 		// mark a dependency as completed for each of the parents
 		parent->CompleteDependency();
 	}
-	executor.completed_pipelines++;
+	if (!recursive_cte) {
+		// the pipelines of a recursive CTE are executed by the CTE, and are not counted by the executor
+		executor.completed_pipelines++;
+	}
 }
 
 string Pipeline::ToString() const {
@@ -59,7 +59,7 @@ unique_ptr<Expression> BoundAggregateExpression::Copy() {
 	for (auto &child : children) {
 		new_children.push_back(child->Copy());
 	}
-	auto new_bind_info = bind_info->Copy();
+	auto new_bind_info = bind_info ? bind_info->Copy() : nullptr;
 	auto copy = make_unique<BoundAggregateExpression>(function, move(new_children), move(new_bind_info), distinct);
 	copy->CopyProperties(*this);
 	return move(copy);
@@ -193,6 +193,22 @@ void ColumnData::FetchRow(ColumnFetchState &state, Transaction &transaction, row
 	segment->FetchRow(state, transaction, row_id, result, result_idx);
 }
 
+void ColumnData::FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+                           Vector &result) {
+	idx_t start = 0;
+	while (start < count) {
+		// find the segment the row belongs to, and the rows after it that belong to the same segment
+		auto segment = (ColumnSegment *)data.GetSegment(row_ids[start]);
+		idx_t end = start + 1;
+		while (end < count && (idx_t)row_ids[end] >= segment->start &&
+		       (idx_t)row_ids[end] < segment->start + segment->count) {
+			end++;
+		}
+		segment->FetchRows(state, transaction, row_ids + start, end - start, result, start);
+		start = end;
+	}
+}
+
 void ColumnData::AppendTransientSegment(idx_t start_row) {
 	auto new_segment = make_unique<TransientSegment>(manager, type, start_row);
 	data.AppendSegment(move(new_segment));
@@ -5,6 +5,7 @@
 #include "duckdb/common/helper.hpp"
 #include "duckdb/common/vector_operations/vector_operations.hpp"
 #include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/join_filter.hpp"
 #include "duckdb/planner/constraints/list.hpp"
 #include "duckdb/transaction/transaction.hpp"
 #include "duckdb/transaction/transaction_manager.hpp"
@@ -43,6 +44,7 @@ DataTable::DataTable(StorageManager &storage, string schema, string table, vecto
 			}
 		}
 		total_rows = columns[0]->persistent_rows;
+		info->cardinality = total_rows;
 		// create empty morsel info's
 		// in the future, we should lazily load these from the file as well (once we support deleted flags)
 		for (idx_t i = 0; i < total_rows; i += MorselInfo::MORSEL_SIZE) {
@@ -314,23 +316,20 @@ bool DataTable::CheckZonemap(TableScanState &state, TableFilterSet *table_filter
 		return true;
 	}
 	for (auto &table_filter : table_filters->filters) {
+		auto &column_scan = state.column_scans[table_filter.first];
+		if (column_scan.segment_checked) {
+			continue;
+		}
+		column_scan.segment_checked = true;
+		if (!column_scan.current) {
+			return true;
+		}
 		for (auto &predicate_constant : table_filter.second) {
-			bool readSegment = true;
-
-			if (!state.column_scans[predicate_constant.column_index].segment_checked) {
-				state.column_scans[predicate_constant.column_index].segment_checked = true;
-				if (!state.column_scans[predicate_constant.column_index].current) {
-					return true;
-				}
-				readSegment =
-				    state.column_scans[predicate_constant.column_index].current->stats.CheckZonemap(predicate_constant);
-			}
+			bool readSegment = column_scan.current->stats.CheckZonemap(predicate_constant);
 			if (!readSegment) {
 				//! We can skip this partition
-				idx_t vectorsToSkip =
-				    ceil((double)(state.column_scans[predicate_constant.column_index].current->count +
-				                  state.column_scans[predicate_constant.column_index].current->start - current_row) /
-				         STANDARD_VECTOR_SIZE);
+				idx_t vectorsToSkip = ceil(
+				    (double)(column_scan.current->count + column_scan.current->start - current_row) / STANDARD_VECTOR_SIZE);
 				for (idx_t i = 0; i < vectorsToSkip; ++i) {
 					state.NextVector();
 					current_row += STANDARD_VECTOR_SIZE;
@@ -400,6 +399,11 @@ bool DataTable::ScanBaseTable(Transaction &transaction, DataChunk &result, Table
 				columns[col_idx]->Select(transaction, state.column_scans[tf_idx], result.data[tf_idx], sel,
 				                         approved_tuple_count, state.table_filters->filters[tf_idx]);
 			}
+			//! The columns of the join filters have been fetched above: prune the rows that cannot find a join partner
+			for (auto join_filter : state.table_filters->join_filters) {
+				approved_tuple_count =
+				    join_filter->Select(result.data[join_filter->column_index], sel, approved_tuple_count);
+			}
 			for (auto &table_filter : state.table_filters->filters) {
 				result.data[table_filter.first].Slice(sel, approved_tuple_count);
 			}
@@ -459,10 +463,7 @@ void DataTable::Fetch(Transaction &transaction, DataChunk &result, vector<column
 			}
 		} else {
 			// regular column: fetch data from the base column
-			for (idx_t i = 0; i < count; i++) {
-				auto row_id = rows[i];
-				columns[column]->FetchRow(state, transaction, row_id, result.data[col_idx], i);
-			}
+			columns[column]->FetchRows(state, transaction, rows, count, result.data[col_idx]);
 		}
 	}
 }
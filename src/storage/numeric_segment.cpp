@@ -415,6 +415,30 @@ void NumericSegment::FetchRow(ColumnFetchState &state, Transaction &transaction,
 	}
 }
 
+void NumericSegment::FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+                               row_t row_offset, Vector &result, idx_t result_idx) {
+	auto read_lock = lock.GetSharedLock();
+	auto handle = manager.Pin(block);
+
+	auto result_data = FlatVector::GetData(result);
+	auto &result_mask = FlatVector::Nullmask(result);
+	for (idx_t i = 0; i < count; i++) {
+		idx_t row_id = row_ids[i] - row_offset;
+		idx_t vector_index = row_id / STANDARD_VECTOR_SIZE;
+		idx_t id_in_vector = row_id - vector_index * STANDARD_VECTOR_SIZE;
+		D_ASSERT(vector_index < max_vector_count);
+
+		auto data = handle->node->buffer + vector_index * vector_size;
+		auto &nullmask = *((nullmask_t *)(data));
+		auto vector_ptr = data + sizeof(nullmask_t);
+		result_mask[result_idx + i] = nullmask[id_in_vector];
+		memcpy(result_data + (result_idx + i) * type_size, vector_ptr + id_in_vector * type_size, type_size);
+		if (versions && versions[vector_index]) {
+			append_from_update_info(transaction, versions[vector_index], id_in_vector, result, result_idx + i);
+		}
+	}
+}
+
 //===--------------------------------------------------------------------===//
 // Append
 //===--------------------------------------------------------------------===//
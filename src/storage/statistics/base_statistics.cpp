@@ -28,8 +28,14 @@ unique_ptr<BaseStatistics> BaseStatistics::CreateEmpty(LogicalType type) {
 	case PhysicalType::FLOAT:
 	case PhysicalType::DOUBLE:
 		return make_unique<NumericStatistics>(type);
-	case PhysicalType::VARCHAR:
-		return make_unique<StringStatistics>(type);
+	case PhysicalType::VARCHAR: {
+		// the statistics of stored columns keep track of the amount of distinct strings. Every appended string is added
+		// to the sketch, so it is dense from the start
+		auto result = make_unique<StringStatistics>(type);
+		result->distinct_sketch = make_unique<HyperLogLog>();
+		result->distinct_sketch->ToDense();
+		return move(result);
+	}
 	case PhysicalType::INTERVAL:
 		return make_unique<BaseStatistics>(type);
 	default:
@@ -3,6 +3,7 @@
 #include "utf8proc_wrapper.hpp"
 #include "duckdb/common/string_util.hpp"
 #include "duckdb/common/types/vector.hpp"
+#include "duckdb/common/types/hash.hpp"
 
 namespace duckdb {
 
@@ -24,6 +25,9 @@ unique_ptr<BaseStatistics> StringStatistics::Copy() {
 	stats->max_string_length = max_string_length;
 	stats->max_string_length = max_string_length;
 	stats->has_null = has_null;
+	if (distinct_sketch) {
+		stats->distinct_sketch = make_unique<HyperLogLog>(*distinct_sketch);
+	}
 	return move(stats);
 }
 
@@ -34,6 +38,10 @@ void StringStatistics::Serialize(Serializer &serializer) {
 	serializer.Write<bool>(has_unicode);
 	serializer.Write<uint32_t>(max_string_length);
 	serializer.Write<bool>(has_overflow_strings);
+	serializer.Write<bool>(distinct_sketch != nullptr);
+	if (distinct_sketch) {
+		distinct_sketch->Serialize(serializer);
+	}
 }
 
 unique_ptr<BaseStatistics> StringStatistics::Deserialize(Deserializer &source, LogicalType type) {
@@ -43,6 +51,9 @@ unique_ptr<BaseStatistics> StringStatistics::Deserialize(Deserializer &source, L
 	stats->has_unicode = source.Read<bool>();
 	stats->max_string_length = source.Read<uint32_t>();
 	stats->has_overflow_strings = source.Read<bool>();
+	if (source.Read<bool>()) {
+		stats->distinct_sketch = HyperLogLog::Deserialize(source);
+	}
 	return move(stats);
 }
 
@@ -80,6 +91,9 @@ void StringStatistics::Update(const string_t &value) {
 	if (size > max_string_length) {
 		max_string_length = size;
 	}
+	if (distinct_sketch) {
+		distinct_sketch->Add(Hash<string_t>(value));
+	}
 	if (type.id() == LogicalTypeId::VARCHAR && !has_unicode) {
 		auto unicode = Utf8Proc::Analyze((const char *)data, size);
 		if (unicode == UnicodeType::UNICODE) {
@@ -102,6 +116,16 @@ void StringStatistics::Merge(const BaseStatistics &other_) {
 	has_unicode = has_unicode || other.has_unicode;
 	max_string_length = MaxValue<uint32_t>(max_string_length, other.max_string_length);
 	has_overflow_strings = has_overflow_strings || other.has_overflow_strings;
+	if (distinct_sketch && other.distinct_sketch) {
+		distinct_sketch->Merge(*other.distinct_sketch);
+	} else {
+		// the distinct strings of the other statistics are unknown
+		distinct_sketch.reset();
+	}
+}
+
+bool StringStatistics::HasAtMostDistinct(idx_t count) const {
+	return distinct_sketch && distinct_sketch->Count() <= count;
 }
 
 bool StringStatistics::CheckZonemap(ExpressionType comparison_type, string constant) {
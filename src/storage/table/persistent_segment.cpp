@@ -56,6 +56,11 @@ void PersistentSegment::FetchRow(ColumnFetchState &state, Transaction &transacti
 	data->FetchRow(state, transaction, row_id - this->start, result, result_idx);
 }
 
+void PersistentSegment::FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+                                  Vector &result, idx_t result_idx) {
+	data->FetchRows(state, transaction, row_ids, count, this->start, result, result_idx);
+}
+
 void PersistentSegment::Update(ColumnData &column_data, Transaction &transaction, Vector &updates, row_t *ids,
                                idx_t count) {
 	// update of persistent segment: check if the table has been updated before
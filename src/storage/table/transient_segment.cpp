@@ -60,6 +60,11 @@ void TransientSegment::FetchRow(ColumnFetchState &state, Transaction &transactio
 	data->FetchRow(state, transaction, row_id - this->start, result, result_idx);
 }
 
+void TransientSegment::FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+                                 Vector &result, idx_t result_idx) {
+	data->FetchRows(state, transaction, row_ids, count, this->start, result, result_idx);
+}
+
 void TransientSegment::Update(ColumnData &column_data, Transaction &transaction, Vector &updates, row_t *ids,
                               idx_t count) {
 	data->Update(column_data, stats, transaction, updates, ids, count, this->start);
@@ -137,6 +137,13 @@ void UncompressedSegment::Fetch(ColumnScanState &state, idx_t vector_index, Vect
 	FetchBaseData(state, vector_index, result);
 }
 
+void UncompressedSegment::FetchRows(ColumnFetchState &state, Transaction &transaction, row_t row_ids[], idx_t count,
+                                    row_t row_offset, Vector &result, idx_t result_idx) {
+	for (idx_t i = 0; i < count; i++) {
+		FetchRow(state, transaction, row_ids[i] - row_offset, result, result_idx + i);
+	}
+}
+
 //===--------------------------------------------------------------------===//
 // Filter
 //===--------------------------------------------------------------------===//
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/join_hashtable.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test that the join HT tags of short string keys filter chains", "[join]") {
+	if (JoinHashTable::HashTag(0) == 0) {
+		// pointers are not tagged on this platform
+		return;
+	}
+	const idx_t key_count = 1000;
+
+	// compute the tags of short strings (the hashes of these hardly use the upper bits)
+	vector<uintptr_t> tags;
+	for (idx_t offset = 0; offset < key_count; offset += STANDARD_VECTOR_SIZE) {
+		idx_t count = MinValue<idx_t>(STANDARD_VECTOR_SIZE, key_count - offset);
+		Vector keys(LogicalType::VARCHAR);
+		auto key_data = FlatVector::GetData<string_t>(keys);
+		for (idx_t i = 0; i < count; i++) {
+			key_data[i] = StringVector::AddString(keys, "k" + to_string(offset + i));
+		}
+		Vector hashes(LogicalType::HASH);
+		VectorOperations::Hash(keys, hashes, count);
+		hashes.Normalify(count);
+		auto hash_data = FlatVector::GetData<hash_t>(hashes);
+		for (idx_t i = 0; i < count; i++) {
+			tags.push_back(JoinHashTable::HashTag(hash_data[i]));
+		}
+	}
+	// every one of the 16 tags is used
+	uintptr_t all_tags = 0;
+	for (auto tag : tags) {
+		all_tags |= tag;
+	}
+	REQUIRE(all_tags == ~(~uintptr_t(0) >> 16));
+
+	// a chain that holds the first key rejects most probes for the other keys
+	uint8_t entry;
+	uintptr_t chain = (uintptr_t)&entry | tags[0];
+	idx_t rejected = 0;
+	for (idx_t i = 1; i < tags.size(); i++) {
+		auto result = JoinHashTable::FollowPointer(chain, tags[i]);
+		if (!result) {
+			rejected++;
+		} else {
+			REQUIRE(result == (data_ptr_t)&entry);
+		}
+	}
+	REQUIRE(rejected > key_count / 2);
+}
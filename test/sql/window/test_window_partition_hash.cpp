@@ -0,0 +1,36 @@
+#include "catch.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/operator/aggregate/physical_window.hpp"
+
+using namespace duckdb;
+using namespace std;
+
+TEST_CASE("Test that short string PARTITION BY keys spread across window partitions", "[window]") {
+	const idx_t partition_count = idx_t(1) << PhysicalWindow::WINDOW_RADIX_BITS;
+	const idx_t key_count = 1000;
+
+	vector<idx_t> partition_sizes(partition_count, 0);
+	for (idx_t offset = 0; offset < key_count; offset += STANDARD_VECTOR_SIZE) {
+		idx_t count = MinValue<idx_t>(STANDARD_VECTOR_SIZE, key_count - offset);
+		// hash a vector of short strings (the hashes of these hardly use the upper bits)
+		Vector keys(LogicalType::VARCHAR);
+		auto key_data = FlatVector::GetData<string_t>(keys);
+		for (idx_t i = 0; i < count; i++) {
+			key_data[i] = StringVector::AddString(keys, "k" + to_string(offset + i));
+		}
+		Vector hashes(LogicalType::HASH);
+		VectorOperations::Hash(keys, hashes, count);
+		hashes.Normalify(count);
+		auto hash_data = FlatVector::GetData<hash_t>(hashes);
+		for (idx_t i = 0; i < count; i++) {
+			auto partition_idx = PhysicalWindow::GetPartition(hash_data[i]);
+			REQUIRE(partition_idx < partition_count);
+			partition_sizes[partition_idx]++;
+		}
+	}
+	// every partition gets some of the keys, and no partition gets the bulk of them
+	for (idx_t partition_idx = 0; partition_idx < partition_count; partition_idx++) {
+		REQUIRE(partition_sizes[partition_idx] > 0);
+		REQUIRE(partition_sizes[partition_idx] < key_count / 4);
+	}
+}